@@ -26,6 +26,7 @@
 
 #include "opl.h"
 #include "opl_internal.h"
+#include "opl_queue.h"
 
 extern int english_language;
 
@@ -62,6 +63,13 @@ static int init_stage_reg_writes = 1;
 
 unsigned int opl_sample_rate = 22050;
 
+// [JN] Capture being recorded, its callback queue and current time.
+
+static opl_capture_t *capture = NULL;
+static opl_callback_queue_t *capture_queue = NULL;
+static uint64_t capture_time;
+static int capture_failed;
+
 //
 // Init/shutdown code.
 //
@@ -251,6 +259,35 @@ void OPL_WriteRegister(int reg, int value)
 {
     int i;
 
+    if (capture != NULL)
+    {
+        opl_reg_write_t *write;
+
+        if (capture->num_writes == capture->max_writes)
+        {
+            unsigned int max_writes = capture->max_writes ?
+                                      capture->max_writes * 2 : 4096;
+
+            write = realloc(capture->writes, max_writes * sizeof(*write));
+
+            if (write == NULL)
+            {
+                capture_failed = 1;
+                return;
+            }
+
+            capture->writes = write;
+            capture->max_writes = max_writes;
+        }
+
+        write = &capture->writes[capture->num_writes++];
+        write->time = (uint32_t) capture_time;
+        write->reg = reg;
+        write->value = value;
+        write->unused = 0;
+        return;
+    }
+
     if (reg & 0x100)
     {
         OPL_WritePort(OPL_REGISTER_PORT_OPL3, reg);
@@ -433,7 +470,11 @@ void OPL_InitRegisters(int opl3)
 
 void OPL_SetCallback(uint64_t us, opl_callback_t callback, void *data)
 {
-    if (driver != NULL)
+    if (capture != NULL)
+    {
+        OPL_Queue_Push(capture_queue, callback, data, capture_time + us);
+    }
+    else if (driver != NULL)
     {
         driver->set_callback_func(us, callback, data);
     }
@@ -441,7 +482,11 @@ void OPL_SetCallback(uint64_t us, opl_callback_t callback, void *data)
 
 void OPL_ClearCallbacks(void)
 {
-    if (driver != NULL)
+    if (capture != NULL)
+    {
+        OPL_Queue_Clear(capture_queue);
+    }
+    else if (driver != NULL)
     {
         driver->clear_callbacks_func();
     }
@@ -528,9 +573,94 @@ void OPL_SetPaused(int paused)
 
 void OPL_AdjustCallbacks(float value)
 {
-    if (driver != NULL)
+    if (capture != NULL)
+    {
+        OPL_Queue_AdjustCallbacks(capture_queue, capture_time, value);
+    }
+    else if (driver != NULL)
     {
         driver->adjust_callbacks_func(value);
     }
 }
 
+//
+// [JN] Offline rendering.
+//
+
+void OPL_StartCapture(opl_capture_t *_capture)
+{
+    _capture->writes = NULL;
+    _capture->num_writes = 0;
+    _capture->max_writes = 0;
+    _capture->length = 0;
+
+    if (capture_queue == NULL)
+    {
+        capture_queue = OPL_Queue_Create();
+    }
+
+    OPL_Queue_Clear(capture_queue);
+    capture_time = 0;
+    capture_failed = 0;
+    capture = _capture;
+}
+
+int OPL_RunCapture(uint64_t max_time)
+{
+    opl_callback_t callback;
+    void *callback_data;
+
+    while (!capture_failed && !OPL_Queue_IsEmpty(capture_queue))
+    {
+        if (OPL_Queue_Peek(capture_queue) > max_time)
+        {
+            return 0;
+        }
+
+        capture_time = OPL_Queue_Peek(capture_queue);
+        capture->length = (uint32_t) capture_time;
+
+        if (!OPL_Queue_Pop(capture_queue, &callback, &callback_data))
+        {
+            break;
+        }
+
+        callback(callback_data);
+    }
+
+    return !capture_failed;
+}
+
+void OPL_StopCapture(void)
+{
+    capture = NULL;
+    OPL_Queue_Clear(capture_queue);
+}
+
+void OPL_FreeCapture(opl_capture_t *_capture)
+{
+    free(_capture->writes);
+    _capture->writes = NULL;
+    _capture->num_writes = 0;
+    _capture->max_writes = 0;
+}
+
+unsigned int OPL_GetStreamRate(void)
+{
+    if (driver != NULL && driver->get_stream_rate_func != NULL)
+    {
+        return driver->get_stream_rate_func();
+    }
+
+    return 0;
+}
+
+void OPL_SetStream(const int16_t *samples, unsigned int nsamples,
+                   int restart)
+{
+    if (driver != NULL && driver->set_stream_func != NULL)
+    {
+        driver->set_stream_func(samples, nsamples, restart);
+    }
+}
+
@@ -150,3 +150,74 @@ void OPL_Delay(uint64_t us);
 // Pause the OPL callbacks.
 
 void OPL_SetPaused(int paused);
+
+//
+// [JN] Offline rendering.
+//
+
+// Register writes of a song, recorded ahead of time by invoking the
+// callbacks in order without waiting for them, and without a chip.
+
+typedef struct
+{
+    uint32_t time;      // Time since the start of recording, in us
+    uint16_t reg;
+    uint8_t value;
+    uint8_t unused;     // Always zero, so the log can be hashed as is
+} opl_reg_write_t;
+
+typedef struct
+{
+    opl_reg_write_t *writes;
+    unsigned int num_writes;
+    unsigned int max_writes;
+
+    // Time of the last callback invoked, in us:
+    uint32_t length;
+} opl_capture_t;
+
+typedef struct opl_render_s opl_render_t;
+
+// Begin recording. Until OPL_StopCapture is called, register writes are
+// added to the capture and callbacks go into a separate queue, so the
+// caller must hold OPL_Lock to keep the real callbacks from running.
+
+void OPL_StartCapture(opl_capture_t *capture);
+
+// Invoke recorded callbacks in time order until there are none left.
+// Returns zero if max_time was reached first, or memory ran out.
+
+int OPL_RunCapture(uint64_t max_time);
+
+// End recording and go back to the driver.
+
+void OPL_StopCapture(void);
+
+void OPL_FreeCapture(opl_capture_t *capture);
+
+// Create a software emulator to play a capture at the given rate. It is
+// not connected to the driver, so can be used from any thread.
+
+opl_render_t *OPL_CreateRender(const opl_capture_t *capture,
+                               unsigned int rate);
+
+// Render next samples (signed 16-bit stereo). Returns the number of
+// samples rendered, which is less than requested at the end.
+
+unsigned int OPL_Render(opl_render_t *render, int16_t *buffer,
+                        unsigned int nsamples);
+
+void OPL_FreeRender(opl_render_t *render);
+
+// Sample rate of rendered streams accepted by OPL_SetStream, or zero
+// if the driver doesn't emulate the chip in software.
+
+unsigned int OPL_GetStreamRate(void);
+
+// Mix a rendered stream instead of running the emulator. The stream
+// loops, and its start is aligned with the callback time of the moment
+// "restart" was last set. Register writes still go to the emulator, so
+// it can take over when the stream is removed with NULL.
+
+void OPL_SetStream(const int16_t *samples, unsigned int nsamples,
+                   int restart);
@@ -35,6 +35,9 @@ typedef void (*opl_lock_func)(void);
 typedef void (*opl_unlock_func)(void);
 typedef void (*opl_set_paused_func)(int paused);
 typedef void (*opl_adjust_callbacks_func)(float value);
+typedef unsigned int (*opl_get_stream_rate_func)(void);
+typedef void (*opl_set_stream_func)(const int16_t *samples,
+                                    unsigned int nsamples, int restart);
 
 typedef struct
 {
@@ -50,6 +53,10 @@ typedef struct
     opl_unlock_func unlock_func;
     opl_set_paused_func set_paused_func;
     opl_adjust_callbacks_func adjust_callbacks_func;
+
+    // [JN] Rendered streams, NULL if not supported:
+    opl_get_stream_rate_func get_stream_rate_func;
+    opl_set_stream_func set_stream_func;
 } opl_driver_t;
 
 // Sample rate to use when doing software emulation.
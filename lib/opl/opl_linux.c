@@ -99,6 +99,8 @@ opl_driver_t opl_linux_driver =
     OPL_Timer_Unlock,
     OPL_Timer_SetPaused,
     OPL_Timer_AdjustCallbacks,
+    NULL,  // get_stream_rate
+    NULL,  // set_stream
 };
 
 #endif /* #if (defined(__i386__) || defined(__x86_64__)) && defined(HAVE_IOPERM) */
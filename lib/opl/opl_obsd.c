@@ -113,6 +113,8 @@ opl_driver_t opl_openbsd_driver =
     OPL_Timer_Unlock,
     OPL_Timer_SetPaused,
     OPL_Timer_AdjustCallbacks,
+    NULL,  // get_stream_rate
+    NULL,  // set_stream
 };
 
 #endif /* #ifndef NO_OBSD_DRIVER */
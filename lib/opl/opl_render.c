@@ -0,0 +1,134 @@
+//
+// Copyright(C) 2016-2025 Julian Nechaevsky
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//     Offline rendering of captured register writes.
+//     Every render has its own emulator, so songs can be rendered on
+//     a background thread while the SDL driver keeps playing.
+//
+
+
+#include <stdlib.h>
+
+#include "opl3.h"
+
+#include "opl.h"
+
+struct opl_render_s
+{
+    opl3_chip chip;
+
+    // Capture being played, must stay allocated while rendering:
+    const opl_capture_t *capture;
+    unsigned int next_write;
+
+    unsigned int rate;
+    uint64_t position;  // Samples rendered so far
+    uint64_t length;    // Length of the capture, in samples
+};
+
+// Sample a register write falls on. Like the SDL driver, writes are
+// made at the first sample at or after their time.
+
+static uint64_t SampleForTime(const opl_render_t *render, uint64_t time)
+{
+    return (time * render->rate + OPL_SECOND - 1) / OPL_SECOND;
+}
+
+// Same register handling as the SDL driver: timers are not emulated.
+
+static void WriteRegister(opl_render_t *render, const opl_reg_write_t *write)
+{
+    switch (write->reg)
+    {
+        case OPL_REG_TIMER1:
+        case OPL_REG_TIMER2:
+        case OPL_REG_TIMER_CTRL:
+            break;
+
+        default:
+            OPL3_WriteRegBuffered(&render->chip, write->reg, write->value);
+            break;
+    }
+}
+
+opl_render_t *OPL_CreateRender(const opl_capture_t *capture,
+                               unsigned int rate)
+{
+    opl_render_t *render;
+
+    render = malloc(sizeof(*render));
+
+    if (render == NULL)
+    {
+        return NULL;
+    }
+
+    OPL3_Reset(&render->chip, rate);
+    render->capture = capture;
+    render->next_write = 0;
+    render->rate = rate;
+    render->position = 0;
+    render->length = SampleForTime(render, capture->length);
+
+    return render;
+}
+
+unsigned int OPL_Render(opl_render_t *render, int16_t *buffer,
+                        unsigned int nsamples)
+{
+    const opl_capture_t *capture = render->capture;
+    unsigned int filled = 0;
+    uint64_t until;
+
+    while (filled < nsamples && render->position < render->length)
+    {
+        // Make all writes which are due now.
+
+        while (render->next_write < capture->num_writes
+            && SampleForTime(render, capture->writes[render->next_write].time)
+               <= render->position)
+        {
+            WriteRegister(render, &capture->writes[render->next_write]);
+            ++render->next_write;
+        }
+
+        // Generate samples until the next write.
+
+        until = render->length;
+
+        if (render->next_write < capture->num_writes)
+        {
+            until = SampleForTime(render,
+                                  capture->writes[render->next_write].time);
+        }
+
+        if (until > render->position + (nsamples - filled))
+        {
+            until = render->position + (nsamples - filled);
+        }
+
+        OPL3_GenerateStream(&render->chip, (Bit16s *) (buffer + filled * 2),
+                            (Bit32u) (until - render->position));
+
+        filled += (unsigned int) (until - render->position);
+        render->position = until;
+    }
+
+    return filled;
+}
+
+void OPL_FreeRender(opl_render_t *render)
+{
+    free(render);
+}
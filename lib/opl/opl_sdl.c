@@ -79,6 +79,14 @@ static int opl_opl3mode;
 
 static uint8_t *mix_buffer = NULL;
 
+// [JN] Rendered stream mixed instead of the emulator output, its length
+// in samples, and callback time its first sample is aligned with.
+// Protected by callback_queue_mutex.
+
+static const int16_t *stream_samples = NULL;
+static unsigned int stream_length;
+static uint64_t stream_start;
+
 // Register number that was written.
 
 static int register_num = 0;
@@ -155,6 +163,40 @@ static void AdvanceTime(unsigned int nsamples)
     SDL_UnlockMutex(callback_queue_mutex);
 }
 
+// [JN] Mix the rendered stream into the specified buffer. Nothing is
+// mixed while paused, as the stream position doesn't move then.
+
+static void FillBufferFromStream(uint8_t *buffer, unsigned int nsamples)
+{
+    uint64_t position;
+    unsigned int n;
+
+    if (opl_sdl_paused)
+    {
+        return;
+    }
+
+    position = (current_time - pause_offset - stream_start) * mixing_freq;
+    position = (position / OPL_SECOND) % stream_length;
+
+    while (nsamples > 0)
+    {
+        n = stream_length - (unsigned int) position;
+
+        if (n > nsamples)
+        {
+            n = nsamples;
+        }
+
+        SDL_MixAudioFormat(buffer, (const Uint8 *) (stream_samples + position * 2),
+                           AUDIO_S16SYS, n * 4, SDL_MIX_MAXVOLUME);
+
+        buffer += n * 4;
+        nsamples -= n;
+        position = 0;
+    }
+}
+
 // Call the OPL emulator code to fill the specified buffer.
 
 static void FillBuffer(uint8_t *buffer, unsigned int nsamples)
@@ -211,11 +253,19 @@ static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
             }
         }
 
-        SDL_UnlockMutex(callback_queue_mutex);
-
         // Add emulator output to buffer.
 
-        FillBuffer(buffer + filled * 4, nsamples);
+        if (stream_samples != NULL)
+        {
+            FillBufferFromStream(buffer + filled * 4, nsamples);
+            SDL_UnlockMutex(callback_queue_mutex);
+        }
+        else
+        {
+            SDL_UnlockMutex(callback_queue_mutex);
+            FillBuffer(buffer + filled * 4, nsamples);
+        }
+
         filled += nsamples;
 
         // Invoke callbacks for this point in time.
@@ -317,6 +367,7 @@ static int OPL_SDL_Init(unsigned int port_base)
 
     opl_sdl_paused = 0;
     pause_offset = 0;
+    stream_samples = NULL;
 
     // Queue structure of callbacks to invoke.
 
@@ -438,7 +489,16 @@ static void WriteRegister(unsigned int reg_num, unsigned int value)
             opl_opl3mode = value & 0x01;
 
         default:
-            OPL3_WriteRegBuffered(&opl_chip, reg_num, value);
+            // [JN] The emulator doesn't generate anything while a stream
+            // is played, so buffered writes would never be flushed.
+            if (stream_samples != NULL)
+            {
+                OPL3_WriteReg(&opl_chip, reg_num, value);
+            }
+            else
+            {
+                OPL3_WriteRegBuffered(&opl_chip, reg_num, value);
+            }
             break;
     }
 }
@@ -497,6 +557,27 @@ static void OPL_SDL_AdjustCallbacks(float factor)
     SDL_UnlockMutex(callback_queue_mutex);
 }
 
+static unsigned int OPL_SDL_GetStreamRate(void)
+{
+    return mixing_freq;
+}
+
+static void OPL_SDL_SetStream(const int16_t *samples, unsigned int nsamples,
+                              int restart)
+{
+    SDL_LockMutex(callback_queue_mutex);
+
+    if (restart)
+    {
+        stream_start = current_time - pause_offset;
+    }
+
+    stream_samples = nsamples > 0 ? samples : NULL;
+    stream_length = nsamples;
+
+    SDL_UnlockMutex(callback_queue_mutex);
+}
+
 opl_driver_t opl_sdl_driver =
 {
     "SDL",
@@ -510,5 +591,7 @@ opl_driver_t opl_sdl_driver =
     OPL_SDL_Unlock,
     OPL_SDL_SetPaused,
     OPL_SDL_AdjustCallbacks,
+    OPL_SDL_GetStreamRate,
+    OPL_SDL_SetStream,
 };
 
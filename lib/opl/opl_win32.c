@@ -187,6 +187,8 @@ opl_driver_t opl_win32_driver =
     OPL_Timer_Unlock,
     OPL_Timer_SetPaused,
     OPL_Timer_AdjustCallbacks,
+    NULL,  // get_stream_rate
+    NULL,  // set_stream
 };
 
 #endif /* #ifdef _WIN32 */
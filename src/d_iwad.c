@@ -530,9 +530,10 @@ static char *CheckDirectoryHasIWAD(char *dir, char *iwadname)
 
     // As a special case, the "directory" may refer directly to an
     // IWAD file if the path comes from DOOMWADDIR or DOOMWADPATH.
+    // [JN] The file name is compared first, so the file system is only
+    // checked, in up to five case variants, when it names this IWAD.
 
-    probe = M_FileCaseExists(dir);
-    if (DirIsFile(dir, iwadname) && probe != NULL)
+    if (DirIsFile(dir, iwadname) && (probe = M_FileCaseExists(dir)) != NULL)
     {
         return probe;
     }
@@ -870,8 +871,8 @@ char *D_FindWADByName(char *name)
         // the "directory" may actually refer directly to an IWAD
         // file.
 
-        probe = M_FileCaseExists(iwad_dirs[i]);
-        if (DirIsFile(iwad_dirs[i], name) && probe != NULL)
+        if (DirIsFile(iwad_dirs[i], name)
+        && (probe = M_FileCaseExists(iwad_dirs[i])) != NULL)
         {
             return probe;
         }
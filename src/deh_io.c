@@ -24,6 +24,8 @@
 #include <string.h>
 #include <ctype.h>
 
+#include "i_system.h"
+#include "i_timer.h"
 #include "m_misc.h"
 #include "w_wad.h"
 #include "z_zone.h"
@@ -37,22 +39,22 @@ typedef enum
     DEH_INPUT_LUMP
 } deh_input_type_t;
 
+// [JN] Both files and lumps are read from memory: files are read whole
+// when opened, lumps are used straight from the WAD file when it is
+// mapped. Lines are found with memchr and copied out at once, unless
+// they have characters which need the character by character path.
+
 struct deh_context_s
 {
     deh_input_type_t type;
     char *filename;
 
-    // If the input comes from a memory buffer, pointer to the memory
-    // buffer.
-    unsigned char *input_buffer;
+    // Input data: the file contents or the lump.
+    const unsigned char *input_buffer;
     size_t input_buffer_len;
-    unsigned int input_buffer_pos;
+    size_t input_buffer_pos;
     int lumpnum;
 
-    // If the input comes from a file, the file stream for reading
-    // data.
-    FILE *stream;
-
     // Current line number that we have reached:
     int linenum;
 
@@ -66,8 +68,31 @@ struct deh_context_s
 
     // [crispy] pointer to start of current line
     long linestart;
+
+    // [JN] Time the context was opened, for statistics.
+    uint64_t opened_us;
 };
 
+// Statistics, printed at exit.
+static boolean stats_registered;
+static unsigned int stat_patches;
+static unsigned int stat_lines;
+static uint64_t stat_bytes;
+static uint64_t stat_total_us;
+
+static void DEH_PrintStats(void)
+{
+    printf(english_language ?
+           "DEH_PrintStats: %u patches, %u lines, %.1f KiB.\n" :
+           "DEH_PrintStats: %u патчей, %u строк, %.1f КиБ.\n",
+           stat_patches, stat_lines, stat_bytes / 1024.0);
+    printf(english_language ?
+           "  parsing: %.1f ms, %.2f us per line\n" :
+           "  обработка: %.1f мс, %.2f мкс на строку\n",
+           stat_total_us / 1000.0,
+           stat_lines ? (double) stat_total_us / stat_lines : 0.0);
+}
+
 static deh_context_t *DEH_NewContext(void)
 {
     deh_context_t *context;
@@ -78,10 +103,18 @@ static deh_context_t *DEH_NewContext(void)
 
     context->readbuffer_size = 128;
     context->readbuffer = Z_Malloc(context->readbuffer_size, PU_STATIC, NULL);
+    context->input_buffer_pos = 0;
     context->linenum = 0;
     context->last_was_newline = true;
 
     context->had_error = false;
+    context->opened_us = I_GetTimeUS();
+
+    if (!stats_registered)
+    {
+        I_AtExit(DEH_PrintStats, true);
+        stats_registered = true;
+    }
 
     return context;
 }
@@ -93,16 +126,63 @@ deh_context_t *DEH_OpenFile(char *filename)
 {
     FILE *fstream;
     deh_context_t *context;
+    unsigned char *buffer, *newbuffer;
+    size_t length, size;
+    long file_length;
 
     fstream = M_fopen(filename, "r");
 
     if (fstream == NULL)
         return NULL;
 
+    // [JN] Read the whole file. It is opened in text mode as before, so
+    // the length read may be less than the file length. Pipes have no
+    // length at all, so the length is only the initial buffer size and
+    // the file is read until the end.
+
+    file_length = M_FileLength(fstream);
+    size = file_length > 0 ? (size_t) file_length + 1 : 4096;
+    buffer = malloc(size);
+    length = 0;
+
+    while (buffer != NULL)
+    {
+        length += fread(buffer + length, 1, size - length, fstream);
+
+        if (length < size)
+        {
+            break;
+        }
+
+        newbuffer = realloc(buffer, size * 2);
+
+        if (newbuffer == NULL)
+        {
+            free(buffer);
+        }
+
+        buffer = newbuffer;
+        size *= 2;
+    }
+
+    if (buffer != NULL && ferror(fstream))
+    {
+        free(buffer);
+        buffer = NULL;
+    }
+
+    fclose(fstream);
+
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+
     context = DEH_NewContext();
 
     context->type = DEH_INPUT_FILE;
-    context->stream = fstream;
+    context->input_buffer = buffer;
+    context->input_buffer_len = length;
     context->filename = M_StringDuplicate(filename);
 
     return context;
@@ -113,9 +193,9 @@ deh_context_t *DEH_OpenFile(char *filename)
 deh_context_t *DEH_OpenLump(int lumpnum)
 {
     deh_context_t *context;
-    void *lump;
+    const void *lump;
 
-    lump = W_CacheLumpNum(lumpnum, PU_STATIC);
+    lump = W_CacheLumpNumRO(lumpnum, PU_STATIC);
 
     context = DEH_NewContext();
 
@@ -123,7 +203,6 @@ deh_context_t *DEH_OpenLump(int lumpnum)
     context->lumpnum = lumpnum;
     context->input_buffer = lump;
     context->input_buffer_len = W_LumpLength(lumpnum);
-    context->input_buffer_pos = 0;
 
     context->filename = malloc(9);
     M_StringCopy(context->filename, lumpinfo[lumpnum]->name, 9);
@@ -135,13 +214,18 @@ deh_context_t *DEH_OpenLump(int lumpnum)
 
 void DEH_CloseFile(deh_context_t *context)
 {
+    stat_patches++;
+    stat_lines += context->linenum;
+    stat_bytes += context->input_buffer_len;
+    stat_total_us += I_GetTimeUS() - context->opened_us;
+
     if (context->type == DEH_INPUT_FILE)
     {
-        fclose(context->stream);
+        free((void *) context->input_buffer);
     }
     else if (context->type == DEH_INPUT_LUMP)
     {
-        W_ReleaseLumpNum(context->lumpnum);
+        W_ReleaseLumpNumRO(context->lumpnum);
     }
 
     free(context->filename);
@@ -149,39 +233,11 @@ void DEH_CloseFile(deh_context_t *context)
     Z_Free(context);
 }
 
-int DEH_GetCharFile(deh_context_t *context)
-{
-    if (feof(context->stream))
-    {
-        // end of file
-
-        return -1;
-    }
-
-    return fgetc(context->stream);
-}
-
-int DEH_GetCharLump(deh_context_t *context)
-{
-    int result;
-
-    if (context->input_buffer_pos >= context->input_buffer_len)
-    {
-        return -1;
-    }
-
-    result = context->input_buffer[context->input_buffer_pos];
-    ++context->input_buffer_pos;
-
-    return result;
-}
-
 // Reads a single character from a dehacked file
 
 int DEH_GetChar(deh_context_t *context)
 {
-    int result = 0;
-    boolean last_was_cr = false;
+    int result;
 
     // Track the current line number
 
@@ -190,40 +246,25 @@ int DEH_GetChar(deh_context_t *context)
         ++context->linenum;
     }
 
-    // Read characters, converting CRLF to LF
-
-    do
+    if (context->input_buffer_pos >= context->input_buffer_len)
     {
-        switch (context->type)
-        {
-            case DEH_INPUT_FILE:
-                result = DEH_GetCharFile(context);
-                break;
-
-            case DEH_INPUT_LUMP:
-                result = DEH_GetCharLump(context);
-                break;
-        }
+        // end of file
 
-        // Handle \r characters not paired with \n
-        if (last_was_cr && result != '\n')
-        {
-            switch (context->type)
-            {
-                case DEH_INPUT_FILE:
-                    ungetc(result, context->stream);
-                    break;
-                case DEH_INPUT_LUMP:
-                    --context->input_buffer_pos;
-                    break;
-            }
+        context->last_was_newline = false;
+        return -1;
+    }
 
-            return '\r';
-        }
+    result = context->input_buffer[context->input_buffer_pos++];
 
-        last_was_cr = result == '\r';
+    // Convert CRLF to LF; \r characters not paired with \n are kept.
 
-    } while (last_was_cr);
+    if (result == '\r'
+     && context->input_buffer_pos < context->input_buffer_len
+     && context->input_buffer[context->input_buffer_pos] == '\n')
+    {
+        result = '\n';
+        ++context->input_buffer_pos;
+    }
 
     context->last_was_newline = result == '\n';
 
@@ -232,12 +273,18 @@ int DEH_GetChar(deh_context_t *context)
 
 // Increase the read buffer size
 
-static void IncreaseReadBuffer(deh_context_t *context)
+static void IncreaseReadBuffer(deh_context_t *context, int size)
 {
     char *newbuffer;
     int newbuffer_size;
 
-    newbuffer_size = context->readbuffer_size * 2;
+    newbuffer_size = context->readbuffer_size;
+
+    while (newbuffer_size < size)
+    {
+        newbuffer_size *= 2;
+    }
+
     newbuffer = Z_Malloc(newbuffer_size, PU_STATIC, NULL);
 
     memcpy(newbuffer, context->readbuffer, context->readbuffer_size);
@@ -251,15 +298,7 @@ static void IncreaseReadBuffer(deh_context_t *context)
 // [crispy] Save pointer to start of current line ...
 void DEH_SaveLineStart (deh_context_t *context)
 {
-    if (context->type == DEH_INPUT_FILE)
-    {
-	context->linestart = ftell(context->stream);
-    }
-    else
-    if (context->type == DEH_INPUT_LUMP)
-    {
-	context->linestart = context->input_buffer_pos;
-    }
+    context->linestart = context->input_buffer_pos;
 }
 
 // [crispy] ... and reset context to start of current line
@@ -270,18 +309,62 @@ void DEH_RestoreLineStart (deh_context_t *context)
     if (context->linestart < 0)
 	return;
 
-    if (context->type == DEH_INPUT_FILE)
+    context->input_buffer_pos = context->linestart;
+
+    // [crispy] don't count this line twice
+    --context->linenum;
+}
+
+// [JN] Reads a line which has no characters needing special handling
+// in one go. Returns false if the line has to be read character by
+// character instead.
+
+static boolean ReadPlainLine(deh_context_t *context, boolean extended)
+{
+    const unsigned char *start = context->input_buffer
+                               + context->input_buffer_pos;
+    const size_t left = context->input_buffer_len - context->input_buffer_pos;
+    const unsigned char *eol;
+    size_t length, i;
+    size_t next;
+
+    if (left == 0 || !context->last_was_newline)
     {
-	fseek(context->stream, context->linestart, SEEK_SET);
+        return false;
     }
-    else
-    if (context->type == DEH_INPUT_LUMP)
+
+    eol = memchr(start, '\n', left);
+    length = eol != NULL ? (size_t) (eol - start) : left;
+    next = eol != NULL ? length + 1 : length;
+
+    // CRLF line ending
+    if (eol != NULL && length > 0 && start[length - 1] == '\r')
     {
-	context->input_buffer_pos = context->linestart;
+        --length;
     }
 
-    // [crispy] don't count this line twice
-    --context->linenum;
+    for (i = 0 ; i < length ; ++i)
+    {
+        if (start[i] == '\r' || start[i] == '\0'
+         || (extended && start[i] == '\\'))
+        {
+            return false;
+        }
+    }
+
+    if (length >= context->readbuffer_size)
+    {
+        IncreaseReadBuffer(context, length + 1);
+    }
+
+    memcpy(context->readbuffer, start, length);
+    context->readbuffer[length] = '\0';
+
+    context->input_buffer_pos += next;
+    context->last_was_newline = eol != NULL;
+    ++context->linenum;
+
+    return true;
 }
 
 // Read a whole line
@@ -292,6 +375,11 @@ char *DEH_ReadLine(deh_context_t *context, boolean extended)
     int pos;
     boolean escaped = false;
 
+    if (ReadPlainLine(context, extended))
+    {
+        return context->readbuffer;
+    }
+
     for (pos = 0;;)
     {
         c = DEH_GetChar(context);
@@ -307,7 +395,7 @@ char *DEH_ReadLine(deh_context_t *context, boolean extended)
 
         if (pos >= context->readbuffer_size)
         {
-            IncreaseReadBuffer(context);
+            IncreaseReadBuffer(context, pos + 1);
         }
 
         // extended string support
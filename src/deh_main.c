@@ -148,7 +148,7 @@ static boolean IsWhitespace(char *s)
 
 static char *CleanString(char *s)
 {
-    char *strending;
+    size_t length;
 
     // Leading whitespace
 
@@ -156,13 +156,13 @@ static char *CleanString(char *s)
         ++s;
 
     // Trailing whitespace
-   
-    strending = s + strlen(s) - 1;
+    // [JN] Without measuring the string again for every character.
 
-    while (strlen(s) > 0 && isspace(*strending))
+    length = strlen(s);
+
+    while (length > 0 && isspace(s[length - 1]))
     {
-        *strending = '\0';
-        --strending;
+        s[--length] = '\0';
     }
 
     return s;
@@ -27,6 +27,7 @@
 #include "doomtype.h"
 #include "deh_str.h"
 #include "m_misc.h"
+#include "w_wad.h"
 #include "z_zone.h"
 #include "jn.h"
 
@@ -180,6 +181,9 @@ void DEH_AddStringReplacement(char *from_text, char *to_text)
         InitHashTable();
     }
 
+    // [JN] Lump names may be replaced, so lump handles must look them up again.
+    W_InvalidateLumpHandles();
+
     // Check to see if there is an existing substitution already in place.
     sub = SubstitutionForString(from_text);
 
@@ -73,6 +73,7 @@
 #include "net_dedicated.h"
 #include "net_query.h"
 #include "rd_keybinds.h"
+#include "rd_rewind.h"
 #include "rd_text.h"
 #include "r_local.h"
 #include "d_main.h"
@@ -219,6 +220,7 @@ int translucency = 1;
 int improved_fuzz = 2;
 int colored_blood = 1;
 int swirling_liquids = 1;
+int swirl_cache_size = 16;
 int invul_sky = 1;
 int linear_sky = 1;
 int randomly_flipcorpses = 1;
@@ -958,6 +960,7 @@ void D_BindVariables(void)
     M_BindIntVariable("improved_fuzz",          &improved_fuzz);
     M_BindIntVariable("colored_blood",          &colored_blood);
     M_BindIntVariable("swirling_liquids",       &swirling_liquids);
+    M_BindIntVariable("swirl_cache_size",       &swirl_cache_size);
     M_BindIntVariable("invul_sky",              &invul_sky);
     M_BindIntVariable("linear_sky",             &linear_sky);
     M_BindIntVariable("randomly_flipcorpses",   &randomly_flipcorpses);
@@ -1017,6 +1020,10 @@ void D_BindVariables(void)
     M_BindIntVariable("demobar",                &demobar);
     M_BindIntVariable("no_internal_demos",      &no_internal_demos);
 
+    // Gameplay: Rewind
+    M_BindIntVariable("rewind_depth",           &rewind_depth);
+    M_BindIntVariable("rewind_interval",        &rewind_interval);
+
     // Multiplayer chat macros
     for (i=0; i<10; ++i)
     {
@@ -3013,6 +3020,9 @@ void D_DoomMain (void)
                "V_Init: Инициализация видео.\n");
     V_Init ();
 
+    // [JN] Rewind buffer, depth may be given by "-rewind".
+    RW_Init();
+
     // Save configuration at exit.
     I_AtExit(M_SaveConfig, true); // [crispy] always save configuration at exit
 
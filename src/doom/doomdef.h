@@ -59,7 +59,9 @@ typedef enum
     ga_completed,
     ga_victory,
     ga_worlddone,
-    ga_screenshot
+    ga_screenshot,
+    ga_rewind,      // [JN] Step back to the previous in-memory snapshot
+    ga_demoseek     // [JN] Jump to another tic of the demo being played back
 } gameaction_t;
 
 //
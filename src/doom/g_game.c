@@ -23,6 +23,10 @@
 #include <stdlib.h>
 #include <math.h>
 
+#define MINIZ_NO_STDIO
+#define MINIZ_NO_ZLIB_APIS
+#include "miniz.h"
+
 #include "doomdef.h"
 #include "doomstat.h"
 #include "deh_main.h"
@@ -46,6 +50,7 @@
 #include "p_local.h" 
 #include "s_sound.h"
 #include "rd_keybinds.h"
+#include "rd_rewind.h"
 #include "id_lang.h"
 #include "sounds.h"
 #include "g_game.h"
@@ -69,6 +74,16 @@ void    G_DoCompleted (void);
 void    G_DoVictory (void);
 void    G_DoWorldDone (void);
 void    G_DoSaveGame (void);
+void    G_DoRewind (void);
+static void G_StoreRewindSnapshot (void);
+static void G_DoDemoSeek (void);
+static void G_StoreDemoSnapshot (void);
+static void G_FreeDemoSnapshots (void);
+static boolean demoseek_restart;  // [JN] G_DoPlayDemo keeps demo snapshots
+
+// [JN] Demo seek: tics between two snapshots and tics skipped by one key press.
+#define DEMOSEEK_INTERVAL   (10*TICRATE)
+#define DEMOSEEK_STEP       (10*TICRATE)
 void    P_SpawnPlayer (mapthing_t *mthing); 
 
 // Gamestate the last time G_Ticker was called.
@@ -90,6 +105,7 @@ boolean         sendpause;  // send a pause event next tic
 boolean         sendsave;   // send a save event next tic
 boolean         usergame;   // ok to save / end game
 
+boolean         rewinding;  // [JN] level is being reloaded by G_DoRewind
 boolean         timingdemo; // if true, exit with report on completion
 boolean         nodrawers;  // for comparative timing purposes
 int             starttime;  // for comparative timing purposes
@@ -711,6 +727,11 @@ void G_DoLoadLevel (void)
     P_SetupLevel (gameepisode, gamemap, gameskill);    
     displayplayer = consoleplayer;		// view the guy you are playing    
     gameaction = ga_nothing; 
+    // [JN] Snapshots of the previous level can't be rewound to.
+    if (!rewinding)
+    {
+        RW_Clear();
+    }
     Z_CheckHeap ();
 
     // clear cmd building stuff
@@ -781,6 +802,23 @@ boolean G_Responder (event_t *ev)
         return true; 
     }
 
+    // [JN] Demo seek: left and right keys skip backward and forward,
+    // unless they are used for panning the automap.
+    if (singledemo && demoplayback && !timingdemo && !automapactive
+    && gameaction == ga_nothing)
+    {
+        if (BK_isKeyDown(ev, bk_left))
+        {
+            G_DemoSeek(defdemotics - DEMOSEEK_STEP);
+            return true;
+        }
+        if (BK_isKeyDown(ev, bk_right))
+        {
+            G_DemoSeek(defdemotics + DEMOSEEK_STEP);
+            return true;
+        }
+    }
+
     // any other key pops up menu if in demos
     if (gameaction == ga_nothing && !singledemo && (demoplayback || gamestate == GS_DEMOSCREEN)) 
     { 
@@ -837,6 +875,14 @@ boolean G_Responder (event_t *ev)
         sendpause = true;
     }
 
+    // [JN] Step back in time, single player only.
+    if (BK_isKeyDown(ev, bk_rewind) && gamestate == GS_LEVEL && !menuactive
+    && gameaction == ga_nothing && !netgame && !demorecording && RW_Available())
+    {
+        gameaction = ga_rewind;
+        return true;
+    }
+
     switch (ev->type)
     { 
         case ev_keydown:
@@ -878,6 +924,37 @@ static void G_ReadGameParms (void)
     nomonsters = M_CheckParm ("-nomonsters");
 }
 
+//
+// G_CheckSaveGameWritten
+// [JN] Savegames are written in background, so the message is shown
+// once the file is written, or the write has failed.
+//
+static boolean savemessage_pending;
+
+static void G_CheckSaveGameWritten (void)
+{
+    if (!savemessage_pending)
+    {
+        return;
+    }
+
+    switch (M_GetSaveGameStatus())
+    {
+        case SAVEGAME_PENDING:
+            return;
+
+        case SAVEGAME_FAILED:
+            P_SetMessage(&players[consoleplayer], DEH_String(ggsavefailed), msg_system, false);
+            break;
+
+        default:
+            P_SetMessage(&players[consoleplayer], DEH_String(ggsaved), msg_system, false);
+            break;
+    }
+
+    savemessage_pending = false;
+}
+
 //
 // G_Ticker
 // Make ticcmd_ts for the players.
@@ -893,6 +970,8 @@ void G_Ticker (void)
         if (playeringame[i] && players[i].playerstate == PST_REBORN) 
         G_DoReborn (i);
 
+    G_CheckSaveGameWritten();
+
     // do things to change the game state
     while (gameaction != ga_nothing) 
     { 
@@ -937,6 +1016,14 @@ void G_Ticker (void)
             G_DoWorldDone ();
             break; 
 
+            case ga_rewind:
+            G_DoRewind ();
+            break;
+
+            case ga_demoseek:
+            G_DoDemoSeek ();
+            break;
+
             case ga_screenshot: // [JN] Extended name from "DOOM%02i.%s"
             V_ScreenShot("screenshot-doom-%02i.%s");
             S_StartSound(NULL,sfx_itemup); // [JN] Audible feedback
@@ -1095,6 +1182,15 @@ void G_Ticker (void)
         {
             CT_Ticker ();  // [JN] Not really needed in single player game.
         }
+        if (!netgame && !demoplayback && !demorecording
+        && gameaction == ga_nothing && RW_SnapshotDue(leveltime))
+        {
+            G_StoreRewindSnapshot ();
+        }
+        if (singledemo && demoplayback && !timingdemo && gameaction == ga_nothing)
+        {
+            G_StoreDemoSnapshot ();
+        }
         break; 
 
         case GS_INTERMISSION: 
@@ -1815,6 +1911,8 @@ void G_LoadGame (char* name)
 void G_DoLoadGame (void) 
 { 
     int savedleveltime;
+    byte *savebuffer;
+    size_t savelength;
 
     // [crispy] loaded game must always be single player.
     // Needed for ability to use a further game loading, as well as
@@ -1828,18 +1926,21 @@ void G_DoLoadGame (void)
 
     gameaction = ga_nothing; 
 
-    save_stream = M_fopen(savename, "rb");
+    // [JN] Savegame is read at once, and inflated if it was compressed.
+    savebuffer = M_ReadSaveGame(savename, SAVESTRINGSIZE + VERSIONSIZE, &savelength);
 
-    if (save_stream == NULL)
+    if (savebuffer == NULL)
     {
         return;
     }
 
+    save_stream = mem_fopen_read(savebuffer, savelength);
     savegame_error = false;
 
     if (!P_ReadSaveGameHeader())
     {
-        fclose(save_stream);
+        mem_fclose(save_stream);
+        Z_Free(savebuffer);
         return;
     }
 
@@ -1863,7 +1964,8 @@ void G_DoLoadGame (void)
                         "Bad savegame" :
                         "Некорректный файл сохранения");
 
-    fclose(save_stream);
+    mem_fclose(save_stream);
+    Z_Free(savebuffer);
     
     // [JN] Additional message after game load.
     if (!vanillaparm)
@@ -1893,34 +1995,14 @@ G_SaveGame
 
 void G_DoSaveGame (void) 
 { 
-    char *savegame_file;
-    char *temp_savegame_file;
-    char *recovery_savegame_file;
-
-    recovery_savegame_file = NULL;
-    temp_savegame_file = P_TempSaveGameFile();
-    savegame_file = P_SaveGameFile(savegameslot);
-
-    // Open the savegame file for writing.  We write to a temporary file
-    // and then rename it at the end if it was successfully written.
-    // This prevents an existing savegame from being overwritten by
-    // a corrupted one, or if a savegame buffer overrun occurs.
-    save_stream = M_fopen(temp_savegame_file, "wb");
-
-    if (save_stream == NULL)
-    {
-        // Failed to save the game, so we're going to have to abort. But
-        // to be nice, save to somewhere else before we call I_QuitWithError().
-        recovery_savegame_file = M_TempFile("recovery.dsg");
-        save_stream = M_fopen(recovery_savegame_file, "wb");
-        if (save_stream == NULL)
-        {
-            I_QuitWithError(english_language ?
-                            "Failed to open either '%s' or '%s' to write savegame." :
-                            "Невозможно открыть '%s' или '%s' для записи файла сохранения.",
-                            temp_savegame_file, recovery_savegame_file);
-        }
-    }
+    void *savebuffer;
+    size_t savelength;
+
+    // [JN] Serialize the game into memory. Compressing and writing it out
+    // is done in background: the file is written to a temporary one and
+    // renamed at the end, so an existing savegame is never overwritten
+    // by a corrupted one.
+    save_stream = mem_fopen_write();
 
     savegame_error = false;
 
@@ -1934,39 +2016,103 @@ void G_DoSaveGame (void)
 
     P_WriteSaveGameEOF();
 
-    // Finish up, close the savegame file.
+    mem_get_buf(save_stream, &savebuffer, &savelength);
+    M_GetSaveGameStatus();  // drop result of earlier writes
+    M_WriteSaveGameAsync(P_SaveGameFile(savegameslot), savebuffer, savelength,
+                         SAVESTRINGSIZE + VERSIONSIZE);
+    mem_fclose(save_stream);
+
+    gameaction = ga_nothing;
+    M_StringCopy(savedescription, "", sizeof(savedescription));
+
+    savemessage_pending = true;
+
+    // draw the pattern into the back screen
+    R_FillBackScreen ();
+}
+
+
+//
+// G_StoreRewindSnapshot
+// [JN] Serializes the level into the rewind buffer, same way as G_DoSaveGame
+// does, but without touching the disk.
+//
+static void G_StoreRewindSnapshot (void)
+{
+    const uint64_t start = I_GetTimeUS();
+    void *snapshot;
+    size_t length;
+
+    save_stream = mem_fopen_write();
+    savegame_error = false;
+
+    P_WriteSaveGameHeader("");
+
+    P_ArchivePlayers ();
+    P_ArchiveWorld ();
+    P_ArchiveThinkers ();
+    P_ArchiveSpecials ();
+    P_ArchiveAutomap ();
+
+    P_WriteSaveGameEOF();
+
+    mem_get_buf(save_stream, &snapshot, &length);
+    RW_Store(snapshot, length, leveltime, I_GetTimeUS() - start);
+    mem_fclose(save_stream);
+}
 
-    fclose(save_stream);
 
-    if (recovery_savegame_file != NULL)
+//
+// G_DoRewind
+// [JN] Restores the previous snapshot from the rewind buffer, same way as
+// G_DoLoadGame does. The level is reloaded without wiping the screen.
+//
+void G_DoRewind (void)
+{
+    byte *snapshot;
+    size_t length;
+    int tic;
+
+    gameaction = ga_nothing;
+
+    snapshot = RW_Restore(leveltime, &length, &tic);
+
+    if (snapshot == NULL)
     {
-        // We failed to save to the normal location, but we wrote a
-        // recovery file to the temp directory. Now we can bomb out
-        // with an error.
-        if (english_language)
-        {
-            I_QuitWithError("Failed to open savegame file '%s' for writing.\n"
-                            "But your game has been saved to '%s' for recovery.",
-                            temp_savegame_file, recovery_savegame_file);
-        }
-        else
-        {
-            I_QuitWithError("Невозможно открыть файл '%s' для совершения записи.\n"
-                            "Сохранение было записано в '%s' для возможности восстановления.",
-                            temp_savegame_file, recovery_savegame_file);
-        }
+        return;
     }
 
-    // Now rename the temporary savegame file to the actual savegame
-    // file, overwriting the old savegame if there was one there.
+    save_stream = mem_fopen_read(snapshot, length);
+    savegame_error = false;
 
-    M_remove(savegame_file);
-    M_rename(temp_savegame_file, savegame_file);
+    if (!P_ReadSaveGameHeader())
+    {
+        mem_fclose(save_stream);
+        return;
+    }
 
-    gameaction = ga_nothing;
-    M_StringCopy(savedescription, "", sizeof(savedescription));
+    rewinding = true;
+    G_InitNew (gameskill, gameepisode, gamemap);
+    rewinding = false;
+    wipegamestate = GS_LEVEL;
+
+    leveltime = tic;
+
+    P_UnArchivePlayers ();
+    P_UnArchiveWorld ();
+    P_UnArchiveThinkers ();
+    P_UnArchiveSpecials ();
+    P_UnArchiveAutomap ();
+    P_RestoreTargets ();
+
+    if (!P_ReadSaveGameEOF())
+        I_QuitWithError(english_language ?
+                        "Bad rewind snapshot" :
+                        "Некорректный снимок перемотки");
+
+    mem_fclose(save_stream);
 
-    P_SetMessage(&players[consoleplayer], DEH_String(ggsaved), msg_system, false);
+    P_SetMessage(&players[consoleplayer], DEH_String(ggrewound), msg_system, false);
 
     // draw the pattern into the back screen
     R_FillBackScreen ();
@@ -2643,6 +2789,10 @@ void G_DoPlayDemo (void)
 
     lumpnum = W_GetNumForName(defdemoname);
     gameaction = ga_nothing;
+    if (!demoseek_restart)
+    {
+        G_FreeDemoSnapshots();
+    }
     demobuffer = W_CacheLumpNum(lumpnum, PU_STATIC);
     demo_p = demobuffer;
 
@@ -2771,6 +2921,239 @@ void G_DoPlayDemo (void)
 } 
 
 
+// -----------------------------------------------------------------------------
+// Demo seek
+// [JN] While a demo from the command line is played back, the level is
+// serialized into memory with the savegame archivers every DEMOSEEK_INTERVAL
+// tics. Seeking restores the closest snapshot before the target tic and runs
+// the game forward from there without drawing and without sound, the same
+// way "-timedemo -nodraw" does. Snapshots are deflated, so even multi-hour
+// demos need only a few megabytes.
+// -----------------------------------------------------------------------------
+
+// Fastest deflate level, snapshots are taken while the demo is playing.
+#define DEMOSNAPSHOT_DEFLATE_FLAGS (1 | TDEFL_GREEDY_PARSING_FLAG)
+
+typedef struct
+{
+    int     demotic;    // defdemotics at the moment of snapshot
+    size_t  demopos;    // demo_p - demobuffer
+    byte   *data;       // Deflated game state
+    size_t  length;
+    size_t  rawlength;
+} demosnapshot_t;
+
+static demosnapshot_t *demosnapshots;
+static int numdemosnapshots, maxdemosnapshots;
+static int demoseek_target;
+
+// State not covered by savegames, but needed to keep the demo in sync.
+typedef struct
+{
+    int prndindex;
+    int rndindex;
+    int totalleveltimes;
+    int tracerphase;    // [crispy] gametic - demostarttic of the next tic
+} demoextra_t;
+
+static void G_FreeDemoSnapshots (void)
+{
+    int i;
+
+    for (i = 0 ; i < numdemosnapshots ; i++)
+    {
+        free(demosnapshots[i].data);
+    }
+
+    numdemosnapshots = 0;
+}
+
+// Takes a snapshot if DEMOSEEK_INTERVAL tics passed since the last one.
+// Snapshots are taken in order, so after seeking back nothing is stored
+// until the demo reaches not yet covered part.
+static void G_StoreDemoSnapshot (void)
+{
+    demoextra_t extra;
+    demosnapshot_t *snapshot;
+    void *raw;
+    size_t rawlength;
+    size_t length;
+    byte *deflated;
+
+    if (numdemosnapshots > 0 && defdemotics <
+        demosnapshots[numdemosnapshots - 1].demotic + DEMOSEEK_INTERVAL)
+    {
+        return;
+    }
+
+    save_stream = mem_fopen_write();
+    savegame_error = false;
+
+    P_WriteSaveGameHeader("");
+
+    P_ArchivePlayers ();
+    P_ArchiveWorld ();
+    P_ArchiveThinkers ();
+    P_ArchiveSpecials ();
+    P_ArchiveAutomap ();
+
+    P_WriteSaveGameEOF();
+
+    extra.prndindex = prndindex;
+    extra.rndindex = rndindex;
+    extra.totalleveltimes = totalleveltimes;
+    extra.tracerphase = gametic + 1 - demostarttic;
+    mem_fwrite(&extra, sizeof(extra), 1, save_stream);
+
+    mem_get_buf(save_stream, &raw, &rawlength);
+    deflated = tdefl_compress_mem_to_heap(raw, rawlength, &length,
+                                          DEMOSNAPSHOT_DEFLATE_FLAGS);
+    mem_fclose(save_stream);
+
+    if (deflated == NULL)
+    {
+        return;
+    }
+
+    if (numdemosnapshots == maxdemosnapshots)
+    {
+        maxdemosnapshots = maxdemosnapshots ? maxdemosnapshots * 2 : 64;
+        demosnapshots = I_Realloc(demosnapshots,
+                                  maxdemosnapshots * sizeof(*demosnapshots));
+    }
+
+    snapshot = &demosnapshots[numdemosnapshots++];
+    snapshot->demotic = defdemotics;
+    snapshot->demopos = demo_p - demobuffer;
+    snapshot->data = deflated;
+    snapshot->length = length;
+    snapshot->rawlength = rawlength;
+}
+
+static void G_RestoreDemoSnapshot (const demosnapshot_t *snapshot)
+{
+    demoextra_t extra;
+    byte *raw;
+    int savedleveltime;
+
+    raw = Z_Malloc(snapshot->rawlength, PU_STATIC, NULL);
+
+    if (tinfl_decompress_mem_to_mem(raw, snapshot->rawlength, snapshot->data,
+                                    snapshot->length, 0) != snapshot->rawlength)
+    {
+        I_QuitWithError(english_language ?
+                        "G_RestoreDemoSnapshot: snapshot is corrupted" :
+                        "G_RestoreDemoSnapshot: снимок поврежден");
+    }
+
+    save_stream = mem_fopen_read(raw, snapshot->rawlength);
+    savegame_error = false;
+
+    P_ReadSaveGameHeader();
+    savedleveltime = leveltime;
+
+    // G_InitNew stops demo playback, bring it back.
+    precache = false;
+    G_InitNew (gameskill, gameepisode, gamemap);
+    precache = true;
+    usergame = false;
+    demoplayback = true;
+
+    leveltime = savedleveltime;
+
+    P_UnArchivePlayers ();
+    P_UnArchiveWorld ();
+    P_UnArchiveThinkers ();
+    P_UnArchiveSpecials ();
+    P_UnArchiveAutomap ();
+    P_RestoreTargets ();
+
+    if (!P_ReadSaveGameEOF()
+    ||  mem_fread(&extra, sizeof(extra), 1, save_stream) != 1)
+    {
+        I_QuitWithError(english_language ?
+                        "G_RestoreDemoSnapshot: snapshot is corrupted" :
+                        "G_RestoreDemoSnapshot: снимок поврежден");
+    }
+
+    mem_fclose(save_stream);
+    Z_Free(raw);
+
+    prndindex = extra.prndindex;
+    rndindex = extra.rndindex;
+    totalleveltimes = extra.totalleveltimes;
+    demostarttic = gametic - extra.tracerphase;
+
+    defdemotics = snapshot->demotic;
+    demo_p = demobuffer + snapshot->demopos;
+}
+
+//
+// G_DemoSeek
+// [JN] Requests a jump to given tic of the demo being played back.
+//
+void G_DemoSeek (int tic)
+{
+    demoseek_target = tic;
+    gameaction = ga_demoseek;
+}
+
+static void G_DoDemoSeek (void)
+{
+    // The target tic itself is run by G_Ticker which called us.
+    const int target = BETWEEN(0, deftotaldemotics - 2, demoseek_target - 1);
+    const boolean old_nodrawers = nodrawers;
+    const boolean old_singletics = singletics;
+    const int old_paused = paused;
+    int i;
+
+    gameaction = ga_nothing;
+
+    // Closest snapshot not later than the target.
+    for (i = numdemosnapshots - 1 ; i >= 0 && demosnapshots[i].demotic > target ; i--);
+
+    if (i >= 0 && (target < defdemotics || demosnapshots[i].demotic > defdemotics))
+    {
+        G_RestoreDemoSnapshot(&demosnapshots[i]);
+    }
+    else if (i < 0 && target < defdemotics)
+    {
+        // No snapshot that early, start over from the beginning.
+        demoseek_restart = true;
+        G_DoPlayDemo ();
+        demoseek_restart = false;
+    }
+
+    // Run the game forward. Sound is muted while both of these are set.
+    nodrawers = true;
+    singletics = true;
+    paused = false;
+
+    while (demoplayback && defdemotics < target)
+    {
+        G_Ticker ();
+        // [crispy] Keep revenant tracers in sync as if gametic was running.
+        demostarttic--;
+    }
+
+    nodrawers = old_nodrawers;
+    singletics = old_singletics;
+    paused = old_paused;
+
+    // No screen wipe, restart sounds and music of the current state.
+    wipegamestate = gamestate;
+
+    if (gamestate == GS_LEVEL)
+    {
+        S_Start();
+    }
+    else if (gamestate == GS_INTERMISSION)
+    {
+        S_ChangeMusic(gamemode == commercial ? mus_dm2int : mus_inter, true);
+    }
+}
+
+
 //
 // G_TimeDemo 
 //
@@ -2826,6 +3209,7 @@ boolean G_CheckDemoStatus (void)
 
     if (demoplayback)
     { 
+        G_FreeDemoSnapshots();
         W_ReleaseLumpName(defdemoname);
         demoplayback = false; 
         netdemo = false;
@@ -57,6 +57,8 @@ patch_t *m_pause;
 //
 
 char* ggsaved;
+char* ggsavefailed;
+char* ggrewound;
 char* ggloaded;
 
 
@@ -304,6 +306,8 @@ void ID_DefineLanguageStrings (void)
         //
 
         ggsaved         = GGSAVED;
+        ggsavefailed    = GGSAVEFAILED;
+        ggrewound       = GGREWOUND;
         ggloaded        = GGLOADED;
 
         //
@@ -477,6 +481,8 @@ void ID_DefineLanguageStrings (void)
         //
 
         ggsaved         = GGSAVED_RUS;
+        ggsavefailed    = GGSAVEFAILED_RUS;
+        ggrewound       = GGREWOUND_RUS;
         ggloaded        = GGLOADED_RUS;
 
         //
@@ -92,9 +92,13 @@ extern patch_t *m_pause;
 //
 
 extern char* ggsaved;
+extern char* ggsavefailed;
+extern char* ggrewound;
 extern char* ggloaded;
 
 #define GGSAVED         "game saved."
+#define GGSAVEFAILED    "game save failed."
+#define GGREWOUND       "rewound."
 #define GGLOADED        "game loaded."
 
 
@@ -1112,6 +1116,8 @@ extern patch_t *stysslsh;
 //
 
 #define GGSAVED_RUS          "buhf cj[hfytyf>"          // Игра сохранена.
+#define GGSAVEFAILED_RUS     "jib,rf cj[hfytybz>"       // Ошибка сохранения.
+#define GGREWOUND_RUS        "gthtvjnfyj yfpfl>"        // Перемотано назад.
 #define GGLOADED_RUS         "buhf pfuhe;tyf>"          // Игра загружена.
 
 // RD specific
@@ -53,6 +53,23 @@
 #include "rd_menu.h"
 #include "jn.h"
 
+// [JN] Lumps drawn every frame, looked up by name only once.
+
+static lumphandle_t lh_m_optttl = LUMPHANDLE("M_OPTTTL");
+static lumphandle_t lh_m_svol = LUMPHANDLE("M_SVOL");
+static lumphandle_t lh_m_colors = LUMPHANDLE("M_COLORS");
+static lumphandle_t lh_playpal = LUMPHANDLE("PLAYPAL");
+static lumphandle_t lh_interpic = LUMPHANDLE("INTERPIC");
+static lumphandle_t lh_m_loadg = LUMPHANDLE("M_LOADG");
+static lumphandle_t lh_m_lsleft = LUMPHANDLE("M_LSLEFT");
+static lumphandle_t lh_m_lscntr = LUMPHANDLE("M_LSCNTR");
+static lumphandle_t lh_m_lsrght = LUMPHANDLE("M_LSRGHT");
+static lumphandle_t lh_m_saveg = LUMPHANDLE("M_SAVEG");
+static lumphandle_t lh_m_doom = LUMPHANDLE("M_DOOM");
+static lumphandle_t lh_m_newg = LUMPHANDLE("M_NEWG");
+static lumphandle_t lh_m_skill = LUMPHANDLE("M_SKILL");
+static lumphandle_t lh_m_episod = LUMPHANDLE("M_EPISOD");
+
 
 #define LINEHEIGHT      16
 
@@ -1031,7 +1048,7 @@ static MenuItem_t Bindings3Items[] = {
     I_EFUNC("Change gamma level", "ehjdtym ufvvs",       BK_StartBindingKey, bk_gamma),       // Уровень гаммы
     I_EFUNC("Go to next level",   "cktle.obq ehjdtym",   BK_StartBindingKey, bk_nextlevel),   // Следующий уровень
     I_EFUNC("Restart level/demo", "gthtpfgecr ehjdyz",   BK_StartBindingKey, bk_reloadlevel), // Перезапуск уровня
-    I_EMPTY,
+    I_EFUNC("Rewind",             "gthtvjnrf yfpfl",     BK_StartBindingKey, bk_rewind),      // Перемотка назад
     I_SETMENU(NULL, NULL, &Bindings4Menu), // Далее >
     I_SETMENU(NULL, NULL, &Bindings2Menu), // < Назад
     I_EMPTY
@@ -1598,7 +1615,7 @@ void M_Vanilla_DrawOptions(void)
     {
     // - "OPTIONS" title -------------------------------------------------------
     V_DrawPatch(108 + wide_delta, 15, 
-                W_CacheLumpName(DEH_String("M_OPTTTL"), PU_CACHE), NULL);
+                W_CacheLumpHandle(&lh_m_optttl, PU_CACHE), NULL);
 
     // - Messages --------------------------------------------------------------
     V_DrawPatch(179 + wide_delta, 53, 
@@ -1636,7 +1653,7 @@ void M_Vanilla_DrawSound(void)
     {
     // - "Sound volume" title --------------------------------------------------
     V_DrawPatch (60 + wide_delta, 38, 
-                 W_CacheLumpName(DEH_String("M_SVOL"), PU_CACHE), NULL);
+                 W_CacheLumpHandle(&lh_m_svol, PU_CACHE), NULL);
     }
     else
     {
@@ -2344,7 +2361,7 @@ static void M_RD_Draw_Colors(void)
 
     if (show_palette)
     {
-        V_DrawPatchUnscaled(wide_delta*2, 200, W_CacheLumpName(DEH_String("M_COLORS"), PU_CACHE), NULL);
+        V_DrawPatchUnscaled(wide_delta*2, 200, W_CacheLumpHandle(&lh_m_colors, PU_CACHE), NULL);
     }
 }
 
@@ -2352,14 +2369,14 @@ static void M_RD_Change_Brightness(Direction_t direction)
 {
     RD_Menu_SlideFloat_Step(&brightness, 0.01F, 1.0F, 0.01F, direction);
 
-    I_SetPalette ((byte *)W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE) + st_palette * 768);
+    I_SetPalette ((byte *)W_CacheLumpHandle(&lh_playpal, PU_CACHE) + st_palette * 768);
 }
 
 static void M_RD_Change_Gamma(Direction_t direction)
 {
     RD_Menu_SlideInt(&usegamma, 0, 17, direction);
 
-    I_SetPalette ((byte *)W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE) + st_palette * 768);
+    I_SetPalette ((byte *)W_CacheLumpHandle(&lh_playpal, PU_CACHE) + st_palette * 768);
 }
 
 
@@ -2367,7 +2384,7 @@ static void M_RD_Change_Saturation(Direction_t direction)
 {
     RD_Menu_SlideFloat_Step(&color_saturation, 0.01F, 1.0F, 0.01F, direction);
 
-    I_SetPalette ((byte *)W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE) + st_palette * 768);
+    I_SetPalette ((byte *)W_CacheLumpHandle(&lh_playpal, PU_CACHE) + st_palette * 768);
 }
 
 static void M_RD_Change_ShowPalette()
@@ -2379,21 +2396,21 @@ static void M_RD_Change_RED_Color(Direction_t direction)
 {
     RD_Menu_SlideFloat_Step(&r_color_factor, 0.01F, 1.0F, 0.01F, direction);
 
-    I_SetPalette ((byte *)W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE) + st_palette * 768);
+    I_SetPalette ((byte *)W_CacheLumpHandle(&lh_playpal, PU_CACHE) + st_palette * 768);
 }
 
 static void M_RD_Change_GREEN_Color(Direction_t direction)
 {
     RD_Menu_SlideFloat_Step(&g_color_factor, 0.01F, 1.0F, 0.01F, direction);
 
-    I_SetPalette ((byte *)W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE) + st_palette * 768);
+    I_SetPalette ((byte *)W_CacheLumpHandle(&lh_playpal, PU_CACHE) + st_palette * 768);
 }
 
 static void M_RD_Change_BLUE_Color(Direction_t direction)
 {
     RD_Menu_SlideFloat_Step(&b_color_factor, 0.01F, 1.0F, 0.01F, direction);
 
-    I_SetPalette ((byte *)W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE) + st_palette * 768);
+    I_SetPalette ((byte *)W_CacheLumpHandle(&lh_playpal, PU_CACHE) + st_palette * 768);
 }
 
 
@@ -4229,7 +4246,7 @@ static void M_RD_Draw_Gameplay_1(void)
     // Jaguar: hide game background, don't draw lines over the HUD
     if (gamemission == jaguar)
     {
-        V_DrawPatchFullScreen(W_CacheLumpName(DEH_String("INTERPIC"), PU_CACHE), false);
+        V_DrawPatchFullScreen(W_CacheLumpHandle(&lh_interpic, PU_CACHE), false);
     }
 
     if (english_language)
@@ -4371,7 +4388,7 @@ static void M_RD_Draw_Gameplay_2(void)
     // Jaguar: hide game background, don't draw lines over the HUD
     if (gamemission == jaguar)
     {
-        V_DrawPatchFullScreen(W_CacheLumpName(DEH_String("INTERPIC"), PU_CACHE), false);
+        V_DrawPatchFullScreen(W_CacheLumpHandle(&lh_interpic, PU_CACHE), false);
     }
 
     if (english_language)
@@ -4591,7 +4608,7 @@ static void M_RD_Draw_Gameplay_3(void)
     // Jaguar: hide game background, don't draw lines over the HUD
     if (gamemission == jaguar)
     {
-        V_DrawPatchFullScreen(W_CacheLumpName(DEH_String("INTERPIC"), PU_CACHE), false);
+        V_DrawPatchFullScreen(W_CacheLumpHandle(&lh_interpic, PU_CACHE), false);
     }
 
     if (english_language)
@@ -4768,7 +4785,7 @@ static void M_RD_Draw_Gameplay_4(void)
     // Jaguar: hide game background, don't draw lines over the HUD
     if (gamemission == jaguar)
     {
-        V_DrawPatchFullScreen(W_CacheLumpName(DEH_String("INTERPIC"), PU_CACHE), false);
+        V_DrawPatchFullScreen(W_CacheLumpHandle(&lh_interpic, PU_CACHE), false);
     }
 
     if (english_language)
@@ -5016,7 +5033,7 @@ static void M_RD_Draw_Gameplay_5(void)
     // Jaguar: hide game background, don't draw lines over the HUD
     if (gamemission == jaguar)
     {
-        V_DrawPatchFullScreen(W_CacheLumpName(DEH_String("INTERPIC"), PU_CACHE), false);
+        V_DrawPatchFullScreen(W_CacheLumpHandle(&lh_interpic, PU_CACHE), false);
     }
 
     if (english_language)
@@ -6320,7 +6337,7 @@ static void M_RD_BackToDefaults_Recommended()
     I_ReInitGraphics(REINIT_RENDERER | REINIT_TEXTURES | REINIT_ASPECTRATIO);
 
     // Reset palette.
-    I_SetPalette ((byte *)W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE) + st_palette * 768);
+    I_SetPalette ((byte *)W_CacheLumpHandle(&lh_playpal, PU_CACHE) + st_palette * 768);
 
     // Recalculate light tables
     R_InitLightTables();
@@ -6515,7 +6532,7 @@ static void M_RD_BackToDefaults_Original()
     I_ReInitGraphics(REINIT_RENDERER | REINIT_TEXTURES | REINIT_ASPECTRATIO);
 
     // Reset palette.
-    I_SetPalette ((byte *)W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE) + st_palette * 768);
+    I_SetPalette ((byte *)W_CacheLumpHandle(&lh_playpal, PU_CACHE) + st_palette * 768);
 
     // Recalculate light tables
     R_InitLightTables();
@@ -6611,6 +6628,9 @@ static void M_ReadSaveStrings()
     int     i;
     char    name[256];
 
+    // [JN] Let pending saves and removals reach the disk first.
+    M_FlushFileWrites();
+
     for (i = 0;i < 8;i++)
     {
         M_StringCopy(name, P_SaveGameFile(i), sizeof(name));
@@ -6645,7 +6665,7 @@ static void M_DrawLoad()
     if (english_language)
     {
         V_DrawShadowedPatchDoom(LoadDef_x + wide_delta, LoadDef_y,
-                           W_CacheLumpName(DEH_String("M_LOADG"), PU_CACHE));
+                           W_CacheLumpHandle(&lh_m_loadg, PU_CACHE));
     }
     else
     {
@@ -6675,15 +6695,15 @@ static void M_DrawSaveLoadBorder(int x,int y)
 {
     int i;
 
-    V_DrawShadowedPatchDoom(x - 8, y + 8, W_CacheLumpName(DEH_String("M_LSLEFT"), PU_CACHE));
+    V_DrawShadowedPatchDoom(x - 8, y + 8, W_CacheLumpHandle(&lh_m_lsleft, PU_CACHE));
 
     for (i = 0 ; i < 24 ; i++)
     {
-        V_DrawShadowedPatchDoom(x, y + 8, W_CacheLumpName(DEH_String("M_LSCNTR"), PU_CACHE));
+        V_DrawShadowedPatchDoom(x, y + 8, W_CacheLumpHandle(&lh_m_lscntr, PU_CACHE));
         x += 8;
     }
 
-    V_DrawShadowedPatchDoom(x, y + 8, W_CacheLumpName(DEH_String("M_LSRGHT"), PU_CACHE));
+    V_DrawShadowedPatchDoom(x, y + 8, W_CacheLumpHandle(&lh_m_lsrght, PU_CACHE));
 }
 
 
@@ -6737,7 +6757,7 @@ static void M_DrawSave()
     {
         // [JN] Use standard centered title "M_SAVEG"
         V_DrawShadowedPatchDoom(SaveDef_x + wide_delta, SaveDef_y, 
-                                W_CacheLumpName(DEH_String("M_SAVEG"), PU_CACHE));
+                                W_CacheLumpHandle(&lh_m_saveg, PU_CACHE));
     }
     else
     {
@@ -7037,7 +7057,7 @@ static void M_DrawMainMenu(void)
     {
         // [JN] Always draw original "M_DOOM" in English language
         V_DrawPatch(94+wide_delta, 2, 
-                    W_CacheLumpName(DEH_String("M_DOOM"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_m_doom, PU_CACHE), NULL);
     }
     else
     {
@@ -7057,8 +7077,8 @@ static void M_DrawNewGame()
 {
     if (english_language)
     {
-        V_DrawShadowedPatchDoom(96 + wide_delta, 13, W_CacheLumpName(DEH_String("M_NEWG"), PU_CACHE));
-        V_DrawShadowedPatchDoom(54 + wide_delta, 38, W_CacheLumpName(DEH_String("M_SKILL"), PU_CACHE));
+        V_DrawShadowedPatchDoom(96 + wide_delta, 13, W_CacheLumpHandle(&lh_m_newg, PU_CACHE));
+        V_DrawShadowedPatchDoom(54 + wide_delta, 38, W_CacheLumpHandle(&lh_m_skill, PU_CACHE));
     }
     else
     {
@@ -7115,8 +7135,8 @@ static void M_DrawEpisode()
 {
     if (english_language)
     {
-        V_DrawShadowedPatchDoom(96 + wide_delta, 13, W_CacheLumpName(DEH_String("M_NEWG"), PU_CACHE));
-        V_DrawShadowedPatchDoom(54 + wide_delta, 38, W_CacheLumpName(DEH_String("M_EPISOD"), PU_CACHE));
+        V_DrawShadowedPatchDoom(96 + wide_delta, 13, W_CacheLumpHandle(&lh_m_newg, PU_CACHE));
+        V_DrawShadowedPatchDoom(54 + wide_delta, 38, W_CacheLumpHandle(&lh_m_episod, PU_CACHE));
     }
     else
     {
@@ -7783,7 +7803,7 @@ boolean M_Responder (event_t* ev)
         if (usegamma > 17)
             usegamma = 0;
 
-        I_SetPalette ((byte *)W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE) + st_palette * 768);
+        I_SetPalette ((byte *)W_CacheLumpHandle(&lh_playpal, PU_CACHE) + st_palette * 768);
 
         gamma_level = M_StringJoin(gammamsg, english_language ?
                                    gammalevel_names[usegamma] :
@@ -8140,9 +8160,9 @@ void M_Init (void)
     CurrentItPos = CurrentMenu->lastOn;
 
 	// [crispy] rearrange Load Game and Save Game menus
-	patchl = W_CacheLumpName(DEH_String("M_LOADG"), PU_CACHE);
-	patchs = W_CacheLumpName(DEH_String("M_SAVEG"), PU_CACHE);
-	patchm = W_CacheLumpName(DEH_String("M_LSLEFT"), PU_CACHE);
+	patchl = W_CacheLumpHandle(&lh_m_loadg, PU_CACHE);
+	patchs = W_CacheLumpHandle(&lh_m_saveg, PU_CACHE);
+	patchm = W_CacheLumpHandle(&lh_m_lsleft, PU_CACHE);
 
 	LoadDef_x = (ORIGWIDTH - SHORT(patchl->width)) / 2 + SHORT(patchl->leftoffset);
 	SaveDef_x = (ORIGWIDTH - SHORT(patchs->width)) / 2 + SHORT(patchs->leftoffset);
@@ -8175,7 +8195,7 @@ static void M_ConfirmDeleteGameResponse(boolean confirmed)
         char name[256];
 
         M_StringCopy(name, P_SaveGameFile(CurrentItPos), sizeof(name));
-        M_remove(name);
+        M_RemoveFileAsync(name);
         M_ReadSaveStrings();
     }
 }
@@ -24,6 +24,7 @@
 
 #include <SDL.h>
 #include "r_local.h"
+#include "memio.h"
 
 
 #define TOCENTER        -8
@@ -500,14 +501,13 @@ void P_SetupPsprites (player_t *player);
 #define VERSIONSIZE         16
 #define SAVESTRINGSIZE      24
 
-extern FILE *save_stream;
+extern MEMFILE *save_stream;
 extern boolean savegame_error;
 extern void M_ConfirmDeleteGame (void);
 
 boolean P_ReadSaveGameEOF (void);
 boolean P_ReadSaveGameHeader (void);
 char *P_SaveGameFile (int slot);
-char *P_TempSaveGameFile (void);
 thinker_t *P_IndexToThinker (uint32_t index);
 const uint32_t P_ThinkerToIndex (const thinker_t *thinker);
 void P_ArchiveAutomap (void);
@@ -581,6 +581,7 @@ side_t *getSide (const int currentSector, const int line, const int side);
 void P_CrossSpecialLine (const int linenum, const int side, mobj_t *thing);
 void P_CrossSpecialLinePtr (line_t *line, const int side, mobj_t *thing); // [crispy] more MBF code pointers
 void P_InitPicAnims (void);
+boolean P_IsSwirlingFlat (const int flatnum);
 void P_PlayerInSpecialSector (player_t *player);
 void P_ShootSpecialLine (const mobj_t *thing, line_t *line);
 void P_SpawnSpecials (void);
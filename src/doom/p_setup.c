@@ -2192,6 +2192,12 @@ void P_SetupLevel (const int episode, const int map, const skill_t skill)
 
     lumpnum = W_GetNumForName (lumpname);
 
+    // [JN] Have the map lumps read ahead while the level is being set up.
+    for (i = ML_THINGS ; i <= ML_BLOCKMAP ; i++)
+    {
+        W_WillNeedLump(lumpnum + i);
+    }
+
     // [JN] Checking for multiple map lump names for allowing map fixes to work.
     // Adaptaken from DOOM Retro, thanks Brad Harding!
     //  Fixes also should not work for: network game, shareware, IWAD versions below 1.9,
@@ -2304,6 +2310,9 @@ void P_SetupLevel (const int episode, const int map, const skill_t skill)
 
     // set up world state
     P_SpawnSpecials ();
+
+    // [JN] Generate all frames of swirling liquids used on the level.
+    R_PrecacheDistortedFlats ();
 	
     // preload graphics
     if (precache)
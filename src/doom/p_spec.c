@@ -226,6 +226,28 @@ void P_InitPicAnims (void)
 }
 
 
+// -----------------------------------------------------------------------------
+// P_IsSwirlingFlat
+// [JN] Returns true if given flat is animated by swirling effect instead of
+// flat sequence, i.e. it will be drawn with R_DistortedFlat.
+// -----------------------------------------------------------------------------
+
+boolean P_IsSwirlingFlat (const int flatnum)
+{
+    for (const anim_t *a = anims ; a < lastanim ; a++)
+    {
+        if (!a->istexture
+        && flatnum >= a->basepic && flatnum < a->basepic + a->numpics
+        && (a->speed > swirl_speed || a->numpics == 1))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
 // =============================================================================
 // UTILITIES
 // =============================================================================
@@ -108,6 +108,7 @@ struct texture_s
 {
     // Keep name for switch changing, etc.
     char  name[8];		
+    uint64_t key;		// [JN] Upper-cased name, see W_LumpNameKey
     short width;
     short height;
 
@@ -179,13 +180,13 @@ byte *green_blood_set;
 // Rewritten by Lee Killough for performance and to fix Medusa bug
 // -----------------------------------------------------------------------------
 
-static void R_DrawColumnInCache (column_t *patch, byte *cache, int originy,
+static void R_DrawColumnInCache (const column_t *patch, byte *cache, int originy,
                                  int cacheheight, byte *marks)
 {
     int   count;
     int   position;
     int   top = -1;
-    byte *source;
+    const byte *source;
 
     while (patch->topdelta != 0xff)
     {
@@ -199,7 +200,7 @@ static void R_DrawColumnInCache (column_t *patch, byte *cache, int originy,
             top = patch->topdelta;
         }
 
-        source = (byte *)patch + 3;
+        source = (const byte *)patch + 3;
         count = patch->length;
         position = originy + top;
 
@@ -225,7 +226,7 @@ static void R_DrawColumnInCache (column_t *patch, byte *cache, int originy,
             memset (marks + position, 0xff, count);
         }
 
-        patch = (column_t *)(  (byte *)patch + patch->length + 4); 
+        patch = (const column_t *)(  (const byte *)patch + patch->length + 4); 
     }
 }
 
@@ -247,8 +248,8 @@ static void R_GenerateComposite (int texnum)
     byte       *source; // killough 4/9/98: temporary column
     texture_t  *texture;
     texpatch_t *patch;	
-    patch_t    *realpatch;
-    column_t   *patchcol;
+    const patch_t  *realpatch;
+    const column_t *patchcol;
 
     texture = textures[texnum];
 
@@ -269,7 +270,7 @@ static void R_GenerateComposite (int texnum)
     // Composite the columns together.
     for (i = 0, patch = texture->patches; i < texture->patchcount ; i++, patch++)
     {
-        realpatch = W_CacheLumpNum (patch->patch, PU_STATIC);
+        realpatch = W_CacheLumpNumRO (patch->patch, PU_STATIC);
         x1 = patch->originx;
         x2 = x1 + SHORT(realpatch->width);
 
@@ -289,7 +290,7 @@ static void R_GenerateComposite (int texnum)
 
         for ( ; x < x2 ; x++)
         {
-            patchcol = (column_t *)((byte *)realpatch + LONG(realpatch->columnofs[x-x1]));
+            patchcol = (const column_t *)((const byte *)realpatch + LONG(realpatch->columnofs[x-x1]));
             R_DrawColumnInCache (patchcol,
 				                 block + colofs[x],
 				                 // [crispy] single-patched columns are normally not composited
@@ -298,6 +299,8 @@ static void R_GenerateComposite (int texnum)
 				                 texture->height,
 				                 marks + x * texture->height);
         }
+
+        W_ReleaseLumpNumRO(patch->patch);
     }
 
     // killough 4/9/98: Next, convert multipatched columns into true columns,
@@ -382,7 +385,7 @@ static void R_GenerateLookup (int texnum)
     byte       *patchcount;	// patchcount[texture->width]
     byte       *postcount;  // killough 4/9/98: keep count of posts in addition to patches.
     texpatch_t *patch;	
-    patch_t    *realpatch;
+    const patch_t *realpatch;
 
     texture = textures[texnum];
 
@@ -406,7 +409,7 @@ static void R_GenerateLookup (int texnum)
 
     for (i=0, patch = texture->patches ; i < texture->patchcount ; i++, patch++)
     {
-        realpatch = W_CacheLumpNum (patch->patch, PU_STATIC);
+        realpatch = W_CacheLumpNumRO (patch->patch, PU_STATIC);
         x1 = patch->originx;
         x2 = x1 + SHORT(realpatch->width);
 
@@ -430,6 +433,8 @@ static void R_GenerateLookup (int texnum)
             collump[x] = patch->patch;
             colofs[x] = LONG(realpatch->columnofs[x-x1])+3;
         }
+
+        W_ReleaseLumpNumRO(patch->patch);
     }
 
     // killough 4/9/98: keep a count of the number of posts in column,
@@ -452,7 +457,7 @@ static void R_GenerateLookup (int texnum)
         for (i = texture->patchcount, patch = texture->patches ; --i >= 0 ; )
         {
             int pat = patch->patch;
-            const patch_t *realpatch = W_CacheLumpNum(pat, PU_STATIC);
+            const patch_t *realpatch = W_CacheLumpNumRO(pat, PU_STATIC);
             int x, x1 = patch++->originx, x2 = x1 + SHORT(realpatch->width);
             const int *cofs = realpatch->columnofs - x1;
 
@@ -462,6 +467,7 @@ static void R_GenerateLookup (int texnum)
                         "\nR_GenerateLookup: Texture %.8s patch num %d (%.8s) is not valid" :
                         "\nR_GenerateLookup: некорректная текстура %.8s с номером патча %d (%.8s)",
                         texture->name, i, lumpinfo[pat]->name);
+                W_ReleaseLumpNumRO(pat);
                 continue;
             }
 
@@ -493,6 +499,8 @@ static void R_GenerateLookup (int texnum)
                     }
                 }
             }
+
+            W_ReleaseLumpNumRO(pat);
         }
     }
 
@@ -609,7 +617,7 @@ static void GenerateTextureHashTable(void)
         // wins. The new entry must therefore be added at the end
         // of the hash chain, so that earlier entries win.
 
-        key = W_LumpNameHash(textures[i]->name) % numtextures;
+        key = W_LumpKeyHash(textures[i]->key) % numtextures;
 
         rover = &textures_hashtable[key];
 
@@ -860,6 +868,7 @@ static void R_InitTextures (void)
         texture->patchcount = SHORT(mtexture->patchcount);
 
         memcpy (texture->name, mtexture->name, sizeof(texture->name));
+        texture->key = W_LumpNameKey(texture->name);
         mpatch = &mtexture->patches[0];
         patch = &texture->patches[0];
 
@@ -1058,11 +1067,6 @@ static void R_InitColormaps (void)
 // based in parts on the implementation from boom202s/R_DATA.C:676-787
 // -----------------------------------------------------------------------------
 
-enum {
-    r, g, b
-} rgb_t;
-
-
 static void R_InitTransMaps (void)
 {
     // [JN] Check if we have a modified PLAYPAL palette to decide
@@ -1098,82 +1102,13 @@ static void R_InitTransMaps (void)
         transtable10 = Z_Malloc(256*256, PU_STATIC, 0);
 
         {
-            byte *fg, *bg, blend[3];
-            byte *tp90 = transtable90;
-            byte *tp80 = transtable80;
-            byte *tp70 = transtable70;
-            byte *tp60 = transtable60;
-            byte *tp50 = transtable50;
-            byte *tp40 = transtable40;
-            byte *tp30 = transtable30;
-            byte *tp20 = transtable20;
-            byte *tp10 = transtable10;
-            int i, j;
-
-            // [crispy] background color
-            for (i = 0; i < 256; i++)
-            {
-                // [crispy] foreground color
-                for (j = 0; j < 256; j++)
-                {
-                    // [crispy] shortcut: identical foreground and background
-                    if (i == j)
-                    {
-                        *tp90++ = i; *tp80++ = i; *tp70++ = i;
-                        *tp60++ = i; *tp50++ = i; *tp40++ = i;
-                        *tp30++ = i; *tp20++ = i; *tp10++ = i;
-                        continue;
-                    }
+            byte *tables[TRANS_TABLES] = {
+                transtable10, transtable20, transtable30,
+                transtable40, transtable50, transtable60,
+                transtable70, transtable80, transtable90
+            };
 
-                    bg = playpal + 3*i;
-                    fg = playpal + 3*j;
-
-                    blend[r] = (90 * fg[r] + (100 - 90) * bg[r]) / 100;
-                    blend[g] = (90 * fg[g] + (100 - 90) * bg[g]) / 100;
-                    blend[b] = (90 * fg[b] + (100 - 90) * bg[b]) / 100;
-                    *tp90++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (80 * fg[r] + (100 - 80) * bg[r]) / 100;
-                    blend[g] = (80 * fg[g] + (100 - 80) * bg[g]) / 100;
-                    blend[b] = (80 * fg[b] + (100 - 80) * bg[b]) / 100;
-                    *tp80++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (70 * fg[r] + (100 - 70) * bg[r]) / 100;
-                    blend[g] = (70 * fg[g] + (100 - 70) * bg[g]) / 100;
-                    blend[b] = (70 * fg[b] + (100 - 70) * bg[b]) / 100;
-                    *tp70++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (60 * fg[r] + (100 - 60) * bg[r]) / 100;
-                    blend[g] = (60 * fg[g] + (100 - 60) * bg[g]) / 100;
-                    blend[b] = (60 * fg[b] + (100 - 60) * bg[b]) / 100;
-                    *tp60++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (50 * fg[r] + (100 - 50) * bg[r]) / 100;
-                    blend[g] = (50 * fg[g] + (100 - 50) * bg[g]) / 100;
-                    blend[b] = (50 * fg[b] + (100 - 50) * bg[b]) / 100;
-                    *tp50++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (40 * fg[r] + (100 - 40) * bg[r]) / 100;
-                    blend[g] = (40 * fg[g] + (100 - 40) * bg[g]) / 100;
-                    blend[b] = (40 * fg[b] + (100 - 40) * bg[b]) / 100;
-                    *tp40++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (30 * fg[r] + (100 - 30) * bg[r]) / 100;
-                    blend[g] = (30 * fg[g] + (100 - 30) * bg[g]) / 100;
-                    blend[b] = (30 * fg[b] + (100 - 30) * bg[b]) / 100;
-                    *tp30++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (20 * fg[r] + (100 - 20) * bg[r]) / 100;
-                    blend[g] = (20 * fg[g] + (100 - 20) * bg[g]) / 100;
-                    blend[b] = (20 * fg[b] + (100 - 20) * bg[b]) / 100;
-                    *tp20++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (10 * fg[r] + (100 - 10) * bg[r]) / 100;
-                    blend[g] = (10 * fg[g] + (100 - 10) * bg[g]) / 100;
-                    blend[b] = (10 * fg[b] + (100 - 10) * bg[b]) / 100;
-                    *tp10++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-                }
-            }
+            V_InitTransTables(playpal, tables);
         }
 
         W_ReleaseLumpName("PLAYPAL");
@@ -1234,6 +1169,7 @@ int R_FlatNumForName (char *name)
 int	R_CheckTextureNumForName (char *name)
 {
     int key;
+    uint64_t namekey;
     texture_t *texture;
 
     // "NoTexture" marker.
@@ -1242,12 +1178,13 @@ int	R_CheckTextureNumForName (char *name)
         return 0;
     }
 
-    key = W_LumpNameHash(name) % numtextures;
+    namekey = W_LumpNameKey(name);
+    key = W_LumpKeyHash(namekey) % numtextures;
     texture = textures_hashtable[key]; 
 
     while (texture != NULL)
     {
-        if (!strncasecmp (texture->name, name, 8))
+        if (texture->key == namekey)
         {
             return texture->index;
         }
@@ -1311,7 +1248,7 @@ void R_PrecacheLevel (void)
 
     for (i = numflats ; --i >= 0 ; )
         if (hitlist[i])
-            W_CacheLumpNum(firstflat + i, PU_CACHE);
+            W_WillNeedLump(firstflat + i);
 
     // Precache textures.
 
@@ -1338,7 +1275,7 @@ void R_PrecacheLevel (void)
             int j = texture->patchcount;
 
             while (--j >= 0)
-            W_CacheLumpNum(texture->patches[j].patch, PU_CACHE);
+            W_WillNeedLump(texture->patches[j].patch);
         }
 
     // Precache sprites.
@@ -1362,7 +1299,7 @@ void R_PrecacheLevel (void)
                 int k = 7;
 
                 do
-                W_CacheLumpNum(firstspritelump + sflump[k], PU_CACHE);
+                W_WillNeedLump(firstspritelump + sflump[k]);
                 while (--k >= 0);
             }
         }
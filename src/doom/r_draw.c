@@ -33,6 +33,20 @@
 #include "st_bar.h"
 #include "jn.h"
 
+// [JN] Lumps drawn every frame, looked up by name only once.
+
+static lumphandle_t lh_floor7_1 = LUMPHANDLE("FLOOR7_1");
+static lumphandle_t lh_grnrock = LUMPHANDLE("GRNROCK");
+static lumphandle_t lh_floor7_2 = LUMPHANDLE("FLOOR7_2");
+static lumphandle_t lh_brdr_t = LUMPHANDLE("brdr_t");
+static lumphandle_t lh_brdr_b = LUMPHANDLE("brdr_b");
+static lumphandle_t lh_brdr_l = LUMPHANDLE("brdr_l");
+static lumphandle_t lh_brdr_r = LUMPHANDLE("brdr_r");
+static lumphandle_t lh_brdr_tl = LUMPHANDLE("brdr_tl");
+static lumphandle_t lh_brdr_tr = LUMPHANDLE("brdr_tr");
+static lumphandle_t lh_brdr_bl = LUMPHANDLE("brdr_bl");
+static lumphandle_t lh_brdr_br = LUMPHANDLE("brdr_br");
+
 
 // Status bar height at bottom of screen
 #define SBARHEIGHT      (32 << hires)
@@ -1632,17 +1646,17 @@ void R_FillBackScreen (void)
     if (gamemission == jaguar)
     {
          // Jaguar Doom background.
-        backscreen_flat = W_CacheLumpName(DEH_String("FLOOR7_1"), PU_CACHE);
+        backscreen_flat = W_CacheLumpHandle(&lh_floor7_1, PU_CACHE);
     }
     else if (gamemode == commercial)
     {
         // DOOM II background.
-        backscreen_flat = W_CacheLumpName(DEH_String("GRNROCK"), PU_CACHE);
+        backscreen_flat = W_CacheLumpHandle(&lh_grnrock, PU_CACHE);
     }
     else
     {
         // DOOM background.
-        backscreen_flat = W_CacheLumpName(DEH_String("FLOOR7_2"), PU_CACHE);
+        backscreen_flat = W_CacheLumpHandle(&lh_floor7_2, PU_CACHE);
     }
 
     // If we are running full screen, there is no need to do any of this,
@@ -1688,7 +1702,7 @@ void R_FillBackScreen (void)
 
     V_UseBuffer(background_buffer);
 
-    patch = W_CacheLumpName(DEH_String("brdr_t"),PU_CACHE);
+    patch = W_CacheLumpHandle(&lh_brdr_t, PU_CACHE);
 
     for (x = 0 ; x < (scaledviewwidth >> hires) ; x += 8)
     {
@@ -1696,7 +1710,7 @@ void R_FillBackScreen (void)
                     (viewwindowy >> hires)-8, patch, NULL);
     }
 
-    patch = W_CacheLumpName(DEH_String("brdr_b"), PU_CACHE);
+    patch = W_CacheLumpHandle(&lh_brdr_b, PU_CACHE);
 
     for (x = 0 ; x < (scaledviewwidth >> hires) ; x += 8)
     {
@@ -1704,7 +1718,7 @@ void R_FillBackScreen (void)
                     (viewwindowy >> hires)+(scaledviewheight >> hires), patch, NULL);
     }
 
-    patch = W_CacheLumpName(DEH_String("brdr_l"), PU_CACHE);
+    patch = W_CacheLumpHandle(&lh_brdr_l, PU_CACHE);
 
     for (y = 0 ; y < (scaledviewheight >> hires) ; y += 8)
     {
@@ -1712,7 +1726,7 @@ void R_FillBackScreen (void)
                     (viewwindowy >> hires)+y, patch, NULL);
     }
 
-    patch = W_CacheLumpName(DEH_String("brdr_r"), PU_CACHE);
+    patch = W_CacheLumpHandle(&lh_brdr_r, PU_CACHE);
 
     for (y = 0 ; y < (scaledviewheight >> hires); y += 8)
     {
@@ -1723,19 +1737,19 @@ void R_FillBackScreen (void)
     // Draw beveled edge. 
     V_DrawPatch((viewwindowx >> hires)-8,
                 (viewwindowy >> hires)-8,
-                W_CacheLumpName(DEH_String("brdr_tl"), PU_CACHE), NULL);
+                W_CacheLumpHandle(&lh_brdr_tl, PU_CACHE), NULL);
 
     V_DrawPatch((viewwindowx >> hires)+(scaledviewwidth >> hires),
                 (viewwindowy >> hires)-8,
-                W_CacheLumpName(DEH_String("brdr_tr"), PU_CACHE), NULL);
+                W_CacheLumpHandle(&lh_brdr_tr, PU_CACHE), NULL);
 
     V_DrawPatch((viewwindowx >> hires)-8,
                 (viewwindowy >> hires)+(scaledviewheight >> hires),
-                W_CacheLumpName(DEH_String("brdr_bl"), PU_CACHE), NULL);
+                W_CacheLumpHandle(&lh_brdr_bl, PU_CACHE), NULL);
 
     V_DrawPatch((viewwindowx >> hires)+(scaledviewwidth >> hires),
                 (viewwindowy >> hires)+(scaledviewheight >> hires),
-                W_CacheLumpName(DEH_String("brdr_br"), PU_CACHE), NULL);
+                W_CacheLumpHandle(&lh_brdr_br, PU_CACHE), NULL);
 
     V_RestoreBuffer();
 }
@@ -648,7 +648,7 @@ extern int  viewwidth, viewheight;
 extern int  scaledviewwidth, scaledviewheight;
 extern int *flipscreenwidth;
 extern int *flipviewwidth;
-extern int  firstflat;
+extern int  firstflat, numflats;
 extern int *flattranslation, *texturetranslation;
 extern int  firstspritelump, lastspritelump, numspritelumps;
 
@@ -724,6 +724,7 @@ extern fixed_t FallFactor_104, FallFactor_104_old;
 
 const char *R_DistortedFlat (const int flatnum);
 void R_InitDistortedFlats (void);
+void R_PrecacheDistortedFlats (void);
 void R_FallLinedef (void);
 
 // -----------------------------------------------------------------------------
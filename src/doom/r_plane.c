@@ -454,7 +454,7 @@ void R_DrawPlanes (void)
 
             // [crispy] add support for SMMU swirling flats
             ds_source = (flattranslation[pl->picnum] == -1) ?
-                         R_DistortedFlat(pl->picnum) : W_CacheLumpNum(lumpnum, PU_STATIC);
+                         R_DistortedFlat(pl->picnum) : W_CacheLumpNumRO(lumpnum, PU_STATIC);
             ds_brightmap = R_BrightmapForFlatNum(lumpnum-firstflat);
 
             // [JN] Apply flow effect to swirling liquids.
@@ -488,7 +488,7 @@ void R_DrawPlanes (void)
             // [crispy] add support for SMMU swirling flats
             if (flattranslation[pl->picnum] != -1)
             {
-                W_ReleaseLumpNum(lumpnum);
+                W_ReleaseLumpNumRO(lumpnum);
             }
         }
     }
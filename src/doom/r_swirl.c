@@ -21,11 +21,16 @@
 
 // [crispy] adapted from smmu/r_ripple.c, by Simon Howard
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "doomstat.h"
 #include "i_system.h"
 #include "w_wad.h"
 #include "z_zone.h"
 #include "r_local.h"
+#include "p_local.h"
+#include "jn.h"
 
 // swirl factors determine the number of waves per flat width
 
@@ -89,12 +94,156 @@ void R_InitDistortedFlats (void)
 	}
 }
 
+// -----------------------------------------------------------------------------
+// [JN] Precomputed swirling flat frames.
+//
+// Every swirling flat used in the level gets all SEQUENCE frames of its
+// animation generated at level load time, so R_DistortedFlat only needs to
+// pick a frame pointer instead of remapping 64x64 pixels. Memory used by
+// this cache is bounded by "swirl_cache_size" (in MiB, 0 = disabled),
+// flats which do not fit are still distorted on the fly.
+// -----------------------------------------------------------------------------
+
+#define SWIRLFRAMES_SIZE (SEQUENCE * FLATSIZE)
+
+static byte **swirlframes;    // [numflats] precomputed frames or NULL
+static int    swirlframes_num;
+
+// -----------------------------------------------------------------------------
+// R_FreeDistortedFlatsCache
+// -----------------------------------------------------------------------------
+
+static void R_FreeDistortedFlatsCache (void)
+{
+    if (!swirlframes)
+    {
+        return;
+    }
+
+    for (int i = 0 ; i < swirlframes_num ; i++)
+    {
+        free(swirlframes[i]);
+        swirlframes[i] = NULL;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// R_ShutdownDistortedFlats
+// -----------------------------------------------------------------------------
+
+static void R_ShutdownDistortedFlats (void)
+{
+    R_FreeDistortedFlatsCache();
+    free(swirlframes);
+    swirlframes = NULL;
+    swirlframes_num = 0;
+}
+
+// -----------------------------------------------------------------------------
+// R_PrecacheDistortedFlats
+// Generates all frames of swirling flats used by sectors of current level.
+// Flats which sectors may change to later are distorted on the fly.
+// -----------------------------------------------------------------------------
+
+void R_PrecacheDistortedFlats (void)
+{
+    const size_t budget = (size_t) MAX(swirl_cache_size, 0) * 1024 * 1024;
+    size_t used = 0;
+    int    cached = 0;
+    byte  *hitlist;
+
+    R_FreeDistortedFlatsCache();
+
+    if (!offsets || !swirling_liquids || vanillaparm || budget < SWIRLFRAMES_SIZE)
+    {
+        return;
+    }
+
+    if (swirlframes_num != numflats)
+    {
+        if (!swirlframes)
+        {
+            I_AtExit(R_ShutdownDistortedFlats, true);
+        }
+
+        swirlframes = I_Realloc(swirlframes, numflats * sizeof(*swirlframes));
+        memset(swirlframes, 0, numflats * sizeof(*swirlframes));
+        swirlframes_num = numflats;
+    }
+
+    hitlist = Z_Malloc(numflats, PU_STATIC, NULL);
+    memset(hitlist, 0, numflats);
+
+    for (int i = 0 ; i < numsectors ; i++)
+    {
+        hitlist[sectors[i].floorpic] = hitlist[sectors[i].ceilingpic] = 1;
+    }
+
+    for (int i = 0 ; i < numflats ; i++)
+    {
+        const byte *normalflat;
+        const int  *ofs = offsets;
+        byte       *frame;
+
+        if (!hitlist[i] || !P_IsSwirlingFlat(i))
+        {
+            continue;
+        }
+
+        if (used + SWIRLFRAMES_SIZE > budget)
+        {
+            break;
+        }
+
+        frame = malloc(SWIRLFRAMES_SIZE);
+
+        if (!frame)
+        {
+            break;
+        }
+
+        normalflat = W_CacheLumpNum(firstflat + i, PU_LEVEL);
+
+        for (int j = 0 ; j < SWIRLFRAMES_SIZE ; j++)
+        {
+            frame[j] = normalflat[ofs[j]];
+        }
+
+        W_ReleaseLumpNum(firstflat + i);
+
+        swirlframes[i] = frame;
+        used += SWIRLFRAMES_SIZE;
+        cached++;
+    }
+
+    Z_Free(hitlist);
+
+    if (devparm && cached)
+    {
+        printf(english_language ?
+               "R_PrecacheDistortedFlats: %d flats, %d KiB\n" :
+               "R_PrecacheDistortedFlats: %d текстур, %d Кб\n",
+               cached, (int) (used / 1024));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// R_DistortedFlat
+// -----------------------------------------------------------------------------
+
 const char *R_DistortedFlat (const int flatnum)
 {
 	static int swirltic = -1;
 	static int swirlflat = -1;
 	static char distortedflat[FLATSIZE];
 
+	// [JN] Precomputed frame is available, just pick it.
+	if (swirlframes && swirlframes[flatnum])
+	{
+		return (const char *) swirlframes[flatnum]
+		     + (leveltime & (SEQUENCE - 1)) * FLATSIZE;
+	}
+
 	if (swirltic != leveltime)
 	{
 		offset = offsets + ((leveltime & (SEQUENCE - 1)) * FLATSIZE);
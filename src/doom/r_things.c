@@ -461,12 +461,12 @@ void R_DrawMaskedColumn (const column_t *column)
 
 static void R_DrawVisSprite (const vissprite_t *vis, const int x1, const int x2)
 {
-    column_t *column;
+    const column_t *column;
     int       texturecolumn;
     fixed_t   frac;
-    patch_t  *patch;
+    const patch_t *patch;
 
-    patch = W_CacheLumpNum (vis->patch+firstspritelump, PU_CACHE);
+    patch = W_CacheLumpNumRO (vis->patch+firstspritelump, PU_CACHE);
 
     // [crispy] brightmaps for select sprites
     dc_colormap[0] = vis->colormap[0];
@@ -523,7 +523,7 @@ static void R_DrawVisSprite (const vissprite_t *vis, const int x1, const int x2)
                             "R_DrawVisSprite: bad texturecolumn" :
                             "R_DrawVisSprite: некорректныая информация texturecolumn");
 #endif
-        column = (column_t *) ((byte *)patch + LONG(patch->columnofs[texturecolumn]));
+        column = (const column_t *) ((const byte *)patch + LONG(patch->columnofs[texturecolumn]));
         R_DrawMaskedColumn (column);
     }
 
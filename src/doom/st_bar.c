@@ -40,6 +40,10 @@
 #include "v_diskicon.h"
 #include "jn.h"
 
+// [JN] Lumps drawn every frame, looked up by name only once.
+
+static lumphandle_t lh_brdr_b = LUMPHANDLE("brdr_b");
+
 
 // Palette indices. For damage/bonus red-/gold-shifts
 #define STARTREDPALS        1
@@ -830,7 +834,7 @@ static void ST_DrawBackground (void)
         byte *src;
         byte *dest = st_backing_screen;
         const int shift_allowed = vanillaparm ? 1 : hud_detaillevel;
-        const patch_t *const patch = W_CacheLumpName(DEH_String("brdr_b"), PU_CACHE);
+        const patch_t *const patch = W_CacheLumpHandle(&lh_brdr_b, PU_CACHE);
         char *name = gamemission == jaguar ? DEH_String("FLOOR7_1") :  // Jaguar Doom
                     gamemode == commercial ? DEH_String("GRNROCK")  :  // Doom 2
                                              DEH_String("FLOOR7_2") ;  // Doom 1
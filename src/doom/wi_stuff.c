@@ -35,6 +35,10 @@
 #include "rd_text.h"
 #include "jn.h"
 
+// [JN] Lumps drawn every frame, looked up by name only once.
+
+static lumphandle_t lh_wiartof = LUMPHANDLE("WIARTOF");
+
 static void (*WI_drawStatsFunc) (void);
 static void (*WI_updateStatsFunc) (void);
 
@@ -1756,7 +1760,7 @@ static void WI_drawStats (void)
             WI_drawNum(origwidth - 78, SP_STATSY+3*lh, artifactcount, -1);
 
             // [JN] Draw "из" patch ("of")
-            V_DrawShadowedPatchDoom((origwidth - 76)-wide_delta, SP_STATSY+3*lh, W_CacheLumpName(DEH_String("WIARTOF"), PU_CACHE));
+            V_DrawShadowedPatchDoom((origwidth - 76)-wide_delta, SP_STATSY+3*lh, W_CacheLumpHandle(&lh_wiartof, PU_CACHE));
             // [JN] Overall amount of artifacts, different for each level
             if (gameepisode == 1 && gamemap == 1)
             WI_drawNum(origwidth - 39, SP_STATSY+3*lh, 36, 2);  // Map 1: 36 artifacts
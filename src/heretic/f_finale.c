@@ -27,6 +27,11 @@
 #include "v_video.h"
 #include "jn.h"
 
+// [JN] Lumps drawn every frame, looked up by name only once.
+
+static lumphandle_t lh_e2end = LUMPHANDLE("E2END");
+static lumphandle_t lh_title = LUMPHANDLE("TITLE");
+
 
 // Macros
 
@@ -412,7 +417,7 @@ static void F_DrawUnderwater (void)
                 }
                 else
                 {
-                    V_DrawRawScreen(W_CacheLumpName(DEH_String("E2END"), PU_CACHE));
+                    V_DrawRawScreen(W_CacheLumpHandle(&lh_e2end, PU_CACHE));
                 }
             }
             paused = false;
@@ -445,7 +450,7 @@ static void F_DrawUnderwater (void)
                 }
                 else
                 {
-                    V_DrawRawScreen(W_CacheLumpName(DEH_String("TITLE"), PU_CACHE));
+                    V_DrawRawScreen(W_CacheLumpHandle(&lh_title, PU_CACHE));
                 }
             }
             else
@@ -28,6 +28,7 @@
 #include "m_misc.h"
 #include "p_local.h"
 #include "rd_keybinds.h"
+#include "rd_rewind.h"
 #include "s_sound.h"
 #include "v_video.h"
 #include "jn.h"
@@ -48,6 +49,12 @@ static void G_DoPlayDemo (void);
 static void G_DoCompleted (void);
 static void G_DoWorldDone (void);
 static void G_DoSaveGame (void);
+static boolean G_ReadGameState (void);
+static void G_WriteGameState (char *description);
+static void G_DoRewind (void);
+static void G_StoreRewindSnapshot (void);
+
+static boolean rewinding;  // [JN] level is being reloaded by G_DoRewind
 
 static struct
 {
@@ -747,6 +754,12 @@ static void G_DoLoadLevel (void)
     gameaction = ga_nothing;
     Z_CheckHeap();
 
+    // [JN] Snapshots of the previous level can't be rewound to.
+    if (!rewinding)
+    {
+        RW_Clear();
+    }
+
 //
 // clear cmd building stuff
 //
@@ -957,6 +970,13 @@ boolean G_Responder(event_t * ev)
         sendpause = true;
         return true;
     }
+    // [JN] Step back in time, single player only.
+    if (BK_isKeyDown(ev, bk_rewind) && gamestate == GS_LEVEL && !menuactive
+    && gameaction == ga_nothing && !netgame && !demorecording && RW_Available())
+    {
+        gameaction = ga_rewind;
+        return true;
+    }
 
     switch (ev->type)
     {
@@ -990,6 +1010,41 @@ boolean G_Responder(event_t * ev)
     return (false);
 }
 
+//==========================================================================
+//
+// G_CheckSaveGameWritten
+//
+// [JN] Savegames are written in background, so the message is shown
+// once the file is written, or the write has failed.
+//
+//==========================================================================
+
+static boolean savemessage_pending;
+
+static void G_CheckSaveGameWritten (void)
+{
+    if (!savemessage_pending)
+    {
+        return;
+    }
+
+    switch (M_GetSaveGameStatus())
+    {
+        case SAVEGAME_PENDING:
+            return;
+
+        case SAVEGAME_FAILED:
+            P_SetMessage(&players[consoleplayer], DEH_String(txt_gamesavefailed), msg_system, false);
+            break;
+
+        default:
+            P_SetMessage(&players[consoleplayer], DEH_String(txt_gamesaved), msg_system, false);
+            break;
+    }
+
+    savemessage_pending = false;
+}
+
 /*
 ===============================================================================
 =
@@ -1010,6 +1065,8 @@ void G_Ticker(void)
         if (playeringame[i] && players[i].playerstate == PST_REBORN)
             G_DoReborn(i);
 
+    G_CheckSaveGameWritten();
+
 //
 // do things to change the game state
 //
@@ -1045,6 +1102,9 @@ void G_Ticker(void)
             case ga_savegame:
                 G_DoSaveGame();
                 break;
+            case ga_rewind:
+                G_DoRewind();
+                break;
             case ga_playdemo:
                 G_DoPlayDemo();
                 break;
@@ -1193,6 +1253,11 @@ void G_Ticker(void)
             {
                 CT_Ticker();
             }
+            if (!netgame && !demoplayback && !demorecording
+            && gameaction == ga_nothing && RW_SnapshotDue(leveltime))
+            {
+                G_StoreRewindSnapshot();
+            }
             break;
         case GS_INTERMISSION:
             IN_Ticker();
@@ -1627,23 +1692,50 @@ void G_LoadGame(char *name)
 //
 //---------------------------------------------------------------------------
 
-#define VERSIONSIZE 16
-
 void G_DoLoadGame(void)
 {
-    int i;
-    int a, b, c;
-    int d, e, f;
-    char savestr[SAVESTRINGSIZE];
-    char vcheck[VERSIONSIZE], readversion[VERSIONSIZE];
+    boolean opened;
 
     gameaction = ga_nothing;
 
-    SV_OpenRead(savename);
+    opened = SV_OpenRead(savename);
 
     free(savename);
     savename = NULL;
 
+    if (!opened)
+    {                           // Missing or corrupted file
+        return;
+    }
+
+    if (!G_ReadGameState())
+    {                           // Bad version
+        SV_CloseRead();
+        return;
+    }
+
+    SV_CloseRead();
+
+    P_SetMessage(&players[consoleplayer], DEH_String(txt_gameloaded), msg_system, false);
+}
+
+//---------------------------------------------------------------------------
+//
+// FUNC G_ReadGameState
+//
+// [JN] Reads the game state opened by SV_OpenRead or SV_OpenReadSnapshot
+// and loads the level. Returns false if the version doesn't match.
+//
+//---------------------------------------------------------------------------
+
+static boolean G_ReadGameState(void)
+{
+    int i;
+    int a, b, c;
+    int d, e, f;
+    char savestr[SAVESTRINGSIZE];
+    char vcheck[VERSIONSIZE], readversion[VERSIONSIZE];
+
     // Skip the description field
     SV_Read(savestr, SAVESTRINGSIZE);
 
@@ -1653,7 +1745,7 @@ void G_DoLoadGame(void)
 
     if (strncmp(readversion, vcheck, VERSIONSIZE) != 0)
     {   // Bad version
-        return;
+        return false;
     }
     gameskill = SV_ReadByte();
     gameepisode = SV_ReadByte();
@@ -1699,7 +1791,7 @@ void G_DoLoadGame(void)
                         "Некорректный файл сохранения");
     }
 
-    P_SetMessage(&players[consoleplayer], DEH_String(txt_gameloaded), msg_system, false);
+    return true;
 }
 
 
@@ -2423,16 +2515,36 @@ void G_SaveGame(int slot, char *description)
 
 static void G_DoSaveGame (void)
 {
-    int i;
     char *filename;
-    char verString[VERSIONSIZE];
-    char *description;
 
     filename = SV_Filename(savegameslot);
 
-    description = savedescription;
-
     SV_Open(filename);
+    G_WriteGameState(savedescription);
+    M_GetSaveGameStatus();  // drop result of earlier writes
+    SV_Close(filename);
+
+    gameaction = ga_nothing;
+    savedescription[0] = 0;
+    savemessage_pending = true;
+
+    free(filename);
+}
+
+//==========================================================================
+//
+// G_WriteGameState
+//
+// [JN] Writes the game state into the stream opened by SV_Open.
+// Description must be at least SAVESTRINGSIZE bytes long.
+//
+//==========================================================================
+
+static void G_WriteGameState (char *description)
+{
+    int i;
+    char verString[VERSIONSIZE];
+
     SV_Write(description, SAVESTRINGSIZE);
     memset(verString, 0, sizeof(verString));
     DEH_snprintf(verString, VERSIONSIZE, "version %i", HERETIC_VERSION);
@@ -2458,12 +2570,73 @@ static void G_DoSaveGame (void)
     P_ArchiveThinkers();
     P_ArchiveSpecials();
     P_ArchiveAutomap ();
-    SV_Close(filename);
+}
+
+//==========================================================================
+//
+// G_StoreRewindSnapshot
+//
+// [JN] Serializes the level into the rewind buffer instead of the disk.
+//
+//==========================================================================
+
+static void G_StoreRewindSnapshot (void)
+{
+    static char nodescription[SAVESTRINGSIZE];
+    const uint64_t start = I_GetTimeUS();
+
+    SV_Open(NULL);
+    G_WriteGameState(nodescription);
+    SV_CloseSnapshot(leveltime, start);
+}
+
+//==========================================================================
+//
+// G_DoRewind
+//
+// [JN] Restores the previous snapshot from the rewind buffer.
+//
+//==========================================================================
+
+static void G_DoRewind (void)
+{
+    player_t *player = &players[consoleplayer];
+    byte *snapshot;
+    size_t length;
+    int tic;
+    int i;
 
     gameaction = ga_nothing;
-    savedescription[0] = 0;
-    P_SetMessage(&players[consoleplayer], DEH_String(txt_gamesaved), msg_system, false);
 
-    free(filename);
+    snapshot = RW_Restore(leveltime, &length, &tic);
+
+    if (snapshot == NULL)
+    {
+        return;
+    }
+
+    SV_OpenReadSnapshot(snapshot, length);
+
+    rewinding = true;
+    G_ReadGameState();
+    rewinding = false;
+
+    SV_CloseRead();
+
+    // [JN] Reset counters for missing key fading effects.
+    player->yellowkeyTics = 0;
+    player->greenkeyTics = 0;
+    player->bluekeyTics = 0;
+    // [Dasperal] Init inv_ptr
+    for (i = 0; i < player->inventorySlotNum; i++)
+    {
+        if (player->inventory[i].type == player->readyArtifact)
+        {
+            inv_ptr = i;
+            break;
+        }
+    }
+
+    P_SetMessage(player, DEH_String(txt_rewound), msg_system, false);
 }
 
@@ -354,7 +354,8 @@ typedef enum
     ga_completed,
     ga_victory,
     ga_worlddone,
-    ga_screenshot
+    ga_screenshot,
+    ga_rewind       // [JN] Step back to the previous in-memory snapshot
 } gameaction_t;
 
 /*
@@ -48,6 +48,7 @@
 #include "m_misc.h"
 #include "p_local.h"
 #include "rd_keybinds.h"
+#include "rd_rewind.h"
 #include "s_sound.h"
 #include "w_main.h"
 #include "v_video.h"
@@ -1162,6 +1163,10 @@ void D_BindVariables(void)
     M_BindIntVariable("demobar",                &demobar);
     M_BindIntVariable("no_internal_demos",      &no_internal_demos);
 
+    // Gameplay: Rewind
+    M_BindIntVariable("rewind_depth",           &rewind_depth);
+    M_BindIntVariable("rewind_interval",        &rewind_interval);
+
     for (i=0; i<10; ++i)
     {
         char buf[12];
@@ -1452,6 +1457,9 @@ void D_DoomMain(void)
                "V_Init: Инициализация видео.\n");
     V_Init();
 
+    // [JN] Rewind buffer, depth may be given by "-rewind".
+    RW_Init();
+
     I_AtExit(M_SaveConfig, true); // [crispy] always save configuration at exit
 
     DEH_printf(english_language ?
@@ -111,6 +111,8 @@ char* txt_secret_found;
 
 // G_game.c
 char* txt_gamesaved;
+char* txt_gamesavefailed;
+char* txt_rewound;
 char* txt_gameloaded;
 char* txt_testcontrols;
 
@@ -357,6 +359,8 @@ void RD_DefineLanguageStrings (void)
 
         // G_game.c
         txt_gamesaved          = TXT_GAMESAVED;
+        txt_gamesavefailed     = TXT_GAMESAVEFAILED;
+        txt_rewound            = TXT_REWOUND;
         txt_gameloaded         = TXT_GAMELOADED;
         txt_testcontrols       = TXT_TESTCONTROLS;
 
@@ -483,6 +487,8 @@ void RD_DefineLanguageStrings (void)
 
         // G_game.c
         txt_gamesaved          = TXT_GAMESAVED_RUS;
+        txt_gamesavefailed     = TXT_GAMESAVEFAILED_RUS;
+        txt_rewound            = TXT_REWOUND_RUS;
         txt_gameloaded         = TXT_GAMELOADED_RUS;
         txt_testcontrols       = TXT_TESTCONTROLS_RUS;
 
@@ -119,6 +119,8 @@ extern char* txt_secret_found;
 
 // G_game.c
 extern char* txt_gamesaved;
+extern char* txt_gamesavefailed;
+extern char* txt_rewound;
 extern char* txt_gameloaded;
 extern char* txt_testcontrols;
 
@@ -250,6 +252,8 @@ extern char* txt_mlook_off;
 
 // G_game.c
 #define TXT_GAMESAVED           "GAME SAVED"
+#define TXT_GAMESAVEFAILED      "GAME SAVE FAILED"
+#define TXT_REWOUND             "REWOUND"
 #define TXT_GAMELOADED          "GAME LOADED"
 #define TXT_TESTCONTROLS        "PRESS ESCAPE TO QUIT"
 
@@ -481,6 +485,8 @@ extern char* txt_mlook_off;
 
 // G_game.c
 #define TXT_GAMESAVED_RUS       "BUHF CJ[HFYTYF"    // ИГРА СОХРАНЕНА
+#define TXT_GAMESAVEFAILED_RUS  "JIB,RF CJ[HFYTYBZ" // ОШИБКА СОХРАНЕНИЯ
+#define TXT_REWOUND_RUS         "GTHTVJNFYJ YFPFL"  // ПЕРЕМОТАНО НАЗАД
 #define TXT_GAMELOADED_RUS      "BUHF PFUHE;TYF"    // ИГРА ЗАГРУЖЕНА
 #define TXT_TESTCONTROLS_RUS    "HT;BV GHJDTHRB EGHFDKTYBZ"     // РЕЖИМ ПРОВЕРКИ УПРАВЛЕНИЯ
 
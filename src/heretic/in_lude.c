@@ -26,6 +26,10 @@
 #include "v_video.h"
 #include "jn.h"
 
+// [JN] Lumps looked up by name only once.
+
+static lumphandle_t lh_playpal = LUMPHANDLE("PLAYPAL");
+
 
 // Private functions
 
@@ -142,7 +146,7 @@ static const yahpt_t YAHspot[3][9] = {
 
 void IN_Start (void)
 {
-    I_SetPalette(W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE));
+    I_SetPalette(W_CacheLumpHandle(&lh_playpal, PU_CACHE));
     IN_LoadPics();
     IN_InitStats();
     intermission = true;
@@ -37,6 +37,12 @@
 #include "v_video.h"
 #include "jn.h"
 
+// [JN] Lumps drawn every frame, looked up by name only once.
+
+static lumphandle_t lh_m_htic = LUMPHANDLE("M_HTIC");
+static lumphandle_t lh_m_fslot = LUMPHANDLE("M_FSLOT");
+static lumphandle_t lh_m_colors = LUMPHANDLE("M_COLORS");
+
 // Macros
 #define ITEM_HEIGHT 20
 #define SLOTTEXTLEN     22
@@ -957,7 +963,7 @@ static MenuItem_t Bindings4Items[] = {
     I_EFUNC("RESTART LEVEL/DEMO", "GTHTPFGECR EHJDYZ",   BK_StartBindingKey, bk_reloadlevel), // Перезапуск уровня
     I_EFUNC("Increase screen size",  "edtk> hfpvth 'rhfyf",   BK_StartBindingKey, bk_screen_inc),       // Увел. размер экрана
     I_EFUNC("Decrease screen size",  "evtym> hfpvth 'rhfyf",  BK_StartBindingKey, bk_screen_dec),       // Умень. размер экрана
-    I_EMPTY,
+    I_EFUNC("REWIND",                "GTHTVJNRF YFPFL",       BK_StartBindingKey, bk_rewind),           // Перемотка назад
     I_SETMENU("NEXT PAGE >", "CKTLE.OFZ CNHFYBWF `",  &Bindings5Menu), // Cледующая страница >
     I_SETMENU("< PREV PAGE", "^ GHTLSLEOFZ CNHFYBWF", &Bindings3Menu), // < Предыдущая страница
     I_EMPTY
@@ -1829,7 +1835,7 @@ static void DrawMainMenu(void)
 
     frame = (MenuTime / 3) % 18;
     V_DrawShadowedPatchRaven(88 + wide_delta, 0,
-                             W_CacheLumpName(DEH_String("M_HTIC"), PU_CACHE));
+                             W_CacheLumpHandle(&lh_m_htic, PU_CACHE));
     V_DrawShadowedPatchRaven(40 + wide_delta, 10,
                              W_CacheLumpNum(SkullBaseLump + (17 - frame), PU_CACHE));
     V_DrawShadowedPatchRaven(232 + wide_delta, 10,
@@ -1912,6 +1918,9 @@ static void MN_LoadSlotText(void)
     int i;
     char *filename;
 
+    // [JN] Let pending saves and removals reach the disk first.
+    M_FlushFileWrites();
+
     for (i = 0; i < 7; i++)
     {
         filename = SV_Filename(i);
@@ -1948,7 +1957,7 @@ static void DrawFileSlots()
     for (i = 0; i < 7; i++)
     {
         V_DrawShadowedPatchRaven(x + wide_delta, y,
-                                 W_CacheLumpName(DEH_String("M_FSLOT"), PU_CACHE));
+                                 W_CacheLumpHandle(&lh_m_fslot, PU_CACHE));
         if (SlotStatus[i])
         {
             // [JN] Use only small English chars here
@@ -2619,7 +2628,7 @@ static void DrawColorMenu(void)
 
     if (show_palette)
     {
-        V_DrawPatchUnscaled(wide_delta*2, 200, W_CacheLumpName(DEH_String("M_COLORS"), PU_CACHE), NULL);
+        V_DrawPatchUnscaled(wide_delta*2, 200, W_CacheLumpHandle(&lh_m_colors, PU_CACHE), NULL);
     }
 }
 
@@ -6427,7 +6436,7 @@ boolean MN_Responder(event_t * event)
                 {
                     // Find name of saved game file.
                     name = SV_Filename(CurrentItPos);
-                    M_remove(name);
+                    M_RemoveFileAsync(name);
                     free(name);
                     // Truncate text of saved game slot.
                     memset(SlotText[CurrentItPos], 0, SLOTTEXTLEN + 2);
@@ -368,6 +368,7 @@ extern void P_UseLines(player_t * player);
 
 #define SAVEGAMESIZE          0x30000
 #define SAVESTRINGSIZE        24
+#define VERSIONSIZE           16
 #define SAVE_GAME_TERMINATOR  0x1d
 #define	SAVEGAMENAME          "heretic-save-"
 
@@ -383,8 +384,11 @@ extern char *SV_Filename (int slot);
 extern uint16_t SV_ReadWord (void);
 extern uint32_t SV_ReadLong (void);
 extern void SV_Close (char *fileName);
+extern void SV_CloseRead (void);
 extern void SV_Open (char *fileName);
-extern void SV_OpenRead (char *fileName);
+extern boolean SV_OpenRead (char *fileName);
+extern void SV_OpenReadSnapshot (byte *buffer, size_t length);
+extern void SV_CloseSnapshot (int tic, uint64_t start_us);
 extern void SV_Read (void *buffer, int size);
 extern void SV_Write (void *buffer, int size);
 extern void SV_WriteByte (byte val);
@@ -24,12 +24,16 @@
 #include "hr_local.h"
 #include "i_swap.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_misc.h"
+#include "memio.h"
 #include "p_local.h"
+#include "rd_rewind.h"
 #include "v_video.h"
 #include "jn.h"
 
-static FILE *SaveGameFP;
+static MEMFILE *SaveGameFP;
+static byte *SaveGameBuffer;
 
 
 //==========================================================================
@@ -58,16 +62,38 @@ char *SV_Filename(int slot)
 //
 // SV_Open
 //
+// [JN] Savegames are serialized into memory, then compressed and written
+// in background. Reading inflates the whole file at once, uncompressed
+// savegames of older versions are read as is.
+//
 //==========================================================================
 
 void SV_Open(char *fileName)
 {
-    SaveGameFP = M_fopen(fileName, "wb");
+    SaveGameFP = mem_fopen_write();
 }
 
-void SV_OpenRead(char *filename)
+boolean SV_OpenRead(char *filename)
 {
-    SaveGameFP = M_fopen(filename, "rb");
+    size_t length;
+
+    SaveGameBuffer = M_ReadSaveGame(filename, SAVESTRINGSIZE + VERSIONSIZE,
+                                    &length);
+
+    if (SaveGameBuffer == NULL)
+    {
+        return false;
+    }
+
+    SaveGameFP = mem_fopen_read(SaveGameBuffer, length);
+    return true;
+}
+
+// [JN] Reads a rewind snapshot, the buffer is owned by the rewind buffer.
+void SV_OpenReadSnapshot(byte *buffer, size_t length)
+{
+    SaveGameBuffer = NULL;
+    SaveGameFP = mem_fopen_read(buffer, length);
 }
 
 //==========================================================================
@@ -78,9 +104,41 @@ void SV_OpenRead(char *filename)
 
 void SV_Close(char *fileName)
 {
+    void *buffer;
+    size_t length;
+
     SV_WriteByte(SAVE_GAME_TERMINATOR);
 
-    fclose(SaveGameFP);
+    mem_get_buf(SaveGameFP, &buffer, &length);
+    M_WriteSaveGameAsync(fileName, buffer, length,
+                         SAVESTRINGSIZE + VERSIONSIZE);
+    mem_fclose(SaveGameFP);
+    SaveGameFP = NULL;
+}
+
+// [JN] Hands the serialized state over to the rewind buffer.
+void SV_CloseSnapshot(int tic, uint64_t start_us)
+{
+    void *buffer;
+    size_t length;
+
+    SV_WriteByte(SAVE_GAME_TERMINATOR);
+
+    mem_get_buf(SaveGameFP, &buffer, &length);
+    RW_Store(buffer, length, tic, I_GetTimeUS() - start_us);
+    mem_fclose(SaveGameFP);
+    SaveGameFP = NULL;
+}
+
+void SV_CloseRead(void)
+{
+    mem_fclose(SaveGameFP);
+    if (SaveGameBuffer != NULL)
+    {
+        Z_Free(SaveGameBuffer);
+    }
+    SaveGameFP = NULL;
+    SaveGameBuffer = NULL;
 }
 
 //==========================================================================
@@ -91,7 +149,7 @@ void SV_Close(char *fileName)
 
 void SV_Write(void *buffer, int size)
 {
-    fwrite(buffer, size, 1, SaveGameFP);
+    mem_fwrite(buffer, size, 1, SaveGameFP);
 }
 
 void SV_WriteByte(byte val)
@@ -132,7 +190,7 @@ void SV_WritePtr(void *ptr)
 
 void SV_Read(void *buffer, int size)
 {
-    int retval = fread(buffer, 1, size, SaveGameFP);
+    int retval = mem_fread(buffer, 1, size, SaveGameFP);
     if (retval != size)
     {
         I_QuitWithError(english_language ?
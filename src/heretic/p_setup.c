@@ -2008,6 +2008,12 @@ void P_SetupLevel (int episode, int map, int playermask, skill_t skill)
 
     lumpnum = W_GetNumForName(lumpname);
 
+    // [JN] Have the map lumps read ahead while the level is being set up.
+    for (i = ML_THINGS ; i <= ML_BLOCKMAP ; i++)
+    {
+        W_WillNeedLump(lumpnum + i);
+    }
+
     // [JN] Checking for multiple map lump names for allowing map fixes to work.
     // Adaptaken from DOOM Retro, thanks Brad Harding!
     canmodify = (W_CheckMultipleLumps(lumpname) == 1
@@ -25,6 +25,10 @@
 #include "s_sound.h"
 #include "jn.h"
 
+// [JN] Lumps looked up by name only once.
+
+static lumphandle_t lh_playpal = LUMPHANDLE("PLAYPAL");
+
 
 // Macros
 
@@ -445,7 +449,7 @@ void P_DeathThink(player_t * player)
     {
         if (player == &players[consoleplayer])
         {
-            I_SetPalette(W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE));
+            I_SetPalette(W_CacheLumpHandle(&lh_playpal, PU_CACHE));
             inv_ptr = 0;
             curpos = 0;
             newtorch = 0;
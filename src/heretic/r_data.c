@@ -57,6 +57,7 @@ struct texture_s
 {
     // Keep name for switch changing, etc.
     char	    name[8];
+    uint64_t        key;    // [JN] Upper-cased name, see W_LumpNameKey
     short	    width;
     short	    height;
 
@@ -209,7 +210,7 @@ static void R_GenerateComposite (const int texnum)
 
     for ( ; --i >=0 ; patch++)
     {
-        const patch_t *realpatch = W_CacheLumpNum(patch->patch, PU_CACHE);
+        const patch_t *realpatch = W_CacheLumpNumRO(patch->patch, PU_CACHE);
         int x, x1 = patch->originx, x2 = x1 + SHORT(realpatch->width);
         const int *cofs = realpatch->columnofs - x1;
 
@@ -221,7 +222,7 @@ static void R_GenerateComposite (const int texnum)
         for (x = x1; x < x2 ; x++)
         // [crispy] generate composites for single-patched textures as well
         // killough 1/25/98, 4/9/98: Fix medusa bug.
-        R_DrawColumnInCache((column_t*)((byte*) realpatch + LONG(cofs[x])),
+        R_DrawColumnInCache((const column_t*)((const byte*) realpatch + LONG(cofs[x])),
                             block + colofs[x], patch->originy,
                             texture->height, marks + x*texture->height);
     }
@@ -308,7 +309,7 @@ static void R_GenerateLookup (const int texnum)
     while (--i >= 0)
     {
         int pat = patch->patch;
-        const patch_t *realpatch = W_CacheLumpNum(pat, PU_CACHE);
+        const patch_t *realpatch = W_CacheLumpNumRO(pat, PU_CACHE);
         int x, x1 = patch++->originx, x2 = x1 + SHORT(realpatch->width);
         const int *cofs = realpatch->columnofs - x1;
 
@@ -346,7 +347,7 @@ static void R_GenerateLookup (const int texnum)
         for (i = texture->patchcount, patch = texture->patches; --i >= 0;)
         {
             const int pat = patch->patch;
-            const patch_t *realpatch = W_CacheLumpNum(pat, PU_CACHE);
+            const patch_t *realpatch = W_CacheLumpNumRO(pat, PU_CACHE);
             int x, x1 = patch++->originx, x2 = x1 + SHORT(realpatch->width);
             const int *cofs = realpatch->columnofs - x1;
 
@@ -359,7 +360,7 @@ static void R_GenerateLookup (const int texnum)
             if (count[x].patches > 1)        // Only multipatched columns
             {
                 const column_t *col =
-                (column_t*)((byte*) realpatch+LONG(cofs[x]));
+                (const column_t*)((const byte*) realpatch+LONG(cofs[x]));
                 const byte *base = (const byte *) col;
 
                 // count posts
@@ -508,7 +509,7 @@ static void GenerateTextureHashTable (void)
         // wins. The new entry must therefore be added at the end
         // of the hash chain, so that earlier entries win.
 
-        key = W_LumpNameHash(textures[i]->name) % numtextures;
+        key = W_LumpKeyHash(textures[i]->key) % numtextures;
 
         rover = &textures_hashtable[key];
 
@@ -777,6 +778,7 @@ static void R_InitTextures (void)
 	texture->patchcount = SHORT(mtexture->patchcount);
 	
 	memcpy (texture->name, mtexture->name, sizeof(texture->name));
+	texture->key = W_LumpNameKey(texture->name);
 	mpatch = &mtexture->patches[0];
 	patch = &texture->patches[0];
 
@@ -954,11 +956,6 @@ static void R_InitColormaps (void)
 ================================================================================
 */
 
-enum {
-    r, g, b
-} rgb_t;
-
-
 static void R_InitTransMaps (void)
 {
     // [JN] Check if we have a modified PLAYPAL palette:
@@ -994,82 +991,13 @@ static void R_InitTransMaps (void)
         transtable10 = Z_Malloc(256*256, PU_STATIC, 0);
 
         {
-            byte *fg, *bg, blend[3];
-            byte *tp90 = transtable90;
-            byte *tp80 = transtable80;
-            byte *tp70 = transtable70;
-            byte *tp60 = transtable60;
-            byte *tp50 = transtable50;
-            byte *tp40 = transtable40;
-            byte *tp30 = transtable30;
-            byte *tp20 = transtable20;
-            byte *tp10 = transtable10;
-            int i, j;
-
-            // [crispy] background color
-            for (i = 0; i < 256; i++)
-            {
-                // [crispy] foreground color
-                for (j = 0; j < 256; j++)
-                {
-                    // [crispy] shortcut: identical foreground and background
-                    if (i == j)
-                    {
-                        *tp90++ = i; *tp80++ = i; *tp70++ = i;
-                        *tp60++ = i; *tp50++ = i; *tp40++ = i;
-                        *tp30++ = i; *tp20++ = i; *tp10++ = i;
-                        continue;
-                    }
+            byte *tables[TRANS_TABLES] = {
+                transtable10, transtable20, transtable30,
+                transtable40, transtable50, transtable60,
+                transtable70, transtable80, transtable90
+            };
 
-                    bg = playpal + 3*i;
-                    fg = playpal + 3*j;
-
-                    blend[r] = (90 * fg[r] + (100 - 90) * bg[r]) / 100;
-                    blend[g] = (90 * fg[g] + (100 - 90) * bg[g]) / 100;
-                    blend[b] = (90 * fg[b] + (100 - 90) * bg[b]) / 100;
-                    *tp90++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (80 * fg[r] + (100 - 80) * bg[r]) / 100;
-                    blend[g] = (80 * fg[g] + (100 - 80) * bg[g]) / 100;
-                    blend[b] = (80 * fg[b] + (100 - 80) * bg[b]) / 100;
-                    *tp80++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (70 * fg[r] + (100 - 70) * bg[r]) / 100;
-                    blend[g] = (70 * fg[g] + (100 - 70) * bg[g]) / 100;
-                    blend[b] = (70 * fg[b] + (100 - 70) * bg[b]) / 100;
-                    *tp70++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (60 * fg[r] + (100 - 60) * bg[r]) / 100;
-                    blend[g] = (60 * fg[g] + (100 - 60) * bg[g]) / 100;
-                    blend[b] = (60 * fg[b] + (100 - 60) * bg[b]) / 100;
-                    *tp60++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (50 * fg[r] + (100 - 50) * bg[r]) / 100;
-                    blend[g] = (50 * fg[g] + (100 - 50) * bg[g]) / 100;
-                    blend[b] = (50 * fg[b] + (100 - 50) * bg[b]) / 100;
-                    *tp50++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (40 * fg[r] + (100 - 40) * bg[r]) / 100;
-                    blend[g] = (40 * fg[g] + (100 - 40) * bg[g]) / 100;
-                    blend[b] = (40 * fg[b] + (100 - 40) * bg[b]) / 100;
-                    *tp40++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (30 * fg[r] + (100 - 30) * bg[r]) / 100;
-                    blend[g] = (30 * fg[g] + (100 - 30) * bg[g]) / 100;
-                    blend[b] = (30 * fg[b] + (100 - 30) * bg[b]) / 100;
-                    *tp30++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (20 * fg[r] + (100 - 20) * bg[r]) / 100;
-                    blend[g] = (20 * fg[g] + (100 - 20) * bg[g]) / 100;
-                    blend[b] = (20 * fg[b] + (100 - 20) * bg[b]) / 100;
-                    *tp20++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (10 * fg[r] + (100 - 10) * bg[r]) / 100;
-                    blend[g] = (10 * fg[g] + (100 - 10) * bg[g]) / 100;
-                    blend[b] = (10 * fg[b] + (100 - 10) * bg[b]) / 100;
-                    *tp10++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-                }
-            }
+            V_InitTransTables(playpal, tables);
         }
 
         W_ReleaseLumpName("PLAYPAL");
@@ -1150,6 +1078,7 @@ const int R_FlatNumForName (const char *name)
 const int R_CheckTextureNumForName (const char *name)
 {
     int key;
+    uint64_t namekey;
     texture_t *texture;
 
     // "NoTexture" marker.
@@ -1158,12 +1087,13 @@ const int R_CheckTextureNumForName (const char *name)
         return 0;
     }
 
-    key = W_LumpNameHash(name) % numtextures;
+    namekey = W_LumpNameKey(name);
+    key = W_LumpKeyHash(namekey) % numtextures;
     texture = textures_hashtable[key]; 
 
     while (texture != NULL)
     {
-        if (!strncasecmp (texture->name, name, 8))
+        if (texture->key == namekey)
         {
             return texture->index;
         }
@@ -1233,7 +1163,7 @@ void R_PrecacheLevel (void)
 
     for (i = numflats; --i >= 0; )
         if (hitlist[i])
-            W_CacheLumpNum(firstflat + i, PU_CACHE);
+            W_WillNeedLump(firstflat + i);
 
     // Precache textures.
 
@@ -1260,7 +1190,7 @@ void R_PrecacheLevel (void)
             int j = texture->patchcount;
 
             while (--j >= 0)
-            W_CacheLumpNum(texture->patches[j].patch, PU_CACHE);
+            W_WillNeedLump(texture->patches[j].patch);
         }
 
     // Precache sprites.
@@ -1285,7 +1215,7 @@ void R_PrecacheLevel (void)
                 int k = 7;
 
                 do
-                W_CacheLumpNum(firstspritelump + sflump[k], PU_CACHE);
+                W_WillNeedLump(firstspritelump + sflump[k]);
                 while (--k >= 0);
             }
         }
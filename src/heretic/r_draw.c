@@ -25,6 +25,19 @@
 #include "v_video.h"
 #include "jn.h"
 
+// [JN] Lumps drawn every frame, looked up by name only once.
+
+static lumphandle_t lh_floor04 = LUMPHANDLE("FLOOR04");
+static lumphandle_t lh_flat513 = LUMPHANDLE("FLAT513");
+static lumphandle_t lh_bordt = LUMPHANDLE("bordt");
+static lumphandle_t lh_bordb = LUMPHANDLE("bordb");
+static lumphandle_t lh_bordl = LUMPHANDLE("bordl");
+static lumphandle_t lh_bordr = LUMPHANDLE("bordr");
+static lumphandle_t lh_bordtl = LUMPHANDLE("bordtl");
+static lumphandle_t lh_bordtr = LUMPHANDLE("bordtr");
+static lumphandle_t lh_bordbr = LUMPHANDLE("bordbr");
+static lumphandle_t lh_bordbl = LUMPHANDLE("bordbl");
+
 
 // All drawing to the view buffer is accomplished in this file.  The other refresh
 // files only know about ccordinates, not the architecture of the frame buffer.
@@ -1123,11 +1136,11 @@ void R_DrawViewBorder(void)
     // [JN] TODO -- predefine background flats at strtup
     if (gamemode == shareware)
     {
-        src = W_CacheLumpName(DEH_String("FLOOR04"), PU_CACHE);
+        src = W_CacheLumpHandle(&lh_floor04, PU_CACHE);
     }
     else
     {
-        src = W_CacheLumpName(DEH_String("FLAT513"), PU_CACHE);
+        src = W_CacheLumpHandle(&lh_flat513, PU_CACHE);
     }
 
     dest = I_VideoBuffer;
@@ -1145,25 +1158,25 @@ void R_DrawViewBorder(void)
     for (x = (viewwindowx >> hires) ; x < ((viewwindowx >> hires) + (scaledviewwidth >> hires)) ; x += 16)
     {
         V_DrawPatch(x, (viewwindowy >> hires) - 4,
-                    W_CacheLumpName(DEH_String("bordt"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_bordt, PU_CACHE), NULL);
         V_DrawPatch(x, (viewwindowy >> hires) + (scaledviewheight >> hires),
-                    W_CacheLumpName(DEH_String("bordb"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_bordb, PU_CACHE), NULL);
     }
     for (y = (viewwindowy >> hires) ; y < ((viewwindowy >> hires) + (scaledviewheight >> hires)) ; y += 16)
     {
         V_DrawPatch((viewwindowx >> hires) - 4, y,
-                    W_CacheLumpName(DEH_String("bordl"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_bordl, PU_CACHE), NULL);
         V_DrawPatch((viewwindowx >> hires) + (scaledviewwidth >> hires), y,
-                    W_CacheLumpName(DEH_String("bordr"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_bordr, PU_CACHE), NULL);
     }
     V_DrawPatch((viewwindowx >> hires) - 4, (viewwindowy >> hires) - 4,
-                W_CacheLumpName(DEH_String("bordtl"), PU_CACHE), NULL);
+                W_CacheLumpHandle(&lh_bordtl, PU_CACHE), NULL);
     V_DrawPatch((viewwindowx >> hires) + (scaledviewwidth >> hires), (viewwindowy >> hires) - 4,
-                W_CacheLumpName(DEH_String("bordtr"), PU_CACHE), NULL);
+                W_CacheLumpHandle(&lh_bordtr, PU_CACHE), NULL);
     V_DrawPatch((viewwindowx >> hires) + (scaledviewwidth >> hires), (viewwindowy >> hires) + (scaledviewheight >> hires),
-                W_CacheLumpName(DEH_String("bordbr"), PU_CACHE), NULL);
+                W_CacheLumpHandle(&lh_bordbr, PU_CACHE), NULL);
     V_DrawPatch((viewwindowx >> hires) - 4, (viewwindowy >> hires) + (scaledviewheight >> hires),
-                W_CacheLumpName(DEH_String("bordbl"), PU_CACHE), NULL);
+                W_CacheLumpHandle(&lh_bordbl, PU_CACHE), NULL);
 }
 
 /*
@@ -1192,11 +1205,11 @@ void R_DrawTopBorder (void)
     // [JN] TODO -- predefine background flats at strtup
     if (gamemode == shareware)
     {
-        src = W_CacheLumpName(DEH_String("FLOOR04"), PU_CACHE);
+        src = W_CacheLumpHandle(&lh_floor04, PU_CACHE);
     }
     else
     {
-        src = W_CacheLumpName(DEH_String("FLAT513"), PU_CACHE);
+        src = W_CacheLumpHandle(&lh_flat513, PU_CACHE);
     }
 
     dest = I_VideoBuffer;
@@ -1220,20 +1233,20 @@ void R_DrawTopBorder (void)
         for (x = (viewwindowx >> hires); x < ((viewwindowx >> hires) + (viewwidth >> hires)); x += 16)
         {
             V_DrawPatch(x, (viewwindowy >> hires) - 4,
-                        W_CacheLumpName(DEH_String("bordt"), PU_CACHE), NULL);
+                        W_CacheLumpHandle(&lh_bordt, PU_CACHE), NULL);
         }
         V_DrawPatch((viewwindowx >> hires) - 4, (viewwindowy >> hires),
-                    W_CacheLumpName(DEH_String("bordl"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_bordl, PU_CACHE), NULL);
         V_DrawPatch((viewwindowx >> hires) + (viewwidth >> hires), (viewwindowy >> hires),
-                    W_CacheLumpName(DEH_String("bordr"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_bordr, PU_CACHE), NULL);
         V_DrawPatch((viewwindowx >> hires) - 4, (viewwindowy >> hires) + 16,
-                    W_CacheLumpName(DEH_String("bordl"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_bordl, PU_CACHE), NULL);
         V_DrawPatch((viewwindowx >> hires) + (viewwidth >> hires), (viewwindowy >> hires) + 16,
-                    W_CacheLumpName(DEH_String("bordr"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_bordr, PU_CACHE), NULL);
 
         V_DrawPatch((viewwindowx >> hires) - 4, (viewwindowy >> hires) - 4,
-                    W_CacheLumpName(DEH_String("bordtl"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_bordtl, PU_CACHE), NULL);
         V_DrawPatch((viewwindowx >> hires) + (viewwidth >> hires), (viewwindowy >> hires) - 4,
-                    W_CacheLumpName(DEH_String("bordtr"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_bordtr, PU_CACHE), NULL);
     }
 }
@@ -548,7 +548,7 @@ void R_DrawPlanes (void)
             // [crispy] add support for SMMU swirling flats
             const byte *tempSource = (flattranslation[pl->picnum] == -1) ?
                                       R_DistortedFlat(pl->picnum) :
-                                      W_CacheLumpNum(lumpnum, PU_STATIC);
+                                      W_CacheLumpNumRO(lumpnum, PU_STATIC);
 
             // [JN] Handle smooth scrolling flats.
             switch (pl->special)
@@ -683,7 +683,7 @@ void R_DrawPlanes (void)
             // [crispy] add support for SMMU swirling flats
             if (flattranslation[pl->picnum] != -1)
             {
-                W_ReleaseLumpNum(lumpnum);
+                W_ReleaseLumpNumRO(lumpnum);
             }
         }
     }
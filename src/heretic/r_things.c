@@ -459,13 +459,13 @@ void R_DrawMaskedColumn (const column_t *column, signed const int baseclip)
 
 static void R_DrawVisSprite (const vissprite_t *vis, const int x1, const int x2)
 {
-    column_t *column;
+    const column_t *column;
     int       texturecolumn;
     fixed_t   frac;
-    patch_t  *patch;
+    const patch_t *patch;
     fixed_t   baseclip;
 
-    patch = W_CacheLumpNum(vis->patch + firstspritelump, PU_CACHE);
+    patch = W_CacheLumpNumRO(vis->patch + firstspritelump, PU_CACHE);
 
     // [crispy] brightmaps for select sprites
     dc_colormap[0] = vis->colormap[0];
@@ -547,7 +547,7 @@ static void R_DrawVisSprite (const vissprite_t *vis, const int x1, const int x2)
                          "R_DrawSpriteRange: некорректныая информация texturecolumn");
         }
 #endif
-        column = (column_t *) ((byte *) patch + LONG(patch->columnofs[texturecolumn]));
+        column = (const column_t *) ((const byte *) patch + LONG(patch->columnofs[texturecolumn]));
         R_DrawMaskedColumn(column, baseclip);
     }
 
@@ -34,6 +34,28 @@
 #include "id_lang.h"
 #include "jn.h"
 
+// [JN] Lumps drawn every frame, looked up by name only once.
+
+static lumphandle_t lh_lame = LUMPHANDLE("LAME");
+static lumphandle_t lh_fontb13 = LUMPHANDLE("FONTB13");
+static lumphandle_t lh_bordb = LUMPHANDLE("BORDB");
+static lumphandle_t lh_god1 = LUMPHANDLE("GOD1");
+static lumphandle_t lh_god2 = LUMPHANDLE("GOD2");
+static lumphandle_t lh_artiinvs = LUMPHANDLE("ARTIINVS");
+static lumphandle_t lh_artitrch = LUMPHANDLE("ARTITRCH");
+static lumphandle_t lh_artiinvu = LUMPHANDLE("ARTIINVU");
+static lumphandle_t lh_ykeyicon = LUMPHANDLE("ykeyicon");
+static lumphandle_t lh_gkeyicon = LUMPHANDLE("gkeyicon");
+static lumphandle_t lh_bkeyicon = LUMPHANDLE("bkeyicon");
+static lumphandle_t lh_artibox = LUMPHANDLE("ARTIBOX");
+static lumphandle_t lh_inamgld = LUMPHANDLE("INAMGLD");
+static lumphandle_t lh_inambow = LUMPHANDLE("INAMBOW");
+static lumphandle_t lh_inambst = LUMPHANDLE("INAMBST");
+static lumphandle_t lh_inamram = LUMPHANDLE("INAMRAM");
+static lumphandle_t lh_inampnx = LUMPHANDLE("INAMPNX");
+static lumphandle_t lh_inamlob = LUMPHANDLE("INAMLOB");
+static lumphandle_t lh_slashnum = LUMPHANDLE("SLASHNUM");
+
 // Types
 
 typedef struct Cheat_s
@@ -385,7 +407,7 @@ static void DrINumber(signed int val, int x, int y)
             // [JN] Negative health: Leave "LAME" sign for Deathmatch
             if (deathmatch)
             {
-                V_DrawPatch(x + 1, y + 1, W_CacheLumpName(DEH_String("LAME"), PU_CACHE), NULL);
+                V_DrawPatch(x + 1, y + 1, W_CacheLumpHandle(&lh_lame, PU_CACHE), NULL);
             }
             // [JN] Negative health: -10 and below routine
             else if (negative_health && !vanillaparm)
@@ -451,7 +473,7 @@ static void DrBNumber(signed int val, int x, int y)
     int oldval;
 
     // [JN] Declare a "minus" symbol in the big green font
-    patch_n = W_CacheLumpName(DEH_String("FONTB13"), PU_CACHE);
+    patch_n = W_CacheLumpHandle(&lh_fontb13, PU_CACHE);
 
     oldval = val;
     xpos = x;
@@ -1190,7 +1212,7 @@ void SB_Drawer(void)
                 int x, y;
                 byte *src;
                 byte *dest;
-                const patch_t *const patch = W_CacheLumpName(DEH_String("BORDB"), PU_CACHE);
+                const patch_t *const patch = W_CacheLumpHandle(&lh_bordb, PU_CACHE);
                 char *name = DEH_String(gamemode == shareware ? "FLOOR04" : "FLAT513");
                 const int shift_allowed = vanillaparm ? 1 : hud_detaillevel;
         
@@ -1268,9 +1290,9 @@ void SB_Drawer(void)
     || (CPlayer->powers[pw_invulnerability] && !vanillaparm)))
     {
         V_DrawPatch(16 + wide_delta, 167,
-                    W_CacheLumpName(DEH_String("GOD1"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_god1, PU_CACHE), NULL);
         V_DrawPatch(287 + wide_delta, 167,
-                    W_CacheLumpName(DEH_String("GOD2"), PU_CACHE), NULL);
+                    W_CacheLumpHandle(&lh_god2, PU_CACHE), NULL);
     }
 
     // Flight icons
@@ -1384,7 +1406,7 @@ void SB_Drawer(void)
             || !(CPlayer->powers[pw_invisibility] & 16))
             {
                 V_DrawPatch(40 + (wide_4_3 ? wide_delta : 0), 1,
-                            W_CacheLumpName(DEH_String("ARTIINVS"), PU_CACHE), NULL);
+                            W_CacheLumpHandle(&lh_artiinvs, PU_CACHE), NULL);
 
                 // [JN] Draw artifact timer.
                 if (show_artifacts_timer && !vanillaparm)
@@ -1420,7 +1442,7 @@ void SB_Drawer(void)
             || !(CPlayer->powers[pw_infrared] & 16))
             {
                 V_DrawPatch(74 + (wide_4_3 ? wide_delta : 0), 1,
-                            W_CacheLumpName(DEH_String("ARTITRCH"), PU_CACHE), NULL);
+                            W_CacheLumpHandle(&lh_artitrch, PU_CACHE), NULL);
 
                 // [JN] Draw artifact timer.
                 if (show_artifacts_timer && !vanillaparm)
@@ -1456,7 +1478,7 @@ void SB_Drawer(void)
             || !(CPlayer->powers[pw_invulnerability] & 16))
             {
                 V_DrawPatch(251 + (wide_4_3 ? wide_delta : wide_delta*2) - xval_widget, 1,
-                            W_CacheLumpName(DEH_String("ARTIINVU"), PU_CACHE), NULL);
+                            W_CacheLumpHandle(&lh_artiinvu, PU_CACHE), NULL);
 
                 // [JN] Draw artifact timer.
                 if (show_artifacts_timer && !vanillaparm)
@@ -1724,13 +1746,13 @@ void DrawMainBar(void)
         if (CPlayer->keys[key_yellow])
         {
             V_DrawPatch(153 + wide_delta, 164,
-                        W_CacheLumpName(DEH_String("ykeyicon"), PU_CACHE), NULL);
+                        W_CacheLumpHandle(&lh_ykeyicon, PU_CACHE), NULL);
         }
         else
         {
             if (CPlayer->yellowkeyTics && !vanillaparm)
             {
-                V_DrawFadePatch(153 + wide_delta, 164, W_CacheLumpName(DEH_String("ykeyicon"), PU_CACHE), 
+                V_DrawFadePatch(153 + wide_delta, 164, W_CacheLumpHandle(&lh_ykeyicon, PU_CACHE), 
                                 CPlayer->yellowkeyTics > 13 ? transtable90 :
                                 CPlayer->yellowkeyTics > 11 ? transtable80 :
                                 CPlayer->yellowkeyTics >  9 ? transtable70 :
@@ -1745,13 +1767,13 @@ void DrawMainBar(void)
         if (CPlayer->keys[key_green])
         {
             V_DrawPatch(153 + wide_delta, 172,
-                        W_CacheLumpName(DEH_String("gkeyicon"), PU_CACHE), NULL);
+                        W_CacheLumpHandle(&lh_gkeyicon, PU_CACHE), NULL);
         }
         else
         {
             if (CPlayer->greenkeyTics && !vanillaparm)
             {
-                V_DrawFadePatch(153 + wide_delta, 172, W_CacheLumpName(DEH_String("gkeyicon"), PU_CACHE), 
+                V_DrawFadePatch(153 + wide_delta, 172, W_CacheLumpHandle(&lh_gkeyicon, PU_CACHE), 
                                 CPlayer->greenkeyTics > 13 ? transtable90 :
                                 CPlayer->greenkeyTics > 11 ? transtable80 :
                                 CPlayer->greenkeyTics >  9 ? transtable70 :
@@ -1766,13 +1788,13 @@ void DrawMainBar(void)
         if (CPlayer->keys[key_blue])
         {
             V_DrawPatch(153 + wide_delta, 180,
-                        W_CacheLumpName(DEH_String("bkeyicon"), PU_CACHE), NULL);
+                        W_CacheLumpHandle(&lh_bkeyicon, PU_CACHE), NULL);
         }
         else
         {
             if (CPlayer->bluekeyTics && !vanillaparm)
             {
-                V_DrawFadePatch(153 + wide_delta, 180, W_CacheLumpName(DEH_String("bkeyicon"), PU_CACHE), 
+                V_DrawFadePatch(153 + wide_delta, 180, W_CacheLumpHandle(&lh_bkeyicon, PU_CACHE), 
                                 CPlayer->bluekeyTics > 13 ? transtable90 :
                                 CPlayer->bluekeyTics > 11 ? transtable80 :
                                 CPlayer->bluekeyTics >  9 ? transtable70 :
@@ -1984,11 +2006,11 @@ void DrawFullScreenStuff(void)
         if (CPlayer->mo->health > 0 && !inventory)
         {
             V_DrawShadowedPatch(219 + (wide_delta * 2), 174,
-                                W_CacheLumpName(DEH_String("ykeyicon"), PU_CACHE));
+                                W_CacheLumpHandle(&lh_ykeyicon, PU_CACHE));
             V_DrawShadowedPatch(219 + (wide_delta * 2), 182,
-                                W_CacheLumpName(DEH_String("gkeyicon"), PU_CACHE));
+                                W_CacheLumpHandle(&lh_gkeyicon, PU_CACHE));
             V_DrawShadowedPatch(219 + (wide_delta * 2), 190,
-                                W_CacheLumpName(DEH_String("bkeyicon"), PU_CACHE));
+                                W_CacheLumpHandle(&lh_bkeyicon, PU_CACHE));
         }
     }
     if (!inventory)
@@ -2025,14 +2047,14 @@ void DrawFullScreenStuff(void)
             if (CPlayer->keys[key_yellow])
             {
                 V_DrawShadowedPatch(219 + (wide_delta * 2), 174,
-                                    W_CacheLumpName(DEH_String("ykeyicon"), PU_CACHE));
+                                    W_CacheLumpHandle(&lh_ykeyicon, PU_CACHE));
             }
             else
             {
                 if (CPlayer->yellowkeyTics && !vanillaparm)
                 {
                     V_DrawFadePatch(219 + (wide_delta * 2), 174, 
-                                    W_CacheLumpName(DEH_String("ykeyicon"), PU_CACHE), 
+                                    W_CacheLumpHandle(&lh_ykeyicon, PU_CACHE), 
                                     CPlayer->yellowkeyTics > 13 ? transtable90 :
                                     CPlayer->yellowkeyTics > 11 ? transtable80 :
                                     CPlayer->yellowkeyTics >  9 ? transtable70 :
@@ -2047,14 +2069,14 @@ void DrawFullScreenStuff(void)
             if (CPlayer->keys[key_green])
             {
                 V_DrawShadowedPatch(219 + (wide_delta * 2), 182,
-                                    W_CacheLumpName(DEH_String("gkeyicon"), PU_CACHE));
+                                    W_CacheLumpHandle(&lh_gkeyicon, PU_CACHE));
             }
             else
             {
                 if (CPlayer->greenkeyTics && !vanillaparm)
                 {
                     V_DrawFadePatch(219 + (wide_delta * 2), 182,
-                                    W_CacheLumpName(DEH_String("gkeyicon"), PU_CACHE), 
+                                    W_CacheLumpHandle(&lh_gkeyicon, PU_CACHE), 
                                     CPlayer->greenkeyTics > 13 ? transtable90 :
                                     CPlayer->greenkeyTics > 11 ? transtable80 :
                                     CPlayer->greenkeyTics >  9 ? transtable70 :
@@ -2069,14 +2091,14 @@ void DrawFullScreenStuff(void)
             if (CPlayer->keys[key_blue])
             {
                 V_DrawShadowedPatch(219 + (wide_delta * 2), 190,
-                                    W_CacheLumpName(DEH_String("bkeyicon"), PU_CACHE));
+                                    W_CacheLumpHandle(&lh_bkeyicon, PU_CACHE));
             }
             else
             {
                 if (CPlayer->bluekeyTics && !vanillaparm)
                 {
                     V_DrawFadePatch(219 + (wide_delta * 2), 190,
-                                    W_CacheLumpName(DEH_String("bkeyicon"), PU_CACHE), 
+                                    W_CacheLumpHandle(&lh_bkeyicon, PU_CACHE), 
                                     CPlayer->bluekeyTics > 13 ? transtable90 :
                                     CPlayer->bluekeyTics > 11 ? transtable80 :
                                     CPlayer->bluekeyTics >  9 ? transtable70 :
@@ -2132,7 +2154,7 @@ void DrawFullScreenStuff(void)
         for (i = 0; i < 7; i++)
         {
             V_DrawTLPatch(50 + i * 31 + wide_delta, 168,
-                          W_CacheLumpName(DEH_String("ARTIBOX"), PU_CACHE));
+                          W_CacheLumpHandle(&lh_artibox, PU_CACHE));
             if (CPlayer->inventorySlotNum > x + i
                 && CPlayer->inventory[x + i].type != arti_none)
             {
@@ -2774,17 +2796,17 @@ static void SB_Draw_Ammo_Widget (void)
 
     // Ammo GFX patches
     //if (!(CPlayer->weaponowned[wp_goldwand])) dp_translation = cr[CR_MONOCHROME];
-    V_DrawPatchUnscaled(xpos_pic, 198, W_CacheLumpName(DEH_String("INAMGLD"), PU_CACHE),
+    V_DrawPatchUnscaled(xpos_pic, 198, W_CacheLumpHandle(&lh_inamgld, PU_CACHE),
                        (CPlayer->readyweapon == wp_goldwand || (automapactive && !automap_overlay)) ? NULL : transtable60);
     dp_translation = NULL;
 
     if (!(CPlayer->weaponowned[wp_crossbow])) dp_translation = cr[CR_MONOCHROME];
-    V_DrawPatchUnscaled(xpos_pic, 212, W_CacheLumpName(DEH_String("INAMBOW"), PU_CACHE),
+    V_DrawPatchUnscaled(xpos_pic, 212, W_CacheLumpHandle(&lh_inambow, PU_CACHE),
                        (CPlayer->readyweapon == wp_crossbow || (automapactive && !automap_overlay)) ? NULL : transtable60);
     dp_translation = NULL;
 
     if (!(CPlayer->weaponowned[wp_blaster])) dp_translation = cr[CR_MONOCHROME];
-    V_DrawPatchUnscaled(xpos_pic, 226, W_CacheLumpName(DEH_String("INAMBST"), PU_CACHE),
+    V_DrawPatchUnscaled(xpos_pic, 226, W_CacheLumpHandle(&lh_inambst, PU_CACHE),
                        (CPlayer->readyweapon == wp_blaster || (automapactive && !automap_overlay)) ? NULL : transtable60);
     dp_translation = NULL;
 
@@ -2792,17 +2814,17 @@ static void SB_Draw_Ammo_Widget (void)
     if (gamemode != shareware)
     {
         if (!(CPlayer->weaponowned[wp_skullrod])) dp_translation = cr[CR_MONOCHROME];
-        V_DrawPatchUnscaled(xpos_pic, 240, W_CacheLumpName(DEH_String("INAMRAM"), PU_CACHE),
+        V_DrawPatchUnscaled(xpos_pic, 240, W_CacheLumpHandle(&lh_inamram, PU_CACHE),
                            (CPlayer->readyweapon == wp_skullrod || (automapactive && !automap_overlay)) ? NULL : transtable60);
         dp_translation = NULL;
 
         if (!(CPlayer->weaponowned[wp_phoenixrod])) dp_translation = cr[CR_MONOCHROME];
-        V_DrawPatchUnscaled(xpos_pic, 254, W_CacheLumpName(DEH_String("INAMPNX"), PU_CACHE),
+        V_DrawPatchUnscaled(xpos_pic, 254, W_CacheLumpHandle(&lh_inampnx, PU_CACHE),
                            (CPlayer->readyweapon == wp_phoenixrod || (automapactive && !automap_overlay)) ? NULL : transtable60);
         dp_translation = NULL;
 
         if (!(CPlayer->weaponowned[wp_mace])) dp_translation = cr[CR_MONOCHROME];
-        V_DrawPatchUnscaled(xpos_pic, 268, W_CacheLumpName(DEH_String("INAMLOB"), PU_CACHE),
+        V_DrawPatchUnscaled(xpos_pic, 268, W_CacheLumpHandle(&lh_inamlob, PU_CACHE),
                            (CPlayer->readyweapon == wp_mace || (automapactive && !automap_overlay)) ? NULL : transtable60);
         dp_translation = NULL;
     }
@@ -2815,7 +2837,7 @@ static void SB_Draw_Ammo_Widget (void)
                      (CPlayer->readyweapon == wp_goldwand || (automapactive && !automap_overlay)) ? true : false);
     if (ammo_widget == 2)
     {
-        V_DrawPatchUnscaled(xpos_slash, 200, W_CacheLumpName(DEH_String("SLASHNUM"), PU_CACHE),
+        V_DrawPatchUnscaled(xpos_slash, 200, W_CacheLumpHandle(&lh_slashnum, PU_CACHE),
                            (CPlayer->readyweapon == wp_goldwand || (automapactive && !automap_overlay)) ? NULL : transtable60);
         DrSmallAmmoNumber(fullammo1, xpos_qty2, 100,
                          (CPlayer->readyweapon == wp_goldwand || (automapactive && !automap_overlay)) ? true : false);
@@ -2831,7 +2853,7 @@ static void SB_Draw_Ammo_Widget (void)
                      (CPlayer->readyweapon == wp_crossbow || (automapactive && !automap_overlay)) ? true : false);
     if (ammo_widget == 2)
     {
-        V_DrawPatchUnscaled(xpos_slash, 214, W_CacheLumpName(DEH_String("SLASHNUM"), PU_CACHE),
+        V_DrawPatchUnscaled(xpos_slash, 214, W_CacheLumpHandle(&lh_slashnum, PU_CACHE),
                            (CPlayer->readyweapon == wp_crossbow || (automapactive && !automap_overlay)) ? NULL : transtable60);
         DrSmallAmmoNumber(fullammo2, xpos_qty2, 107,
                          (CPlayer->readyweapon == wp_crossbow || (automapactive && !automap_overlay)) ? true : false);
@@ -2847,7 +2869,7 @@ static void SB_Draw_Ammo_Widget (void)
                      (CPlayer->readyweapon == wp_blaster || (automapactive && !automap_overlay)) ? true : false);
     if (ammo_widget == 2)
     {
-        V_DrawPatchUnscaled(xpos_slash, 228, W_CacheLumpName(DEH_String("SLASHNUM"), PU_CACHE),
+        V_DrawPatchUnscaled(xpos_slash, 228, W_CacheLumpHandle(&lh_slashnum, PU_CACHE),
                            (CPlayer->readyweapon == wp_blaster || (automapactive && !automap_overlay)) ? NULL : transtable60);
         DrSmallAmmoNumber(fullammo3, xpos_qty2, 114,
                          (CPlayer->readyweapon == wp_blaster || (automapactive && !automap_overlay)) ? true : false);
@@ -2866,7 +2888,7 @@ static void SB_Draw_Ammo_Widget (void)
                          (CPlayer->readyweapon == wp_skullrod || (automapactive && !automap_overlay)) ? true : false);
         if (ammo_widget == 2)
         {
-            V_DrawPatchUnscaled(xpos_slash, 242, W_CacheLumpName(DEH_String("SLASHNUM"), PU_CACHE),
+            V_DrawPatchUnscaled(xpos_slash, 242, W_CacheLumpHandle(&lh_slashnum, PU_CACHE),
                                (CPlayer->readyweapon == wp_skullrod || (automapactive && !automap_overlay)) ? NULL : transtable60);
             DrSmallAmmoNumber(fullammo4, xpos_qty2, 121,
                              (CPlayer->readyweapon == wp_skullrod || (automapactive && !automap_overlay)) ? true : false);
@@ -2882,7 +2904,7 @@ static void SB_Draw_Ammo_Widget (void)
                          (CPlayer->readyweapon == wp_phoenixrod || (automapactive && !automap_overlay)) ? true : false);
         if (ammo_widget == 2)
         {
-            V_DrawPatchUnscaled(xpos_slash, 256, W_CacheLumpName(DEH_String("SLASHNUM"), PU_CACHE),
+            V_DrawPatchUnscaled(xpos_slash, 256, W_CacheLumpHandle(&lh_slashnum, PU_CACHE),
                                (CPlayer->readyweapon == wp_phoenixrod || (automapactive && !automap_overlay)) ? NULL : transtable60);
             DrSmallAmmoNumber(fullammo5, xpos_qty2, 128,
                               (CPlayer->readyweapon == wp_phoenixrod || (automapactive && !automap_overlay)) ? true : false);
@@ -2898,7 +2920,7 @@ static void SB_Draw_Ammo_Widget (void)
                          (CPlayer->readyweapon == wp_mace || (automapactive && !automap_overlay)) ? true : false);
         if (ammo_widget == 2)
         {
-            V_DrawPatchUnscaled(xpos_slash, 270, W_CacheLumpName(DEH_String("SLASHNUM"), PU_CACHE),
+            V_DrawPatchUnscaled(xpos_slash, 270, W_CacheLumpHandle(&lh_slashnum, PU_CACHE),
                                (CPlayer->readyweapon == wp_mace || (automapactive && !automap_overlay)) ? NULL : transtable60);
             DrSmallAmmoNumber(fullammo6, xpos_qty2, 135,
                              (CPlayer->readyweapon == wp_mace || (automapactive && !automap_overlay)) ? true : false);
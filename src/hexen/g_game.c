@@ -29,6 +29,7 @@
 #include "m_misc.h"
 #include "p_local.h"
 #include "rd_keybinds.h"
+#include "rd_rewind.h"
 #include "v_video.h"
 #include "am_map.h"
 
@@ -57,6 +58,9 @@ void G_DoVictory(void);
 void G_DoWorldDone(void);
 void G_DoSaveGame(void);
 void G_DoSingleReborn(void);
+static void G_DoRewind(void);
+
+static boolean rewinding;  // [JN] level is being reloaded by G_DoRewind
 
 void H2_PageTicker(void);
 void H2_AdvanceDemo(void);
@@ -769,6 +773,12 @@ void G_DoLoadLevel(void)
     gameaction = ga_nothing;
     Z_CheckHeap();
 
+    // [JN] Snapshots of the previous level can't be rewound to.
+    if (!rewinding)
+    {
+        RW_Clear();
+    }
+
 //
 // clear cmd building stuff
 //
@@ -931,6 +941,13 @@ boolean G_Responder(event_t * ev)
         sendpause = true;
         return true;
     }
+    // [JN] Step back in time, single player only.
+    if (BK_isKeyDown(ev, bk_rewind) && gamestate == GS_LEVEL && !menuactive
+    && gameaction == ga_nothing && !netgame && !demorecording && RW_Available())
+    {
+        gameaction = ga_rewind;
+        return true;
+    }
 
     switch (ev->type)
     {
@@ -965,6 +982,41 @@ boolean G_Responder(event_t * ev)
 }
 
 
+//==========================================================================
+//
+// G_CheckSaveGameWritten
+//
+// [JN] Savegames are written in background, so the message is shown
+// once the file is written, or the write has failed.
+//
+//==========================================================================
+
+static boolean savemessage_pending;
+
+static void G_CheckSaveGameWritten (void)
+{
+    if (!savemessage_pending)
+    {
+        return;
+    }
+
+    switch (M_GetSaveGameStatus())
+    {
+        case SAVEGAME_PENDING:
+            return;
+
+        case SAVEGAME_FAILED:
+            P_SetMessage(&players[consoleplayer], txt_gamesavefailed, msg_system, false);
+            break;
+
+        default:
+            P_SetMessage(&players[consoleplayer], txt_gamesaved, msg_system, false);
+            break;
+    }
+
+    savemessage_pending = false;
+}
+
 //==========================================================================
 //
 // G_Ticker
@@ -983,6 +1035,8 @@ void G_Ticker(void)
         if (playeringame[i] && players[i].playerstate == PST_REBORN)
             G_DoReborn(i);
 
+    G_CheckSaveGameWritten();
+
 //
 // do things to change the game state
 //
@@ -1025,6 +1079,9 @@ void G_Ticker(void)
             case ga_singlereborn:
                 G_DoSingleReborn();
                 break;
+            case ga_rewind:
+                G_DoRewind();
+                break;
             case ga_playdemo:
                 G_DoPlayDemo();
                 break;
@@ -1158,6 +1215,11 @@ void G_Ticker(void)
             SB_Ticker();
             AM_Ticker();
             CT_Ticker();
+            if (!netgame && !demoplayback && !demorecording
+            && gameaction == ga_nothing && RW_SnapshotDue(leveltime))
+            {
+                SV_StoreRewindSnapshot();
+            }
             break;
         case GS_INTERMISSION:
             IN_Ticker();
@@ -1794,10 +1856,31 @@ void G_SaveGame(int slot, char *description)
 
 void G_DoSaveGame(void)
 {
+    M_GetSaveGameStatus();  // drop result of earlier writes
     SV_SaveGame(savegameslot, savedescription);
     gameaction = ga_nothing;
     savedescription[0] = 0;
-    P_SetMessage(&players[consoleplayer], txt_gamesaved, msg_system, false);
+    savemessage_pending = true;
+}
+
+//==========================================================================
+//
+// G_DoRewind
+//
+// [JN] Restores the previous snapshot from the rewind buffer.
+//
+//==========================================================================
+
+static void G_DoRewind(void)
+{
+    gameaction = ga_nothing;
+
+    rewinding = true;
+    if (SV_LoadRewindSnapshot())
+    {
+        P_SetMessage(&players[consoleplayer], txt_rewound, msg_system, false);
+    }
+    rewinding = false;
 }
 
 //==========================================================================
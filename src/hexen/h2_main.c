@@ -56,6 +56,7 @@
 #include "w_main.h"
 #include "w_merge.h"
 #include "rd_keybinds.h"
+#include "rd_rewind.h"
 #include "rd_rushexen.h"
 #include "rd_psx.h"
 
@@ -407,6 +408,10 @@ void D_BindVariables(void)
     M_BindIntVariable("fix_map_errors",         &fix_map_errors);
     M_BindIntVariable("flip_levels",            &flip_levels);
     M_BindIntVariable("no_internal_demos",      &no_internal_demos);
+
+    // Gameplay: Rewind
+    M_BindIntVariable("rewind_depth",           &rewind_depth);
+    M_BindIntVariable("rewind_interval",        &rewind_interval);
     M_BindIntVariable("breathing",              &breathing);
     M_BindIntVariable("skip_unused_artifact",   &skip_unused_artifact);
     M_BindIntVariable("pistol_start",   &pistol_start);
@@ -789,6 +794,9 @@ void D_DoomMain(void)
                "V_Init: Инициализация видео.\n");
     V_Init();
 
+    // [JN] Rewind buffer, depth may be given by "-rewind".
+    RW_Init();
+
     I_AtExit(M_SaveConfig, true); // [crispy] always save configuration at exit
 
     // haleyjd: removed WATCOMC
@@ -141,7 +141,8 @@ typedef enum
     ga_singlereborn,
     ga_victory,
     ga_worlddone,
-    ga_screenshot
+    ga_screenshot,
+    ga_rewind       // [JN] Step back to the previous in-memory snapshot
 } gameaction_t;
 
 typedef enum
@@ -869,6 +870,8 @@ void SV_UpdateRebornSlot(void);
 void SV_ClearRebornSlot(void);
 boolean SV_RebornSlotAvailable(void);
 int SV_GetRebornSlot(void);
+void SV_StoreRewindSnapshot(void);
+boolean SV_LoadRewindSnapshot(void);
 
 //-----
 //PLAY
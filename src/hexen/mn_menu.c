@@ -952,7 +952,7 @@ static MenuItem_t Bindings3Items[] = {
     I_EFUNC("Quit game",          "ds[jl",               BK_StartBindingKey, bk_quit),        // Выход
     I_EFUNC("Change gamma level", "ehjdtym ufvvs",       BK_StartBindingKey, bk_gamma),       // Уровень гаммы
     I_EFUNC("RESTART LEVEL/DEMO", "GTHTPFGECR EHJDYZ",   BK_StartBindingKey, bk_reloadlevel), // Перезапуск уровня
-    I_EMPTY,
+    I_EFUNC("REWIND",             "GTHTVJNRF YFPFL",     BK_StartBindingKey, bk_rewind),      // Перемотка назад
     I_SETMENU("NEXT PAGE >", "CKTLE.OFZ CNHFYBWF `",  &Bindings4Menu), // Cледующая страница >
     I_SETMENU("< PREV PAGE", "^ GHTLSLEOFZ CNHFYBWF", &Bindings2Menu), // < Предыдущая страница
     I_EMPTY
@@ -2159,6 +2159,9 @@ void MN_LoadSlotText(void)
     char description[HXS_DESCRIPTION_LENGTH];
     int slot;
 
+    // [JN] Let pending saves and removals reach the disk first.
+    M_FlushFileWrites();
+
     for (slot = 0; slot < 7; slot++)
     {
         if (ReadDescriptionForSlot(slot, description))
@@ -1795,6 +1795,12 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
     M_snprintf(lumpname, sizeof(lumpname), "MAP%02d", map);
     lumpnum = W_GetNumForName(lumpname);
 
+    // [JN] Have the map lumps read ahead while the level is being set up.
+    for (i = ML_THINGS ; i <= ML_BEHAVIOR ; i++)
+    {
+        W_WillNeedLump(lumpnum + i);
+    }
+
     // [JN] Check if optinial map fixes can be applied.
     canmodify = (W_CheckMultipleLumps(lumpname) == 1
               && (!netgame && !vanillaparm && gamemode != shareware && singleplayer));
@@ -46,7 +46,7 @@ byte *translationtables;
 int           ds_y, ds_x1, ds_x2;
 fixed_t       ds_xfrac, ds_yfrac;
 fixed_t       ds_xstep, ds_ystep;
-byte         *ds_source;  // start of a 64*64 tile image
+const byte   *ds_source;  // start of a 64*64 tile image
 const lighttable_t *ds_colormap;
 
 // Border drawing.
@@ -537,7 +537,7 @@ extern int64_t sprtopscreen, sprbotscreen;
 
 extern fixed_t pspritescale, pspriteiscale;
 
-void R_DrawMaskedColumn(column_t * column, signed int baseclip);
+void R_DrawMaskedColumn(const column_t * column, signed int baseclip);
 void R_SortVisSprites(void);
 void R_AddSprites(sector_t * sec);
 void R_AddPSprites(void);
@@ -577,7 +577,7 @@ void R_DrawTranslatedTLColumnLow(void);
 
 
 extern const lighttable_t *ds_colormap;
-extern byte *ds_source;         // start of a 64*64 tile image
+extern const byte *ds_source;         // start of a 64*64 tile image
 extern const byte *ds_brightmap;
 
 extern byte *translationtables;
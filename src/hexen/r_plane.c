@@ -517,7 +517,8 @@ void R_DrawPlanes(void)
     int         offset, skyTexture, offset2, skyTexture2;
     int         heightmask;
     int         count, frac, fracstep = (FRACUNIT >> !detailshift) >> quadres;
-    byte       *source, *source2, *tempSource;
+    byte       *source, *source2;
+    const byte *tempSource;
     byte       *dest, *dest1, *dest2, *dest3, *dest4;
 
     extern byte *ylookup[MAXHEIGHT];
@@ -856,7 +857,7 @@ void R_DrawPlanes(void)
             // [crispy] add support for SMMU swirling flats
             tempSource = (flattranslation[pl->picnum] == -1) ?
                           R_DistortedFlat(pl->picnum) :
-                          W_CacheLumpNum(firstflat + flattranslation[pl->picnum], PU_STATIC);
+                          W_CacheLumpNumRO(firstflat + flattranslation[pl->picnum], PU_STATIC);
 
             // [JN] Handle smooth scrolling flats.
             switch (pl->special)
@@ -1013,7 +1014,7 @@ void R_DrawPlanes(void)
             // [crispy] add support for SMMU swirling flats
             if (flattranslation[pl->picnum] != -1)
             {
-                W_ReleaseLumpNum(firstflat + flattranslation[pl->picnum]);
+                W_ReleaseLumpNumRO(firstflat + flattranslation[pl->picnum]);
             }
         }
     }
@@ -395,7 +395,7 @@ vissprite_t *R_NewVisSprite (void)
 ================================================================================
 */
 
-void R_DrawMaskedColumn (column_t *column, signed int baseclip)
+void R_DrawMaskedColumn (const column_t *column, signed int baseclip)
 {
     int64_t	topscreen, bottomscreen;      // [crispy] WiggleFix
     fixed_t	basetexturemid;
@@ -439,14 +439,14 @@ void R_DrawMaskedColumn (column_t *column, signed int baseclip)
         // [JN] killough 3/2/98, 3/27/98: Failsafe against overflow/crash:
         if (dc_yl <= dc_yh && dc_yh < viewheight)
         {
-            dc_source = (byte *)column + 3;
+            dc_source = (const byte *)column + 3;
             dc_texturemid = basetexturemid - (top<<FRACBITS);
 
             // Drawn by either R_DrawColumn or (SHADOW) R_DrawTLColumn.
             colfunc ();	
         }
 
-        column = (column_t *)(  (byte *)column + column->length + 4);
+        column = (const column_t *)(  (const byte *)column + column->length + 4);
     }
 
     dc_texturemid = basetexturemid;
@@ -464,13 +464,13 @@ void R_DrawMaskedColumn (column_t *column, signed int baseclip)
 
 void R_DrawVisSprite (vissprite_t *vis, int x1, int x2)
 {
-    column_t *column;
+    const column_t *column;
     int       texturecolumn;
     fixed_t   frac;
-    patch_t  *patch;
+    const patch_t *patch;
     fixed_t   baseclip;
 
-    patch = W_CacheLumpNum(vis->patch + firstspritelump, PU_CACHE);
+    patch = W_CacheLumpNumRO(vis->patch + firstspritelump, PU_CACHE);
 
     // [crispy] brightmaps for select sprites
     dc_colormap[0] = vis->colormap[0];
@@ -554,7 +554,7 @@ void R_DrawVisSprite (vissprite_t *vis, int x1, int x2)
                             "R_DrawSpriteRange: bad texturecolumn" :
                             "R_DrawSpriteRange: некорректныая информация texturecolumn");
 #endif
-        column = (column_t *) ((byte *) patch + LONG(patch->columnofs[texturecolumn]));
+        column = (const column_t *) ((const byte *) patch + LONG(patch->columnofs[texturecolumn]));
         R_DrawMaskedColumn(column, baseclip);
     }
 
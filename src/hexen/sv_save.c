@@ -22,10 +22,13 @@
 
 #include "h2def.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_misc.h"
+#include "memio.h"
 #include "i_swap.h"
 #include "p_local.h"
 #include "am_map.h"
+#include "rd_rewind.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -37,6 +40,8 @@
 #define REBORN_SLOT 8
 #define REBORN_DESCRIPTION "TEMP GAME"
 #define MAX_THINKER_SIZE 256
+#define SLOT_GAME_FILE (MAX_MAPS + 1)
+#define SLOT_FILES (MAX_MAPS + 2)
 
 // TYPES -------------------------------------------------------------------
 
@@ -88,6 +93,12 @@ typedef struct
     sector_t *sector;
 } ssthinker_t;
 
+typedef struct
+{
+    byte *data;
+    size_t length;
+} savebuffer_t;
+
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
 
 void P_SpawnPlayer(mapthing_t * mthing);
@@ -107,6 +118,8 @@ static void ArchiveThinkers(void);
 static void UnarchiveThinkers(void);
 static void ArchiveScripts(void);
 static void UnarchiveScripts(void);
+static void ArchiveGame(char *description);
+static void ArchiveMap(void);
 static void ArchivePlayers(void);
 static void UnarchivePlayers(void);
 static void ArchiveSounds(void);
@@ -124,10 +137,10 @@ static void RestorePlatRaise(thinker_t *thinker);
 static void RestoreMoveCeiling(thinker_t *thinker);
 static void AssertSegment(gameArchiveSegment_t segType);
 static void CopySaveSlot(int sourceSlot, int destSlot);
-static void CopyFile(char *sourceName, char *destName);
-static boolean ExistingFile(char *name);
-static void SV_OpenRead(char *fileName);
-static void SV_OpenWrite(char *fileName);
+static savebuffer_t *MemorySlot(int slot);
+static void SaveFileName(char *name, size_t size, int slot, int file);
+static void SV_OpenRead(int slot, int file);
+static void SV_OpenWrite(int slot, int file);
 static void SV_Close(void);
 static void SV_Read(void *buffer, int size);
 static byte SV_ReadByte(void);
@@ -157,7 +170,14 @@ static mobj_t **MobjList;
 static mobj_t ***TargetPlayerAddrs;
 static int TargetPlayerCount;
 static boolean SavingPlayers;
-static FILE *SavingFP;
+static MEMFILE *SavingFP;
+
+// [JN] Files of the base and reborn slots (hub map states and game headers)
+// are kept in memory, so hub transitions don't do any file I/O. Disk is only
+// touched by explicit loads and saves, and saves are written asynchronously.
+static savebuffer_t BaseSlotFiles[SLOT_FILES];
+static savebuffer_t RebornSlotFiles[SLOT_FILES];
+static savebuffer_t *SavingBuffer;
 
 // CODE --------------------------------------------------------------------
 
@@ -1981,13 +2001,56 @@ static void StreamOut_floorWaggle_t(thinker_t *thinker)
 
 void SV_SaveGame(int slot, char *description)
 {
-    char fileName[RD_MAX_PATH];
-    char versionText[HXS_VERSION_TEXT_LENGTH];
-    unsigned int i;
+    // Open the output file
+    SV_OpenWrite(BASE_SLOT, SLOT_GAME_FILE);
+
+    ArchiveGame(description);
+
+    // Close the output file
+    SV_Close();
+
+    // Save out the current map
+    SV_SaveMap(true);           // true = save player info
+
+    // Clear all save files at destination slot
+    SV_ClearSaveSlot(slot);
+
+    // Copy base slot to destination slot
+    CopySaveSlot(BASE_SLOT, slot);
+}
+
+//==========================================================================
+//
+// SV_SaveMap
+//
+//==========================================================================
+
+void SV_SaveMap(boolean savePlayers)
+{
+    SavingPlayers = savePlayers;
 
     // Open the output file
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-7.sav", SavePath);
-    SV_OpenWrite(fileName);
+    SV_OpenWrite(BASE_SLOT, gamemap);
+
+    ArchiveMap();
+
+    // Close the output file
+    SV_Close();
+}
+
+//==========================================================================
+//
+// ArchiveGame
+//
+// Writes the game file: description, version, map, skill, global script
+// info and players.
+//
+//==========================================================================
+
+static void ArchiveGame(char *description)
+{
+    char versionText[HXS_VERSION_TEXT_LENGTH];
+    unsigned int i;
 
     // Write game save description
     SV_Write(description, HXS_DESCRIPTION_LENGTH);
@@ -2019,36 +2082,18 @@ void SV_SaveGame(int slot, char *description)
 
     // Place a termination marker
     SV_WriteLong(ASEG_END);
-
-    // Close the output file
-    SV_Close();
-
-    // Save out the current map
-    SV_SaveMap(true);           // true = save player info
-
-    // Clear all save files at destination slot
-    SV_ClearSaveSlot(slot);
-
-    // Copy base slot to destination slot
-    CopySaveSlot(BASE_SLOT, slot);
 }
 
 //==========================================================================
 //
-// SV_SaveMap
+// ArchiveMap
+//
+// Writes the map file of the current map.
 //
 //==========================================================================
 
-void SV_SaveMap(boolean savePlayers)
+static void ArchiveMap(void)
 {
-    char fileName[RD_MAX_PATH];
-
-    SavingPlayers = savePlayers;
-
-    // Open the output file
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-7%02d.sav", SavePath, gamemap);
-    SV_OpenWrite(fileName);
-
     // Place a header marker
     SV_WriteLong(ASEG_MAP_HEADER);
 
@@ -2069,9 +2114,6 @@ void SV_SaveMap(boolean savePlayers)
 
     // Place a termination marker
     SV_WriteLong(ASEG_END);
-
-    // Close the output file
-    SV_Close();
 }
 
 //==========================================================================
@@ -2083,7 +2125,6 @@ void SV_SaveMap(boolean savePlayers)
 void SV_LoadGame(int slot)
 {
     int i;
-    char fileName[RD_MAX_PATH];
     char version_text[HXS_VERSION_TEXT_LENGTH];
     player_t playerBackup[MAXPLAYERS];
     mobj_t *mobj;
@@ -2095,14 +2136,11 @@ void SV_LoadGame(int slot)
         CopySaveSlot(slot, BASE_SLOT);
     }
 
-    // Create the name
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-7.sav", SavePath);
-
     // Load the file
-    SV_OpenRead(fileName);
+    SV_OpenRead(BASE_SLOT, SLOT_GAME_FILE);
 
     // Set the save pointer and skip the description field
-    fseek(SavingFP, HXS_DESCRIPTION_LENGTH, SEEK_CUR);
+    mem_fseek(SavingFP, HXS_DESCRIPTION_LENGTH, MEM_SEEK_CUR);
 
     // Check the version text
 
@@ -2112,6 +2150,7 @@ void SV_LoadGame(int slot)
     }
     if (strncmp(version_text, HXS_VERSION_TEXT, HXS_VERSION_TEXT_LENGTH) != 0)
     {                           // Bad version
+        SV_Close();
         return;
     }
 
@@ -2211,7 +2250,6 @@ void SV_MapTeleport(int map, int position)
 {
     int i;
     int j;
-    char fileName[RD_MAX_PATH];
     player_t playerBackup[MAXPLAYERS];
     mobj_t *targetPlayerMobj;
     mobj_t *mobj;
@@ -2253,8 +2291,7 @@ void SV_MapTeleport(int map, int position)
     TargetPlayerAddrs = NULL;
 
     gamemap = map;
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-7%02d.sav", SavePath, gamemap);
-    if (!deathmatch && ExistingFile(fileName))
+    if (!deathmatch && BaseSlotFiles[gamemap].data != NULL)
     {                           // Unarchive map
         SV_LoadMap();
     }
@@ -2401,10 +2438,7 @@ int SV_GetRebornSlot(void)
 
 boolean SV_RebornSlotAvailable(void)
 {
-    char fileName[RD_MAX_PATH];
-
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-%d.sav", SavePath, REBORN_SLOT);
-    return ExistingFile(fileName);
+    return RebornSlotFiles[SLOT_GAME_FILE].data != NULL;
 }
 
 //==========================================================================
@@ -2415,19 +2449,14 @@ boolean SV_RebornSlotAvailable(void)
 
 void SV_LoadMap(void)
 {
-    char fileName[RD_MAX_PATH];
-
     // Load a base level
     G_InitNew(gameskill, gameepisode, gamemap);
 
     // Remove all thinkers
     RemoveAllThinkers();
 
-    // Create the name
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-7%02d.sav", SavePath, gamemap);
-
     // Load the file
-    SV_OpenRead(fileName);
+    SV_OpenRead(BASE_SLOT, gamemap);
 
     AssertSegment(ASEG_MAP_HEADER);
 
@@ -2463,6 +2492,86 @@ void SV_InitBaseSlot(void)
     SV_ClearSaveSlot(BASE_SLOT);
 }
 
+//==========================================================================
+//
+// SV_StoreRewindSnapshot
+//
+// [JN] Stores the game file and the current map file into the rewind
+// buffer, same as SV_SaveGame does for a save slot. Length of the game
+// file part is appended at the end. Other maps of the hub don't change
+// while the current map is played, and the rewind buffer is cleared when
+// the level is left, so they don't need to be stored.
+//
+//==========================================================================
+
+void SV_StoreRewindSnapshot(void)
+{
+    static char description[HXS_DESCRIPTION_LENGTH];
+    const uint64_t start = I_GetTimeUS();
+    unsigned int gamelength;
+    void *data;
+    size_t length;
+
+    SavingFP = mem_fopen_write();
+    SavingBuffer = NULL;
+
+    ArchiveGame(description);
+    gamelength = mem_ftell(SavingFP);
+
+    SavingPlayers = true;
+    ArchiveMap();
+
+    SV_WriteLong(gamelength);
+
+    mem_get_buf(SavingFP, &data, &length);
+    RW_Store(data, length, leveltime, I_GetTimeUS() - start);
+    SV_Close();
+}
+
+//==========================================================================
+//
+// SV_LoadRewindSnapshot
+//
+// [JN] Puts the previous snapshot into the base slot and loads it.
+//
+//==========================================================================
+
+boolean SV_LoadRewindSnapshot(void)
+{
+    byte *snapshot;
+    size_t length;
+    size_t gamelength;
+    int tic;
+    int i;
+
+    snapshot = RW_Restore(leveltime, &length, &tic);
+
+    if (snapshot == NULL || length < 4)
+    {
+        return false;
+    }
+
+    length -= 4;
+    gamelength = snapshot[length] | (snapshot[length + 1] << 8)
+               | (snapshot[length + 2] << 16) | ((size_t) snapshot[length + 3] << 24);
+
+    for (i = 0; i < 2; i++)
+    {
+        savebuffer_t *file = &BaseSlotFiles[i == 0 ? SLOT_GAME_FILE : gamemap];
+        const byte *data = i == 0 ? snapshot : snapshot + gamelength;
+        const size_t size = i == 0 ? gamelength : length - gamelength;
+
+        free(file->data);
+        file->data = malloc(size);
+        file->length = size;
+        memcpy(file->data, data, size);
+    }
+
+    SV_LoadGame(BASE_SLOT);
+
+    return true;
+}
+
 //==========================================================================
 //
 // ArchivePlayers
@@ -3327,191 +3436,167 @@ static void AssertSegment(gameArchiveSegment_t segType)
 
 //==========================================================================
 //
-// SV_ClearSaveSlot
+// MemorySlot
 //
-// Deletes all save game files associated with a slot number.
+// [JN] Returns in-memory files of the slot, or NULL for slots on disk.
 //
 //==========================================================================
 
-void SV_ClearSaveSlot(int slot)
+static savebuffer_t *MemorySlot(int slot)
 {
-    int i;
-    char fileName[RD_MAX_PATH];
+    switch (slot)
+    {
+        case BASE_SLOT:
+            return BaseSlotFiles;
+        case REBORN_SLOT:
+            return RebornSlotFiles;
+        default:
+            return NULL;
+    }
+}
 
-    for (i = 0; i < MAX_MAPS + 1; i++)
+//==========================================================================
+//
+// SaveFileName
+//
+//==========================================================================
+
+static void SaveFileName(char *name, size_t size, int slot, int file)
+{
+    if (file == SLOT_GAME_FILE)
     {
-        M_snprintf(fileName, sizeof(fileName),
-                   "%shexen-save-%d%02d.sav", SavePath, slot, i);
-        if(M_FileExists(fileName))
-        {
-            M_remove(fileName);
-        }
+        M_snprintf(name, size, "%shexen-save-%d.sav", SavePath, slot);
     }
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-%d.sav", SavePath, slot);
-    if(M_FileExists(fileName))
+    else
     {
-        M_remove(fileName);
+        M_snprintf(name, size, "%shexen-save-%d%02d.sav", SavePath, slot, file);
     }
 }
 
 //==========================================================================
 //
-// CopySaveSlot
+// SV_ClearSaveSlot
 //
-// Copies all the save game files from one slot to another.
+// Deletes all save game files associated with a slot number.
 //
 //==========================================================================
 
-static void CopySaveSlot(int sourceSlot, int destSlot)
+void SV_ClearSaveSlot(int slot)
 {
     int i;
-    char sourceName[RD_MAX_PATH];
-    char destName[RD_MAX_PATH];
+    char fileName[RD_MAX_PATH];
+    savebuffer_t *files = MemorySlot(slot);
 
-    for (i = 0; i < MAX_MAPS; i++)
+    for (i = 0; i < SLOT_FILES; i++)
     {
-        M_snprintf(sourceName, sizeof(sourceName),
-                   "%shexen-save-%d%02d.sav", SavePath, sourceSlot, i);
-        if (ExistingFile(sourceName))
+        if (files)
         {
-            M_snprintf(destName, sizeof(destName),
-                       "%shexen-save-%d%02d.sav", SavePath, destSlot, i);
-            CopyFile(sourceName, destName);
+            free(files[i].data);
+            files[i].data = NULL;
+            files[i].length = 0;
+        }
+        else
+        {
+            SaveFileName(fileName, sizeof(fileName), slot, i);
+            M_RemoveFileAsync(fileName);
         }
-    }
-    M_snprintf(sourceName, sizeof(sourceName),
-               "%shexen-save-%d.sav", SavePath, sourceSlot);
-    if (ExistingFile(sourceName))
-    {
-        M_snprintf(destName, sizeof(destName),
-                   "%shexen-save-%d.sav", SavePath, destSlot);
-        CopyFile(sourceName, destName);
     }
 }
 
 //==========================================================================
 //
-// CopyFile
+// CopySaveSlot
+//
+// Copies all the save game files from one slot to another.
+// [JN] Slots on disk are compressed and written in background,
+// and read synchronously. Description and version text of the game
+// file are left uncompressed for the menu.
 //
-// This function was rewritten to copy files with minimal strain on zone
-// allocation and allow for big maps that technically work in vanilla to
-// save without error.
 //==========================================================================
 
-static void CopyFile(char *source_name, char *dest_name)
+static void CopySaveSlot(int sourceSlot, int destSlot)
 {
-    const int BUFFER_CHUNK_SIZE = 0x10000;
-
-    byte *buffer;
-    int /*file_length,*/ file_remaining;
-    FILE *read_handle, *write_handle;
-    int buf_count, read_count, write_count;
-
-    read_handle = M_fopen(source_name, "rb");
-    if (read_handle == NULL)
-    {
-        I_QuitWithError(english_language ?
-                        "Could not load savegame %s" :
-                        "Невозможно прочитать файл %s",
-                        source_name);
-    }
-    /*file_length = */file_remaining = M_FileLength(read_handle);
-
-    // Vanilla savegame emulation.
-    //
-    // CopyFile() typically calls M_ReadFile() which stores the entire file
-    // in memory: Chocolate Hexen should force an allocation error here
-    // whenever it's appropriate.
-
-    // [JN] Лимит сохранения отключен
-    /*
-    if (vanilla_savegame_limit)
-    {
-        buffer = Z_Malloc(file_length, PU_STATIC, NULL);
-        Z_Free(buffer);
-    }
-    */
+    int i;
+    char sourceName[RD_MAX_PATH];
+    char destName[RD_MAX_PATH];
+    savebuffer_t *sourceFiles = MemorySlot(sourceSlot);
+    savebuffer_t *destFiles = MemorySlot(destSlot);
 
-    write_handle = M_fopen(dest_name, "wb");
-    if (write_handle == NULL)
+    for (i = 0; i < SLOT_FILES; i++)
     {
-        I_QuitWithError(english_language ?
-                        "Couldn't read file %s" :
-                        "Невозможно прочитать файл %s",
-                        dest_name);
-    }
-
-    buffer = Z_Malloc (BUFFER_CHUNK_SIZE, PU_STATIC, NULL);
+        const size_t head = i == SLOT_GAME_FILE ?
+                            HXS_DESCRIPTION_LENGTH + HXS_VERSION_TEXT_LENGTH : 0;
+        byte *data;
+        size_t length;
 
-    do
-    {
-        buf_count = BUFFER_CHUNK_SIZE;
-        if( file_remaining < BUFFER_CHUNK_SIZE)
+        if (sourceFiles)
         {
-            buf_count = file_remaining;
+            if (sourceFiles[i].data == NULL)
+            {
+                continue;
+            }
+            data = sourceFiles[i].data;
+            length = sourceFiles[i].length;
         }
-
-        read_count = fread(buffer, 1, buf_count, read_handle);
-        if (read_count < buf_count)
+        else
         {
-            I_QuitWithError(english_language ?
-                            "Couldn't read file %s" :
-                            "Невозможно прочитать файл %s",
-                            source_name);
+            SaveFileName(sourceName, sizeof(sourceName), sourceSlot, i);
+            data = M_ReadSaveGame(sourceName, head, &length);
+            if (data == NULL)
+            {
+                continue;
+            }
         }
 
-        write_count = fwrite(buffer, 1, buf_count, write_handle);
-        if (write_count < buf_count)
+        if (destFiles)
         {
-            I_QuitWithError(english_language ?
-                            "Couldn't write to file %s" :
-                            "Невозможно записать файл %s",
-                            dest_name);
+            free(destFiles[i].data);
+            destFiles[i].data = malloc(length);
+            destFiles[i].length = length;
+            memcpy(destFiles[i].data, data, length);
+        }
+        else
+        {
+            SaveFileName(destName, sizeof(destName), destSlot, i);
+            M_WriteSaveGameAsync(destName, data, length, head);
         }
 
-        file_remaining -= buf_count;
-    } while (file_remaining > 0);
-
-    Z_Free(buffer);
-    fclose(read_handle);
-    fclose(write_handle);
+        if (sourceFiles == NULL)
+        {
+            Z_Free(data);
+        }
+    }
 }
 
 //==========================================================================
 //
-// ExistingFile
+// SV_Open
 //
 //==========================================================================
 
-static boolean ExistingFile(char *name)
+static void SV_OpenRead(int slot, int file)
 {
-    FILE *fp;
+    savebuffer_t *buffer = &MemorySlot(slot)[file];
 
-    if ((fp = M_fopen(name, "rb")) != NULL)
+    if (buffer->data == NULL)
     {
-        fclose(fp);
-        return true;
-    }
-    else
-    {
-        return false;
-    }
-}
+        char fileName[RD_MAX_PATH];
 
-//==========================================================================
-//
-// SV_Open
-//
-//==========================================================================
+        SaveFileName(fileName, sizeof(fileName), slot, file);
+        I_QuitWithError(english_language ?
+                        "Could not load savegame %s" :
+                        "Невозможно прочитать файл %s",
+                        fileName);
+    }
 
-static void SV_OpenRead(char *fileName)
-{
-    SavingFP = M_fopen(fileName, "rb");
+    SavingFP = mem_fopen_read(buffer->data, buffer->length);
+    SavingBuffer = NULL;
 }
 
-static void SV_OpenWrite(char *fileName)
+static void SV_OpenWrite(int slot, int file)
 {
-    SavingFP = M_fopen(fileName, "wb");
+    SavingFP = mem_fopen_write();
+    SavingBuffer = &MemorySlot(slot)[file];
 }
 
 //==========================================================================
@@ -3522,9 +3607,24 @@ static void SV_OpenWrite(char *fileName)
 
 static void SV_Close(void)
 {
+    if (SavingBuffer)
+    {
+        void *data;
+        size_t length;
+
+        mem_get_buf(SavingFP, &data, &length);
+
+        free(SavingBuffer->data);
+        SavingBuffer->data = malloc(length);
+        SavingBuffer->length = length;
+        memcpy(SavingBuffer->data, data, length);
+        SavingBuffer = NULL;
+    }
+
     if (SavingFP)
     {
-        fclose(SavingFP);
+        mem_fclose(SavingFP);
+        SavingFP = NULL;
     }
 }
 
@@ -3536,7 +3636,7 @@ static void SV_Close(void)
 
 static void SV_Read(void *buffer, int size)
 {
-    int retval = fread(buffer, 1, size, SavingFP);
+    int retval = mem_fread(buffer, 1, size, SavingFP);
     if (retval != size)
     {
         I_QuitWithError(english_language ?
@@ -3587,24 +3687,24 @@ static void *SV_ReadPtr(void)
 
 static void SV_Write(void *buffer, int size)
 {
-    fwrite(buffer, size, 1, SavingFP);
+    mem_fwrite(buffer, size, 1, SavingFP);
 }
 
 static void SV_WriteByte(byte val)
 {
-    fwrite(&val, sizeof(byte), 1, SavingFP);
+    mem_fwrite(&val, sizeof(byte), 1, SavingFP);
 }
 
 static void SV_WriteWord(unsigned short val)
 {
     val = SHORT(val);
-    fwrite(&val, sizeof(unsigned short), 1, SavingFP);
+    mem_fwrite(&val, sizeof(unsigned short), 1, SavingFP);
 }
 
 static void SV_WriteLong(unsigned int val)
 {
     val = LONG(val);
-    fwrite(&val, sizeof(int), 1, SavingFP);
+    mem_fwrite(&val, sizeof(int), 1, SavingFP);
 }
 
 static void SV_WriteLongLong(int64_t val)
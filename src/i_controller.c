@@ -608,7 +608,7 @@ void ControllerHandler_HandleLine(char* keyName, char *value, size_t valueSize)
     }
 }
 
-void ControllerHandler_Save(FILE* file, char* sectionName)
+void ControllerHandler_Save(config_text_t* text, char* sectionName)
 {
     controller_t* temp = knownControllers;
     while(temp)
@@ -617,18 +617,18 @@ void ControllerHandler_Save(FILE* file, char* sectionName)
         {
             for(SDL_GameControllerAxis i = SDL_CONTROLLER_AXIS_LEFTX; i < SDL_CONTROLLER_AXIS_MAX; ++i)
             {
-                fprintf(file, "%s_%s = %s\n",
-                        axesNames[i], axesOptionsNames[AO_BIND],
-                        axisBindsNames[temp->bindAxis[i]]);
-                fprintf(file, "%s_%s = %d\n",
-                        axesNames[i], axesOptionsNames[AO_INVERT],
-                        temp->invertAxis[i]);
-                fprintf(file, "%s_%s = %d\n",
-                        axesNames[i], axesOptionsNames[AO_DEADZONE],
-                        temp->axisDeadZone[i]);
-                fprintf(file, "%s_%s = %d\n",
-                        axesNames[i], axesOptionsNames[AO_SENSITIVITY],
-                        temp->axisSensitivity[i]);
+                M_ConfigPrintf(text, "%s_%s = %s\n",
+                               axesNames[i], axesOptionsNames[AO_BIND],
+                               axisBindsNames[temp->bindAxis[i]]);
+                M_ConfigPrintf(text, "%s_%s = %d\n",
+                               axesNames[i], axesOptionsNames[AO_INVERT],
+                               temp->invertAxis[i]);
+                M_ConfigPrintf(text, "%s_%s = %d\n",
+                               axesNames[i], axesOptionsNames[AO_DEADZONE],
+                               temp->axisDeadZone[i]);
+                M_ConfigPrintf(text, "%s_%s = %d\n",
+                               axesNames[i], axesOptionsNames[AO_SENSITIVITY],
+                               temp->axisSensitivity[i]);
             }
         }
         temp = temp->next;
@@ -21,6 +21,7 @@
 #pragma once
 #include <stdio.h>
 #include <SDL_gamecontroller.h>
+#include "m_config.h"
 
 
 // DOOM Controller definition
@@ -99,5 +100,5 @@ void I_UpdateController(void);
 void I_BindControllerVariables(void);
 boolean ControllerHandler_isHandling(char* sectionName);
 void ControllerHandler_HandleLine(char* keyName, char *value, size_t valueSize);
-void ControllerHandler_Save(FILE* file, char* sectionName);
+void ControllerHandler_Save(config_text_t* text, char* sectionName);
 void ControllerHandler_onFinishHandling();
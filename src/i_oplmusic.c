@@ -22,12 +22,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "SDL.h"
+
 #include "memio.h"
 #include "mus2mid.h"
 #include "deh_main.h"
 #include "i_sound.h"
 #include "i_swap.h"
+#include "m_config.h"
 #include "m_misc.h"
+#include "sha1.h"
 #include "w_wad.h"
 #include "z_zone.h"
 #include "opl.h"
@@ -97,15 +101,6 @@ typedef struct
 
 } opl_channel_data_t;
 
-// Data associated with a track that is currently playing.
-
-typedef struct
-{
-    // Track iterator used to read new events.
-
-    midi_track_iter_t *iter;
-} opl_track_data_t;
-
 typedef struct opl_voice_s opl_voice_t;
 
 struct opl_voice_s
@@ -329,11 +324,11 @@ static int num_opl_voices;
 
 static opl_channel_data_t channels[MIDI_CHANNELS_PER_TRACK];
 
-// Track data for playing tracks:
+// [JN] Song that is currently playing, with all of its tracks merged
+// into a single stream of events, and position of the next event in it:
 
-static opl_track_data_t *tracks;
-static unsigned int num_tracks = 0;
-static unsigned int running_tracks = 0;
+static midi_flat_song_t *playing_song = NULL;
+static unsigned int song_position;
 static boolean song_looping;
 
 // Tempo control variables
@@ -352,6 +347,13 @@ static unsigned int last_perc_count;
 char *snd_dmxoption = "-opl3"; // [crispy] default to OPL3 emulation
 int opl_io_port = 0x388;
 
+// [JN] Render songs in background instead of emulating the chip in real
+// time, and maximum number of bytes of rendered songs to keep on disk.
+// (Default: no, 128MB)
+
+int opl_render = 0;
+int opl_diskcachesize = 128 * 1024 * 1024;
+
 // If true, OPL sound channels are reversed to their correct arrangement
 // (as intended by the MIDI standard) rather than the backwards one
 // used by DMX due to a bug.
@@ -631,6 +633,9 @@ static void InitVoices(void)
 
 static void SetChannelVolume(opl_channel_data_t *channel, unsigned int volume,
                              boolean clip_start);
+static void StartRender(void);
+static void StopRender(void);
+static boolean RenderIsActive(int volume);
 
 // Set music volume (0 - 15)
 
@@ -663,6 +668,15 @@ static void I_OPL_SetMusicVolume(int volume)
             SetChannelVolume(&channels[i], channels[i].volume_base, false);
         }
     }
+
+    // [JN] The rendered song has the previous volume baked in, so it
+    // has to be rendered again.
+
+    if (RenderIsActive(volume))
+    {
+        StopRender();
+        StartRender();
+    }
 }
 
 static void VoiceKeyOff(opl_voice_t *voice)
@@ -671,10 +685,9 @@ static void VoiceKeyOff(opl_voice_t *voice)
                       voice->freq >> 8);
 }
 
-static opl_channel_data_t *TrackChannelForEvent(opl_track_data_t *track,
-                                                midi_event_t *event)
+static opl_channel_data_t *ChannelForEvent(midi_flat_event_t *event)
 {
-    unsigned int channel_num = event->data.channel.channel;
+    unsigned int channel_num = event->channel;
 
     // MIDI uses track #9 for percussion, but for MUS it's track #15
     // instead. Because DMX works on MUS data internally, we need to
@@ -693,7 +706,7 @@ static opl_channel_data_t *TrackChannelForEvent(opl_track_data_t *track,
 
 // Get the frequency that we should be using for a voice.
 
-static void KeyOffEvent(opl_track_data_t *track, midi_event_t *event)
+static void KeyOffEvent(midi_flat_event_t *event)
 {
     opl_channel_data_t *channel;
     int i;
@@ -701,13 +714,13 @@ static void KeyOffEvent(opl_track_data_t *track, midi_event_t *event)
 
 /*
     printf("note off: channel %i, %i, %i\n",
-           event->data.channel.channel,
-           event->data.channel.param1,
-           event->data.channel.param2);
+           event->channel,
+           event->param1,
+           event->param2);
 */
 
-    channel = TrackChannelForEvent(track, event);
-    key = event->data.channel.param1;
+    channel = ChannelForEvent(event);
+    key = event->param1;
 
     // Turn off voices being used to play this key.
     // If it is a double voice instrument there will be two.
@@ -961,7 +974,7 @@ static void VoiceKeyOn(opl_channel_data_t *channel,
     UpdateVoiceFrequency(voice);
 }
 
-static void KeyOnEvent(opl_track_data_t *track, midi_event_t *event)
+static void KeyOnEvent(midi_flat_event_t *event)
 {
     genmidi_instr_t *instrument;
     opl_channel_data_t *channel;
@@ -970,29 +983,29 @@ static void KeyOnEvent(opl_track_data_t *track, midi_event_t *event)
 
 /*
     printf("note on: channel %i, %i, %i\n",
-           event->data.channel.channel,
-           event->data.channel.param1,
-           event->data.channel.param2);
+           event->channel,
+           event->param1,
+           event->param2);
 */
 
-    note = event->data.channel.param1;
-    key = event->data.channel.param1;
-    volume = event->data.channel.param2;
+    note = event->param1;
+    key = event->param1;
+    volume = event->param2;
 
     // A volume of zero means key off. Some MIDI tracks, eg. the ones
     // in AV.wad, use a second key on with a volume of zero to mean
     // key off.
     if (volume <= 0)
     {
-        KeyOffEvent(track, event);
+        KeyOffEvent(event);
         return;
     }
 
     // The channel.
-    channel = TrackChannelForEvent(track, event);
+    channel = ChannelForEvent(event);
 
     // Percussion channel is treated differently.
-    if (event->data.channel.channel == 9)
+    if (event->channel == 9)
     {
         if (key < 35 || key > 81)
         {
@@ -1075,15 +1088,15 @@ static void KeyOnEvent(opl_track_data_t *track, midi_event_t *event)
     }
 }
 
-static void ProgramChangeEvent(opl_track_data_t *track, midi_event_t *event)
+static void ProgramChangeEvent(midi_flat_event_t *event)
 {
     opl_channel_data_t *channel;
     int instrument;
 
     // Set the instrument used on this channel.
 
-    channel = TrackChannelForEvent(track, event);
-    instrument = event->data.channel.param1;
+    channel = ChannelForEvent(event);
+    instrument = event->param1;
     channel->instrument = &main_instrs[instrument];
 
     // TODO: Look through existing voices that are turned on on this
@@ -1181,7 +1194,7 @@ static void AllNotesOff(opl_channel_data_t *channel, unsigned int param)
     }
 }
 
-static void ControllerEvent(opl_track_data_t *track, midi_event_t *event)
+static void ControllerEvent(midi_flat_event_t *event)
 {
     opl_channel_data_t *channel;
     unsigned int controller;
@@ -1189,14 +1202,14 @@ static void ControllerEvent(opl_track_data_t *track, midi_event_t *event)
 
 /*
     printf("change controller: channel %i, %i, %i\n",
-           event->data.channel.channel,
-           event->data.channel.param1,
-           event->data.channel.param2);
+           event->channel,
+           event->param1,
+           event->param2);
 */
 
-    channel = TrackChannelForEvent(track, event);
-    controller = event->data.channel.param1;
-    param = event->data.channel.param2;
+    channel = ChannelForEvent(event);
+    controller = event->param1;
+    param = event->param2;
 
     switch (controller)
     {
@@ -1225,7 +1238,7 @@ static void ControllerEvent(opl_track_data_t *track, midi_event_t *event)
 
 // Process a pitch bend event.
 
-static void PitchBendEvent(opl_track_data_t *track, midi_event_t *event)
+static void PitchBendEvent(midi_flat_event_t *event)
 {
     opl_channel_data_t *channel;
     int i;
@@ -1237,8 +1250,8 @@ static void PitchBendEvent(opl_track_data_t *track, midi_event_t *event)
     // Update the channel bend value.  Only the MSB of the pitch bend
     // value is considered: this is what Doom does.
 
-    channel = TrackChannelForEvent(track, event);
-    channel->bend = event->data.channel.param2 - 64;
+    channel = ChannelForEvent(event);
+    channel->bend = event->param2 - 64;
 
     // Update all voices for this channel.
 
@@ -1273,37 +1286,19 @@ static void MetaSetTempo(unsigned int tempo)
     us_per_beat = tempo;
 }
 
-// Process a meta event.
+// Process a meta event. Only tempo changes and the end of the song are
+// kept when a song is merged into a single stream.
 
-static void MetaEvent(opl_track_data_t *track, midi_event_t *event)
+static void MetaEvent(midi_flat_event_t *event)
 {
-    byte *data = event->data.meta.data;
-    unsigned int data_len = event->data.meta.length;
-
-    switch (event->data.meta.type)
+    switch (event->param1)
     {
-        // Things we can just ignore.
-
-        case MIDI_META_SEQUENCE_NUMBER:
-        case MIDI_META_TEXT:
-        case MIDI_META_COPYRIGHT:
-        case MIDI_META_TRACK_NAME:
-        case MIDI_META_INSTR_NAME:
-        case MIDI_META_LYRICS:
-        case MIDI_META_MARKER:
-        case MIDI_META_CUE_POINT:
-        case MIDI_META_SEQUENCER_SPECIFIC:
-            break;
-
         case MIDI_META_SET_TEMPO:
-            if (data_len == 3)
-            {
-                MetaSetTempo((data[0] << 16) | (data[1] << 8) | data[2]);
-            }
+            MetaSetTempo(event->tempo);
             break;
 
         // End of track - actually handled when we run out of events
-        // in the track, see below.
+        // in the song, see below.
 
         case MIDI_META_END_OF_TRACK:
             break;
@@ -1313,46 +1308,40 @@ static void MetaEvent(opl_track_data_t *track, midi_event_t *event)
             printf(english_language ?
                             "Unknown MIDI meta event type: %i\n" :
                             "Неизвестный тип мета-события MIDI: %i\n",
-                            event->data.meta.type);
+                            event->param1);
 #endif
             break;
     }
 }
 
-// Process a MIDI event from a track.
+// Process a MIDI event from the song.
 
-static void ProcessEvent(opl_track_data_t *track, midi_event_t *event)
+static void ProcessEvent(midi_flat_event_t *event)
 {
     switch (event->event_type)
     {
         case MIDI_EVENT_NOTE_OFF:
-            KeyOffEvent(track, event);
+            KeyOffEvent(event);
             break;
 
         case MIDI_EVENT_NOTE_ON:
-            KeyOnEvent(track, event);
+            KeyOnEvent(event);
             break;
 
         case MIDI_EVENT_CONTROLLER:
-            ControllerEvent(track, event);
+            ControllerEvent(event);
             break;
 
         case MIDI_EVENT_PROGRAM_CHANGE:
-            ProgramChangeEvent(track, event);
+            ProgramChangeEvent(event);
             break;
 
         case MIDI_EVENT_PITCH_BEND:
-            PitchBendEvent(track, event);
+            PitchBendEvent(event);
             break;
 
         case MIDI_EVENT_META:
-            MetaEvent(track, event);
-            break;
-
-        // SysEx events can be ignored.
-
-        case MIDI_EVENT_SYSEX:
-        case MIDI_EVENT_SYSEX_SPLIT:
+            MetaEvent(event);
             break;
 
         default:
@@ -1366,7 +1355,7 @@ static void ProcessEvent(opl_track_data_t *track, midi_event_t *event)
     }
 }
 
-static void ScheduleTrack(opl_track_data_t *track);
+static void ScheduleNextEvent(unsigned int now);
 static void InitChannel(opl_channel_data_t *channel);
 
 // Restart a song from the beginning.
@@ -1375,15 +1364,11 @@ static void RestartSong(void *unused)
 {
     unsigned int i;
 
-    running_tracks = num_tracks;
+    song_position = 0;
 
     start_music_volume = current_music_volume;
 
-    for (i = 0; i < num_tracks; ++i)
-    {
-        MIDI_RestartIterator(tracks[i].iter);
-        ScheduleTrack(&tracks[i]);
-    }
+    ScheduleNextEvent(0);
 
     for (i = 0; i < MIDI_CHANNELS_PER_TRACK; ++i)
     {
@@ -1391,64 +1376,67 @@ static void RestartSong(void *unused)
     }
 }
 
-// Callback function invoked when another event needs to be read from
-// a track.
+// Callback function invoked when the next events of the song are due.
+// [JN] All events with the same time are processed at once, so the
+// callback queue only ever holds a single entry for the song.
 
-static void TrackTimerCallback(void *arg)
+static void SongTimerCallback(void *arg)
 {
-    opl_track_data_t *track = arg;
-    midi_event_t *event;
+    midi_flat_event_t *event;
+    unsigned int now;
 
-    // Get the next event and process it.
-
-    if (!MIDI_GetNextEvent(track->iter, &event))
+    if (playing_song == NULL || song_position >= playing_song->num_events)
     {
         return;
     }
 
-    ProcessEvent(track, event);
-
-    // End of track?
+    now = playing_song->events[song_position].time;
 
-    if (event->event_type == MIDI_EVENT_META
-     && event->data.meta.type == MIDI_META_END_OF_TRACK)
+    do
     {
-        --running_tracks;
+        event = &playing_song->events[song_position++];
 
-        // When all tracks have finished, restart the song.
-        // Don't restart the song immediately, but wait for 5ms
-        // before triggering a restart.  Otherwise it is possible
-        // to construct an empty MIDI file that causes the game
-        // to lock up in an infinite loop. (5ms should be short
-        // enough not to be noticeable by the listener).
+        // End of song?
 
-        if (running_tracks <= 0 && song_looping)
+        if (event->event_type == MIDI_EVENT_META
+         && event->param1 == MIDI_META_END_OF_TRACK)
         {
-            OPL_SetCallback(5000, RestartSong, NULL);
+            // Don't restart the song immediately, but wait for 5ms
+            // before triggering a restart.  Otherwise it is possible
+            // to construct an empty MIDI file that causes the game
+            // to lock up in an infinite loop. (5ms should be short
+            // enough not to be noticeable by the listener).
+
+            if (song_looping)
+            {
+                OPL_SetCallback(5000, RestartSong, NULL);
+            }
+
+            return;
         }
 
-        return;
-    }
+        ProcessEvent(event);
+    } while (playing_song->events[song_position].time == now);
 
-    // Reschedule the callback for the next event in the track.
+    // Reschedule the callback for the next event in the song.
 
-    ScheduleTrack(track);
+    ScheduleNextEvent(now);
 }
 
-static void ScheduleTrack(opl_track_data_t *track)
+static void ScheduleNextEvent(unsigned int now)
 {
     unsigned int nticks;
     uint64_t us;
 
     // Get the number of microseconds until the next event.
 
-    nticks = MIDI_GetDeltaTime(track->iter);
+    nticks = playing_song->events[song_position].time - now;
     us = ((uint64_t) nticks * us_per_beat) / ticks_per_beat;
 
     // Set a timer to be invoked when the next event is
     // ready to play.
 
-    OPL_SetCallback(us, TrackTimerCallback, track);
+    OPL_SetCallback(us, SongTimerCallback, NULL);
 }
 
 // Initialize a channel.
@@ -1468,60 +1456,550 @@ static void InitChannel(opl_channel_data_t *channel)
     channel->bend = 0;
 }
 
-// Start a MIDI track playing:
+// Set up the sequencer to play a song from the beginning.
 
-static void StartTrack(midi_file_t *file, unsigned int track_num)
+static void StartSequencer(midi_flat_song_t *song, boolean looping)
 {
-    opl_track_data_t *track;
+    unsigned int i;
+
+    playing_song = song;
+    song_position = 0;
+    song_looping = looping;
 
-    track = &tracks[track_num];
-    track->iter = MIDI_IterateTrack(file, track_num);
+    ticks_per_beat = playing_song->time_division;
+
+    // Default is 120 bpm.
+    // TODO: this is wrong
+
+    us_per_beat = 500 * 1000;
+
+    start_music_volume = current_music_volume;
 
     // Schedule the first event.
 
-    ScheduleTrack(track);
+    ScheduleNextEvent(0);
+
+    for (i = 0; i < MIDI_CHANNELS_PER_TRACK; ++i)
+    {
+        InitChannel(&channels[i]);
+    }
 }
 
-// Start playing a mid
+//----------------------------------------------------------------------
+//
+// [JN] Offline rendering.
+//
+// When a looping song starts, the sequencer is run through the whole
+// song at once with register writes recorded instead of sent to the
+// chip. The recording is then played by a separate emulator on a
+// background thread, and once it's done, the SDL driver mixes the
+// rendered song instead of emulating the chip. Until then, and when
+// the driver has no software emulator, music plays in real time as
+// usual. The sequencer keeps running in both cases, so real time
+// playback can take over at any moment.
+//
+// Rendered songs are kept on disk in files named after SHA-1 of the
+// recording, which covers the song, GENMIDI lump, volume and all OPL
+// settings, plus the sample rate. The index file lists them from the
+// least recently used one, and is trimmed to opl_diskcachesize.
+//
+//----------------------------------------------------------------------
 
-static void I_OPL_PlaySong(void *handle, boolean looping)
+#define RENDER_MAX_TIME         (8 * 60 * OPL_SECOND)
+#define RENDER_CACHE_MAGIC      "RDOPL1"
+#define RENDER_CACHE_INDEX      "index.txt"
+#define RENDER_CACHE_NAME_LEN   64
+
+typedef struct
 {
-    midi_file_t *file;
-    unsigned int i;
+    char magic[8];
+    uint32_t samplerate;
+    uint32_t length;    // Length of the song in samples
+} render_cache_header_t;
 
-    if (!music_initialized || handle == NULL)
+typedef struct
+{
+    char name[RENDER_CACHE_NAME_LEN];
+    unsigned int size;
+} render_cache_entry_t;
+
+// Sequencer state, saved while a song is recorded.
+
+typedef struct
+{
+    opl_voice_t voices[OPL_NUM_VOICES * 2];
+    opl_voice_t *voice_free_list[OPL_NUM_VOICES * 2];
+    opl_voice_t *voice_alloced_list[OPL_NUM_VOICES * 2];
+    int voice_free_num;
+    int voice_alloced_num;
+    opl_channel_data_t channels[MIDI_CHANNELS_PER_TRACK];
+    midi_flat_song_t *playing_song;
+    unsigned int song_position;
+    boolean song_looping;
+    unsigned int ticks_per_beat;
+    unsigned int us_per_beat;
+    int start_music_volume;
+    uint8_t last_perc[PERCUSSION_LOG_LEN];
+    unsigned int last_perc_count;
+} sequencer_state_t;
+
+static sequencer_state_t saved_state;
+
+// Song being rendered. Only render_cancel may change while the thread
+// runs, protected by render_mutex.
+
+static SDL_Thread *render_thread = NULL;
+static SDL_mutex *render_mutex = NULL;
+static boolean render_cancel;
+static opl_capture_t render_capture;
+static unsigned int render_rate;
+static unsigned int render_length;
+static int render_volume;
+static char render_cache_name[RENDER_CACHE_NAME_LEN];
+static char *render_cache_dir = NULL;
+
+// Rendered song which is being played.
+
+static int16_t *render_samples = NULL;
+
+#define SAVE_STATE(x) memcpy(&saved_state.x, &x, sizeof(x))
+#define RESTORE_STATE(x) memcpy(&x, &saved_state.x, sizeof(x))
+
+static void SaveSequencerState(void)
+{
+    SAVE_STATE(voices);
+    SAVE_STATE(voice_free_list);
+    SAVE_STATE(voice_alloced_list);
+    SAVE_STATE(voice_free_num);
+    SAVE_STATE(voice_alloced_num);
+    SAVE_STATE(channels);
+    SAVE_STATE(playing_song);
+    SAVE_STATE(song_position);
+    SAVE_STATE(song_looping);
+    SAVE_STATE(ticks_per_beat);
+    SAVE_STATE(us_per_beat);
+    SAVE_STATE(start_music_volume);
+    SAVE_STATE(last_perc);
+    SAVE_STATE(last_perc_count);
+}
+
+static void RestoreSequencerState(void)
+{
+    RESTORE_STATE(voices);
+    RESTORE_STATE(voice_free_list);
+    RESTORE_STATE(voice_alloced_list);
+    RESTORE_STATE(voice_free_num);
+    RESTORE_STATE(voice_alloced_num);
+    RESTORE_STATE(channels);
+    RESTORE_STATE(playing_song);
+    RESTORE_STATE(song_position);
+    RESTORE_STATE(song_looping);
+    RESTORE_STATE(ticks_per_beat);
+    RESTORE_STATE(us_per_beat);
+    RESTORE_STATE(start_music_volume);
+    RESTORE_STATE(last_perc);
+    RESTORE_STATE(last_perc_count);
+}
+
+// Record register writes of one pass through the song, starting from
+// freshly initialized chip and voices.
+
+static boolean CaptureSong(midi_flat_song_t *song, opl_capture_t *capture)
+{
+    boolean result;
+
+    OPL_Lock();
+    SaveSequencerState();
+
+    OPL_StartCapture(capture);
+    OPL_InitRegisters(opl_opl3mode);
+    InitVoices();
+    StartSequencer(song, false);
+
+    result = OPL_RunCapture(RENDER_MAX_TIME);
+
+    OPL_StopCapture();
+
+    RestoreSequencerState();
+    OPL_Unlock();
+
+    // Restart of a looping song is delayed by 5ms, see SongTimerCallback.
+
+    capture->length += 5000;
+
+    return result;
+}
+
+static void RenderCacheName(char *name, size_t name_len)
+{
+    sha1_context_t context;
+    sha1_digest_t digest;
+    char hex[sizeof(digest) * 2 + 1];
+    int i;
+
+    SHA1_Init(&context);
+    SHA1_Update(&context, (byte *) render_capture.writes,
+                render_capture.num_writes * sizeof(opl_reg_write_t));
+    SHA1_UpdateInt32(&context, render_capture.length);
+    SHA1_Final(digest, &context);
+
+    for (i = 0 ; i < sizeof(digest) ; ++i)
+    {
+        M_snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    }
+
+    M_snprintf(name, name_len, "%s-%u.pcm", hex, render_rate);
+}
+
+// Moves the song to the end of the index as the most recently used one,
+// and removes the least recently used songs beyond the size limit.
+// Called from the render thread, so doesn't use I_Realloc.
+
+static void RenderCacheTouch(unsigned int size)
+{
+    render_cache_entry_t *entries = NULL;
+    render_cache_entry_t *new_entries;
+    render_cache_entry_t entry;
+    int num_entries = 0;
+    int max_entries = 0;
+    int first = 0;
+    size_t total = size;
+    char *path, *temp_path;
+    FILE *index;
+    int i;
+
+    path = M_StringJoin(render_cache_dir, DIR_SEPARATOR_S,
+                        RENDER_CACHE_INDEX, NULL);
+    index = M_fopen(path, "r");
+
+    if (index != NULL)
     {
+        while (fscanf(index, "%63s %u", entry.name, &entry.size) == 2)
+        {
+            if (strcmp(entry.name, render_cache_name) == 0)
+            {
+                continue;
+            }
+
+            // Leave a spare entry for the song itself.
+
+            if (num_entries + 1 >= max_entries)
+            {
+                max_entries = max_entries ? max_entries * 2 : 64;
+                new_entries = realloc(entries,
+                                      max_entries * sizeof(*entries));
+
+                if (new_entries == NULL)
+                {
+                    break;
+                }
+
+                entries = new_entries;
+            }
+
+            entries[num_entries++] = entry;
+            total += entry.size;
+        }
+
+        fclose(index);
+    }
+
+    if (entries == NULL)
+    {
+        entries = malloc(sizeof(*entries));
+
+        if (entries == NULL)
+        {
+            free(path);
+            return;
+        }
+    }
+
+    M_StringCopy(entry.name, render_cache_name, sizeof(entry.name));
+    entry.size = size;
+    entries[num_entries++] = entry;
+
+    while (total > (size_t) opl_diskcachesize && first < num_entries)
+    {
+        char *file_path = M_StringJoin(render_cache_dir, DIR_SEPARATOR_S,
+                                       entries[first].name, NULL);
+        M_remove(file_path);
+        free(file_path);
+
+        total -= entries[first].size;
+        ++first;
+    }
+
+    temp_path = M_StringJoin(path, ".tmp", NULL);
+    index = M_fopen(temp_path, "w");
+
+    if (index != NULL)
+    {
+        for (i = first ; i < num_entries ; ++i)
+        {
+            fprintf(index, "%s %u\n", entries[i].name, entries[i].size);
+        }
+
+        if (fclose(index) == 0)
+        {
+#ifdef _WIN32
+            // Rename doesn't overwrite existing files on Windows.
+            M_remove(path);
+#endif
+            M_rename(temp_path, path);
+        }
+    }
+
+    free(temp_path);
+    free(path);
+    free(entries);
+}
+
+// Loads the rendered song from the disk cache.
+
+static boolean RenderCacheLoad(int16_t *samples)
+{
+    render_cache_header_t header;
+    char *path;
+    FILE *file;
+    boolean result;
+
+    path = M_StringJoin(render_cache_dir, DIR_SEPARATOR_S,
+                        render_cache_name, NULL);
+    file = M_fopen(path, "rb");
+    free(path);
+
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    result = fread(&header, sizeof(header), 1, file) == 1
+          && strncmp(header.magic, RENDER_CACHE_MAGIC, sizeof(header.magic)) == 0
+          && header.samplerate == render_rate
+          && header.length == render_length
+          && fread(samples, 4, render_length, file) == render_length;
+
+    fclose(file);
+
+    if (result)
+    {
+        RenderCacheTouch(sizeof(header) + render_length * 4);
+    }
+
+    return result;
+}
+
+// Saves the rendered song into the disk cache.
+
+static void RenderCacheStore(const int16_t *samples)
+{
+    render_cache_header_t header;
+    char *path, *temp_path;
+    FILE *file;
+    boolean result;
+
+    path = M_StringJoin(render_cache_dir, DIR_SEPARATOR_S,
+                        render_cache_name, NULL);
+    temp_path = M_StringJoin(path, ".tmp", NULL);
+    file = M_fopen(temp_path, "wb");
+
+    if (file == NULL)
+    {
+        free(temp_path);
+        free(path);
         return;
     }
 
-    file = handle;
+    memset(&header, 0, sizeof(header));
+    M_StringCopy(header.magic, RENDER_CACHE_MAGIC, sizeof(header.magic));
+    header.samplerate = render_rate;
+    header.length = render_length;
 
-    // Allocate track data.
+    result = fwrite(&header, sizeof(header), 1, file) == 1
+          && fwrite(samples, 4, render_length, file) == render_length;
+    result = fclose(file) == 0 && result;
 
-    tracks = malloc(MIDI_NumTracks(file) * sizeof(opl_track_data_t));
+    if (result)
+    {
+#ifdef _WIN32
+        M_remove(path);
+#endif
+        result = M_rename(temp_path, path) == 0;
+    }
+    else
+    {
+        M_remove(temp_path);
+    }
 
-    num_tracks = MIDI_NumTracks(file);
-    running_tracks = num_tracks;
-    song_looping = looping;
+    free(temp_path);
+    free(path);
 
-    ticks_per_beat = MIDI_GetFileTimeDivision(file);
+    if (result)
+    {
+        RenderCacheTouch(sizeof(header) + render_length * 4);
+    }
+}
 
-    // Default is 120 bpm.
-    // TODO: this is wrong
+static int RenderThread(void *unused)
+{
+    opl_render_t *render;
+    int16_t *samples;
+    unsigned int filled = 0;
+    unsigned int n;
+    boolean cancel = false;
 
-    us_per_beat = 500 * 1000;
+    samples = malloc((size_t) render_length * 4);
 
-    start_music_volume = current_music_volume;
+    if (samples == NULL)
+    {
+        return 0;
+    }
 
-    for (i = 0; i < num_tracks; ++i)
+    if (render_cache_dir != NULL)
     {
-        StartTrack(file, i);
+        RenderCacheName(render_cache_name, sizeof(render_cache_name));
     }
 
-    for (i = 0; i < MIDI_CHANNELS_PER_TRACK; ++i)
+    if (render_cache_dir != NULL && RenderCacheLoad(samples))
     {
-        InitChannel(&channels[i]);
+        filled = render_length;
     }
+    else
+    {
+        // Render in slices of 1/10 second, to stop soon when cancelled.
+
+        render = OPL_CreateRender(&render_capture, render_rate);
+
+        while (render != NULL && filled < render_length && !cancel)
+        {
+            n = OPL_Render(render, samples + filled * 2,
+                           MIN(render_rate / 10, render_length - filled));
+
+            if (n == 0)
+            {
+                break;
+            }
+
+            filled += n;
+
+            SDL_LockMutex(render_mutex);
+            cancel = render_cancel;
+            SDL_UnlockMutex(render_mutex);
+        }
+
+        if (render != NULL)
+        {
+            OPL_FreeRender(render);
+        }
+
+        if (filled == render_length && render_cache_dir != NULL)
+        {
+            RenderCacheStore(samples);
+        }
+    }
+
+    // Hand the song over to the driver, unless it is not needed anymore.
+
+    SDL_LockMutex(render_mutex);
+
+    if (filled == render_length && !render_cancel)
+    {
+        render_samples = samples;
+        samples = NULL;
+        OPL_SetStream(render_samples, render_length, 0);
+    }
+
+    SDL_UnlockMutex(render_mutex);
+
+    free(samples);
+
+    return 0;
+}
+
+// Start rendering the playing song in background.
+
+static void StartRender(void)
+{
+    unsigned int rate = OPL_GetStreamRate();
+
+    if (!opl_render || rate == 0 || render_mutex == NULL
+     || playing_song == NULL || !song_looping)
+    {
+        return;
+    }
+
+    if (!CaptureSong(playing_song, &render_capture)
+     || render_capture.num_writes == 0)
+    {
+        OPL_FreeCapture(&render_capture);
+        return;
+    }
+
+    render_rate = rate;
+    render_length = ((uint64_t) render_capture.length * rate
+                     + OPL_SECOND - 1) / OPL_SECOND;
+    render_volume = current_music_volume;
+    render_cancel = false;
+
+    render_thread = SDL_CreateThread(RenderThread, "OPL render", NULL);
+
+    if (render_thread == NULL)
+    {
+        OPL_FreeCapture(&render_capture);
+    }
+}
+
+// Stop rendering and go back to real time playback.
+
+static void StopRender(void)
+{
+    if (render_thread != NULL)
+    {
+        SDL_LockMutex(render_mutex);
+        render_cancel = true;
+        SDL_UnlockMutex(render_mutex);
+
+        SDL_WaitThread(render_thread, NULL);
+        render_thread = NULL;
+    }
+
+    if (render_samples != NULL)
+    {
+        OPL_SetStream(NULL, 0, 0);
+        free(render_samples);
+        render_samples = NULL;
+    }
+
+    OPL_FreeCapture(&render_capture);
+}
+
+// Is a song being rendered or played with other than given volume?
+
+static boolean RenderIsActive(int volume)
+{
+    return (render_thread != NULL || render_samples != NULL)
+        && render_volume != volume;
+}
+
+// Start playing a mid
+
+static void I_OPL_PlaySong(void *handle, boolean looping)
+{
+    if (!music_initialized || handle == NULL)
+    {
+        return;
+    }
+
+    StopRender();
+
+    // [JN] Rendered song starts along with the sequencer.
+
+    OPL_SetStream(NULL, 0, 1);
+
+    StartSequencer(handle, looping);
+
+    StartRender();
 
     // If the music was previously paused, it needs to be unpaused; playing
     // a new song implies that we turn off pause. This matches vanilla
@@ -1575,6 +2053,11 @@ static void I_OPL_StopSong(void)
         return;
     }
 
+    // [JN] Stop rendering first, the render thread may still hand the
+    // song over to the driver.
+
+    StopRender();
+
     OPL_Lock();
 
     // Stop all playback.
@@ -1588,17 +2071,10 @@ static void I_OPL_StopSong(void)
         AllNotesOff(&channels[i], 0);
     }
 
-    // Free all track data.
-
-    for (i = 0; i < num_tracks; ++i)
-    {
-        MIDI_FreeIterator(tracks[i].iter);
-    }
-
-    free(tracks);
+    // The song data belongs to its handle, which is freed when the
+    // song is unregistered.
 
-    tracks = NULL;
-    num_tracks = 0;
+    playing_song = NULL;
 
     OPL_Unlock();
 }
@@ -1612,7 +2088,7 @@ static void I_OPL_UnRegisterSong(void *handle)
 
     if (handle != NULL)
     {
-        MIDI_FreeFile(handle);
+        MIDI_FreeFlatSong(handle);
     }
 }
 
@@ -1623,24 +2099,24 @@ static boolean IsMid(byte *mem, int len)
     return len > 4 && !memcmp(mem, "MThd", 4);
 }
 
-static boolean ConvertMus(byte *musdata, int len, char *filename)
+// [JN] Convert MUS to MIDI and load it, without a temporary file.
+
+static midi_file_t *ConvertMus(byte *musdata, int len)
 {
     MEMFILE *instream;
     MEMFILE *outstream;
     void *outbuf;
     size_t outbuf_len;
-    int result;
+    midi_file_t *result = NULL;
 
     instream = mem_fopen_read(musdata, len);
     outstream = mem_fopen_write();
 
-    result = mus2mid(instream, outstream);
-
-    if (result == 0)
+    if (mus2mid(instream, outstream) == 0)
     {
         mem_get_buf(outstream, &outbuf, &outbuf_len);
 
-        M_WriteFile(filename, outbuf, outbuf_len);
+        result = MIDI_LoadMemory(outbuf, outbuf_len);
     }
 
     mem_fclose(instream);
@@ -1652,7 +2128,7 @@ static boolean ConvertMus(byte *musdata, int len, char *filename)
 static void *I_OPL_RegisterSong(void *data, int len)
 {
     midi_file_t *result;
-    char *filename;
+    midi_flat_song_t *song = NULL;
 
     if (!music_initialized)
     {
@@ -1662,35 +2138,36 @@ static void *I_OPL_RegisterSong(void *data, int len)
     // MUS files begin with "MUS"
     // Reject anything which doesnt have this signature
 
-    filename = M_TempFile("doom.mid");
-
     // [crispy] remove MID file size limit
     if (IsMid(data, len) /* && len < MAXMIDLENGTH */)
     {
-        M_WriteFile(filename, data, len);
+        result = MIDI_LoadMemory(data, len);
     }
     else
     {
         // Assume a MUS file and try to convert
 
-        ConvertMus(data, len, filename);
+        result = ConvertMus(data, len);
     }
 
-    result = MIDI_LoadFile(filename);
+    // [JN] Merge all tracks into a single stream of events now, so that
+    // playback doesn't need to walk the tracks or look at events it
+    // would ignore anyway.
 
-    if (result == NULL)
+    if (result != NULL)
+    {
+        song = MIDI_FlattenFile(result);
+        MIDI_FreeFile(result);
+    }
+
+    if (song == NULL)
     {
         printf(english_language ?
                         "I_OPL_RegisterSong: Failed to load MID.\n" :
                         "I_OPL_RegisterSong: Ошибка загрузки MID.\n");
     }
 
-    // remove file now
-
-    M_remove(filename);
-    free(filename);
-
-    return result;
+    return song;
 }
 
 // Is the song playing?
@@ -1702,7 +2179,7 @@ static boolean I_OPL_MusicIsPlaying(void)
         return false;
     }
 
-    return num_tracks > 0;
+    return playing_song != NULL;
 }
 
 // Shutdown music
@@ -1717,6 +2194,15 @@ static void I_OPL_ShutdownMusic(void)
 
         OPL_Shutdown();
 
+        if (render_mutex != NULL)
+        {
+            SDL_DestroyMutex(render_mutex);
+            render_mutex = NULL;
+        }
+
+        free(render_cache_dir);
+        render_cache_dir = NULL;
+
         // Release GENMIDI lump
 
         W_ReleaseLumpName(DEH_String("genmidi"));
@@ -1778,8 +2264,20 @@ static boolean I_OPL_InitMusic(void)
 
     InitVoices();
 
-    tracks = NULL;
-    num_tracks = 0;
+    // [JN] Offline rendering is only possible with software emulation.
+
+    if (opl_render && OPL_GetStreamRate() > 0)
+    {
+        render_mutex = SDL_CreateMutex();
+
+        if (opl_diskcachesize > 0)
+        {
+            render_cache_dir = M_GetMusicCacheDir();
+            M_MakeDirectory(render_cache_dir);
+        }
+    }
+
+    playing_song = NULL;
     music_initialized = true;
 
     return true;
@@ -1857,7 +2355,7 @@ void I_OPL_DevMessages(char *result, size_t result_len)
     int lines;
     int i;
 
-    if (num_tracks == 0)
+    if (playing_song == NULL)
     {
         M_snprintf(result, result_len, "No OPL track!");
         return;
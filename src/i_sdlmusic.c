@@ -59,6 +59,16 @@ static char *temp_timidity_cfg = NULL;
 // [JN] Temporal solution for proper volume control between MIDI/digital music.
 static boolean is_midi_file;
 
+// [JN] Registered song, returned as the song handle. SDL_mixer may keep
+// reading from the song data while playing, so the data is kept with its
+// music and freed together with it.
+
+typedef struct
+{
+    Mix_Music *music;
+    void *data;         // NULL if the music was loaded from a file
+} sdl_song_t;
+
 // If the temp_timidity_cfg config variable is set, generate a "wrapper"
 // config file for Timidity to point to the actual config file. This
 // is needed to inject a "dir" command so that the patches are read
@@ -369,7 +379,7 @@ static void I_SDL_PlaySong(void *handle, boolean looping)
     else
 #endif
     {
-        Mix_PlayMusic((Mix_Music *) handle, loops);
+        Mix_PlayMusic(((sdl_song_t *) handle)->music, loops);
     }
 }
 
@@ -436,7 +446,7 @@ static void I_SDL_StopSong(void)
 
 static void I_SDL_UnRegisterSong(void *handle)
 {
-    Mix_Music *music = (Mix_Music *) handle;
+    sdl_song_t *song = (sdl_song_t *) handle;
 
     if (!music_initialized)
     {
@@ -452,9 +462,11 @@ static void I_SDL_UnRegisterSong(void *handle)
     else
 #endif
     {
-        if (handle != NULL)
+        if (song != NULL)
         {
-            Mix_FreeMusic(music);
+            Mix_FreeMusic(song->music);
+            free(song->data);
+            free(song);
         }
     }
 }
@@ -472,24 +484,31 @@ static boolean IsMus(byte *mem, int len)
     return len > 4 && !memcmp(mem, "MUS\x1a", 4);
 }
 
-static boolean ConvertMus(byte *musdata, int len, const char *filename)
+// [JN] Convert MUS to MIDI in memory.
+// Returns a buffer to be freed with free(), or NULL if failed.
+
+static void *ConvertMus(byte *musdata, int len, size_t *midlen)
 {
     MEMFILE *instream;
     MEMFILE *outstream;
     void *outbuf;
     size_t outbuf_len;
-    int result;
+    void *result = NULL;
 
     instream = mem_fopen_read(musdata, len);
     outstream = mem_fopen_write();
 
-    result = mus2mid(instream, outstream);
-
-    if (result == 0)
+    if (mus2mid(instream, outstream) == 0)
     {
         mem_get_buf(outstream, &outbuf, &outbuf_len);
 
-        M_WriteFile(filename, outbuf, outbuf_len);
+        result = malloc(outbuf_len);
+
+        if (result != NULL)
+        {
+            memcpy(result, outbuf, outbuf_len);
+            *midlen = outbuf_len;
+        }
     }
 
     mem_fclose(instream);
@@ -502,6 +521,9 @@ static void *I_SDL_RegisterSong(void *data, int len)
 {
     char *filename;
     Mix_Music *music;
+    sdl_song_t *song;
+    void *songdata;
+    size_t songlen;
 
     if (!music_initialized)
     {
@@ -511,17 +533,23 @@ static void *I_SDL_RegisterSong(void *data, int len)
     // MUS files begin with "MUS"
     // Reject anything which doesnt have this signature
 
-    filename = M_TempFile("doom"); // [crispy] generic filename
-
     // [crispy] Reverse Choco's logic from "if (MIDI)" to "if (not MUS)"
     // MUS is the only format that requires conversion,
     // let SDL_Mixer figure out the others
 /*
     if (IsMid(data, len) && len < MAXMIDLENGTH)
 */
+    // [JN] Song data is kept in memory instead of a temporary file.
+    // A copy is made, as the lump may be released right after registering.
     if (!IsMus(data, len)) // [crispy] MUS_HEADER_MAGIC
     {
-        M_WriteFile(filename, data, len);
+        songdata = malloc(len);
+        songlen = len;
+
+        if (songdata != NULL)
+        {
+            memcpy(songdata, data, len);
+        }
         // [JN] Indicate it's not a MIDI file.
         is_midi_file = false;
     }
@@ -529,59 +557,88 @@ static void *I_SDL_RegisterSong(void *data, int len)
     {
 	// Assume a MUS file and try to convert
 
-        ConvertMus(data, len, filename);
+        songdata = ConvertMus(data, len, &songlen);
         // [JN] Indicate it is a MIDI file.
         is_midi_file = true;
     }
 
-    // Load the MIDI. In an ideal world we'd be using Mix_LoadMUS_RW()
-    // by now, but Mix_SetMusicCMD() only works with Mix_LoadMUS(), so
-    // we have to generate a temporary file.
+    if (songdata == NULL)
+    {
+        return NULL;
+    }
 
 #if defined(_WIN32)
     // If we do not have an external music command defined, play
     // music with the Windows native MIDI.
     if (win_midi_stream_opened && (IsMus(data, len) || IsMid(data, len)))
     {
-        if (I_WIN_RegisterSong(filename))
+        if (I_WIN_RegisterSong(songdata, songlen))
         {
-            music = (void *) 1;
+            song = (void *) 1;
 			win_midi_song_registered = true;
         }
         else
         {
-            music = NULL;
+            song = NULL;
             printf(english_language ?
                     "Error loading midi: Failed to register song.\n" :
                     "Ошибка загрузки при регистрации midi файла.\n");
         }
+
+        free(songdata);
     }
     else
 #endif
     {
-        music = Mix_LoadMUS(filename);
-        if (music == NULL)
+        if (strlen(snd_musiccmd) > 0)
         {
-            // Failed to load
-            printf(english_language ?
-                    "Error loading midi: \'%s\'.\n" :
-                    "Ошибка загрузки midi: \'%s\'.\n", SDL_GetError());
+            // Mix_SetMusicCMD() only works with Mix_LoadMUS(), so
+            // we have to generate a temporary file. We can't delete
+            // the file, otherwise the program won't find the file to
+            // play. This means we leave a mess on disk :(
+
+            filename = M_TempFile("doom"); // [crispy] generic filename
+            M_WriteFile(filename, songdata, songlen);
+            music = Mix_LoadMUS(filename);
+            free(filename);
+            free(songdata);
+            songdata = NULL;
         }
+        else
+        {
+            // SDL_mixer may keep reading from the buffer while playing,
+            // so it's freed when the song is unregistered.
 
-        // Remove the temporary MIDI file; however, when using an external
-        // MIDI program we can't delete the file. Otherwise, the program
-        // won't find the file to play. This means we leave a mess on
-        // disk :(
+            music = Mix_LoadMUS_RW(SDL_RWFromConstMem(songdata, songlen),
+                                   SDL_TRUE);
+        }
+
+        song = music != NULL ? malloc(sizeof(*song)) : NULL;
 
-        if (strlen(snd_musiccmd) == 0)
+        if (song != NULL)
+        {
+            song->music = music;
+            song->data = songdata;
+        }
+        else
         {
-            M_remove(filename);
+            if (music == NULL)
+            {
+                // Failed to load
+                printf(english_language ?
+                        "Error loading midi: \'%s\'.\n" :
+                        "Ошибка загрузки midi: \'%s\'.\n", SDL_GetError());
+            }
+            else
+            {
+                Mix_FreeMusic(music);
+            }
+
+            free(songdata);
         }
     }
 
-    free(filename);
-
-    return music;
+    return song;
 }
 
 // Is the song playing?
@@ -35,7 +35,10 @@
 #include "i_system.h"
 #include "i_swap.h"
 #include "m_argv.h"
+#include "m_config.h"
 #include "m_misc.h"
+#include "sha1.h"
+#include "w_file.h"
 #include "w_wad.h"
 #include "z_zone.h"
 #include "doomtype.h"
@@ -55,6 +58,7 @@ struct allocated_sound_s
     int use_count;
     int pitch;
     allocated_sound_t *prev, *next;
+    allocated_sound_t *hash_next;   // [JN] Next sound in the same hash bucket
 };
 
 static boolean sound_initialized = false;
@@ -65,11 +69,11 @@ static int mixer_freq;
 static Uint16 mixer_format;
 static int mixer_channels;
 static boolean use_sfx_prefix;
-static boolean (*ExpandSoundData)(sfxinfo_t *sfxinfo,
-                                  byte *data,
-                                  int samplerate,
-                                  int bits,
-                                  int length) = NULL;
+static allocated_sound_t *(*ExpandSoundData)(sfxinfo_t *sfxinfo,
+                                             const byte *data,
+                                             int samplerate,
+                                             int bits,
+                                             int length) = NULL;
 
 // Doubly-linked list of allocated sounds.
 // When a sound is played, it is moved to the head, so that the oldest
@@ -79,6 +83,22 @@ static allocated_sound_t *allocated_sounds_head = NULL;
 static allocated_sound_t *allocated_sounds_tail = NULL;
 static int allocated_sounds_size = 0;
 
+// [JN] Allocated sounds are also hashed by sfxinfo and pitch, so finding
+// one doesn't require walking the whole list.
+
+#define SOUND_HASH_SIZE 1024
+
+static allocated_sound_t *allocated_sounds_hash[SOUND_HASH_SIZE];
+
+// [JN] Pitch-shifted sounds are kept within snd_pitchcachesize.
+
+static int pitched_sounds_size = 0;
+static int pitched_sounds_peak = 0;
+static int pitched_sounds_count = 0;
+static unsigned int pitch_hits = 0;
+static unsigned int pitch_misses = 0;
+static unsigned int pitch_precached = 0;
+
 // [crispy] values 3 and higher might reproduce DOOM.EXE more accurately,
 // but 1 is closer to "use_libsamplerate = 0" which is the default in Choco
 // and causes only a short delay at startup
@@ -137,16 +157,41 @@ static void AllocatedSoundUnlink(allocated_sound_t *snd)
     }
 }
 
+static unsigned int SoundHash(sfxinfo_t *sfxinfo, int pitch)
+{
+    return (((uintptr_t) sfxinfo / sizeof(sfxinfo_t)) * 37 + pitch)
+         & (SOUND_HASH_SIZE - 1);
+}
+
 static void FreeAllocatedSound(allocated_sound_t *snd)
 {
+    allocated_sound_t **p;
+
     // Unlink from linked list.
 
     AllocatedSoundUnlink(snd);
 
+    // [JN] And from the hash table.
+
+    p = &allocated_sounds_hash[SoundHash(snd->sfxinfo, snd->pitch)];
+
+    while (*p != snd)
+    {
+        p = &(*p)->hash_next;
+    }
+
+    *p = snd->hash_next;
+
     // Keep track of the amount of allocated sound data:
 
     allocated_sounds_size -= snd->chunk.alen;
 
+    if (snd->pitch != NORM_PITCH)
+    {
+        pitched_sounds_size -= snd->chunk.alen;
+        pitched_sounds_count--;
+    }
+
     free(snd);
 }
 
@@ -176,6 +221,41 @@ static boolean FindAndFreeSound(void)
     return false;
 }
 
+// [JN] Same as FindAndFreeSound, but only pitch-shifted sounds are freed.
+
+static boolean FindAndFreePitchedSound(void)
+{
+    allocated_sound_t *snd;
+
+    snd = allocated_sounds_tail;
+
+    while (snd != NULL)
+    {
+        if (snd->use_count == 0 && snd->pitch != NORM_PITCH)
+        {
+            FreeAllocatedSound(snd);
+            return true;
+        }
+
+        snd = snd->prev;
+    }
+
+    return false;
+}
+
+// [JN] Enforce pitch-shifted sounds size limit.
+
+static void ReservePitchCacheSpace(size_t len)
+{
+    while (pitched_sounds_size + len > snd_pitchcachesize)
+    {
+        if (!FindAndFreePitchedSound())
+        {
+            break;
+        }
+    }
+}
+
 // Enforce SFX cache size limit.  We are just about to allocate "len"
 // bytes on the heap for a new sound effect, so free up some space
 // so that we keep allocated_sounds_size < snd_cachesize
@@ -201,32 +281,23 @@ static void ReserveCacheSpace(size_t len)
     }
 }
 
-// Allocate a block for a new sound effect.
+// Allocate a block for a new sound effect, without adding it to the list
+// of allocated sounds. [JN] Doesn't touch the list, so can be called from
+// the precaching thread.
 
-static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
+static allocated_sound_t *NewSound(sfxinfo_t *sfxinfo, size_t len)
 {
     allocated_sound_t *snd;
 
-    // Keep allocated sounds within the cache size.
-
-    ReserveCacheSpace(len);
-
     // Allocate the sound structure and data.  The data will immediately
     // follow the structure, which acts as a header.
 
-    do
-    {
-        snd = malloc(sizeof(allocated_sound_t) + len);
-
-        // Out of memory?  Try to free an old sound, then loop round
-        // and try again.
-
-        if (snd == NULL && !FindAndFreeSound())
-        {
-            return NULL;
-        }
+    snd = malloc(sizeof(allocated_sound_t) + len);
 
-    } while (snd == NULL);
+    if (snd == NULL)
+    {
+        return NULL;
+    }
 
     // Skip past the chunk structure for the audio buffer
 
@@ -239,12 +310,58 @@ static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
     snd->sfxinfo = sfxinfo;
     snd->use_count = 0;
 
+    return snd;
+}
+
+// Add a newly allocated sound to the list of allocated sounds.
+
+static void AddSound(allocated_sound_t *snd)
+{
+    const unsigned int hash = SoundHash(snd->sfxinfo, snd->pitch);
+
     // Keep track of how much memory all these cached sounds are using...
 
-    allocated_sounds_size += len;
+    allocated_sounds_size += snd->chunk.alen;
+
+    if (snd->pitch != NORM_PITCH)
+    {
+        pitched_sounds_size += snd->chunk.alen;
+        pitched_sounds_peak = MAX(pitched_sounds_peak, pitched_sounds_size);
+        pitched_sounds_count++;
+    }
 
     AllocatedSoundLink(snd);
 
+    snd->hash_next = allocated_sounds_hash[hash];
+    allocated_sounds_hash[hash] = snd;
+}
+
+// Allocate a block for a new sound effect.
+
+static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
+{
+    allocated_sound_t *snd;
+
+    // Keep allocated sounds within the cache size.
+
+    ReserveCacheSpace(len);
+
+    do
+    {
+        snd = NewSound(sfxinfo, len);
+
+        // Out of memory?  Try to free an old sound, then loop round
+        // and try again.
+
+        if (snd == NULL && !FindAndFreeSound())
+        {
+            return NULL;
+        }
+
+    } while (snd == NULL);
+
+    AddSound(snd);
+
     return snd;
 }
 
@@ -286,7 +403,7 @@ static void UnlockAllocatedSound(allocated_sound_t *snd)
 
 static allocated_sound_t * GetAllocatedSoundBySfxInfoAndPitch(sfxinfo_t *sfxinfo, int pitch)
 {
-    allocated_sound_t * p = allocated_sounds_head;
+    allocated_sound_t * p = allocated_sounds_hash[SoundHash(sfxinfo, pitch)];
 
     while (p != NULL)
     {
@@ -294,24 +411,17 @@ static allocated_sound_t * GetAllocatedSoundBySfxInfoAndPitch(sfxinfo_t *sfxinfo
         {
             return p;
         }
-        p = p->next;
+        p = p->hash_next;
     }
 
     return NULL;
 }
 
-// Allocate a new sound chunk and pitch-shift an existing sound up-or-down
-// into it.
+// [JN] Length of the pitch-shifted copy of a sound.
 
-static allocated_sound_t * PitchShift(allocated_sound_t *insnd, int pitch)
+static Uint32 PitchShiftLength(Uint32 srclen, int pitch)
 {
-    allocated_sound_t * outsnd;
-    Sint16 *inp, *outp;
-    Sint16 *srcbuf, *dstbuf;
-    Uint32 srclen, dstlen;
-
-    srcbuf = (Sint16 *)insnd->chunk.abuf;
-    srclen = insnd->chunk.alen;
+    Uint32 dstlen;
 
     // determine ratio pitch:NORM_PITCH and apply to srclen, then invert.
     // This is an approximation of vanilla behaviour based on measurements
@@ -323,7 +433,25 @@ static allocated_sound_t * PitchShift(allocated_sound_t *insnd, int pitch)
         dstlen++;
     }
 
-    outsnd = AllocateSound(insnd->sfxinfo, dstlen);
+    return dstlen;
+}
+
+// Allocate a new sound chunk and pitch-shift an existing sound up-or-down
+// into it. [JN] The new sound is not added to the list of allocated sounds,
+// so this can be called from the precaching thread.
+
+static allocated_sound_t * PitchShiftData(allocated_sound_t *insnd, int pitch)
+{
+    allocated_sound_t * outsnd;
+    Sint16 *inp, *outp;
+    Sint16 *srcbuf, *dstbuf;
+    Uint32 srclen, dstlen;
+
+    srcbuf = (Sint16 *)insnd->chunk.abuf;
+    srclen = insnd->chunk.alen;
+    dstlen = PitchShiftLength(srclen, pitch);
+
+    outsnd = NewSound(insnd->sfxinfo, dstlen);
 
     if (!outsnd)
     {
@@ -343,6 +471,56 @@ static allocated_sound_t * PitchShift(allocated_sound_t *insnd, int pitch)
     return outsnd;
 }
 
+// [JN] Pitch-shift an existing sound and add the copy to allocated sounds.
+
+static allocated_sound_t * PitchShift(allocated_sound_t *insnd, int pitch)
+{
+    allocated_sound_t * outsnd;
+    const Uint32 dstlen = PitchShiftLength(insnd->chunk.alen, pitch);
+
+    // Make room among the other pitch-shifted sounds first, then keep
+    // all of the allocated sounds within the cache size.
+
+    ReservePitchCacheSpace(dstlen);
+    ReserveCacheSpace(dstlen);
+
+    do
+    {
+        outsnd = PitchShiftData(insnd, pitch);
+
+        // Out of memory?  Try to free an old sound, then loop round
+        // and try again.
+
+        if (outsnd == NULL && !FindAndFreeSound())
+        {
+            return NULL;
+        }
+
+    } while (outsnd == NULL);
+
+    AddSound(outsnd);
+
+    return outsnd;
+}
+
+// [JN] Round the pitch to multiples of snd_pitchstep, away from normal
+// pitch in halfway cases.
+
+static int QuantizePitch(int pitch)
+{
+    int offset;
+
+    if (snd_pitchstep <= 1)
+    {
+        return pitch;
+    }
+
+    offset = abs(pitch - NORM_PITCH);
+    offset = (offset + snd_pitchstep / 2) / snd_pitchstep * snd_pitchstep;
+
+    return pitch < NORM_PITCH ? NORM_PITCH - offset : NORM_PITCH + offset;
+}
+
 // When a sound stops, check if it is still playing.  If it is not,
 // we can mark the sound data as CACHE to be freed back for other
 // means.
@@ -363,8 +541,9 @@ static void ReleaseSoundOnChannel(int channel)
     UnlockAllocatedSound(snd);
 
     // if the sound is a pitch-shift and it's not in use, immediately
-    // free it
-    if (snd->pitch != NORM_PITCH && snd->use_count <= 0)
+    // free it. [JN] Unless it fits into pitch-shifted sounds cache.
+    if (snd->pitch != NORM_PITCH && snd->use_count <= 0
+    &&  pitched_sounds_size > snd_pitchcachesize)
     {
         FreeAllocatedSound(snd);
     }
@@ -403,17 +582,17 @@ static int SRC_ConversionMode(void)
 //   unsigned 8 bits --> signed 16 bits
 //   mono --> stereo
 //   samplerate --> mixer_freq
-// Returns number of clipped samples.
+// Returns the new sound, not yet added to the list of allocated sounds.
 // DWF 2008-02-10 with cleanups by Simon Howard.
-static int retn;
 
-static boolean ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
-                                   byte *data,
-                                   int samplerate,
-                                   int bits,
-                                   int length)
+static allocated_sound_t *ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
+                                              const byte *data,
+                                              int samplerate,
+                                              int bits,
+                                              int length)
 {
     SRC_DATA src_data;
+    int retn;
     float *data_in;
     uint32_t i, abuf_index=0, clipped=0;
 //    uint32_t alen;
@@ -463,11 +642,13 @@ static boolean ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
 
 //    alen = src_data.output_frames_gen * 4;
 
-    snd = AllocateSound(sfxinfo, src_data.output_frames_gen * 4);
+    snd = NewSound(sfxinfo, src_data.output_frames_gen * 4);
 
     if (snd == NULL)
     {
-        return false;
+        free(data_in);
+        free(src_data.data_out);
+        return NULL;
     }
 
     chunk = &snd->chunk;
@@ -532,7 +713,7 @@ static boolean ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
                         400.0 * clipped / chunk->alen);
     }
 
-    return true;
+    return snd;
 }
 
 #endif
@@ -617,13 +798,13 @@ static void WriteWAV(char *filename, byte *data,
 #endif
 
 // Generic sound expansion function for any sample rate.
-// Returns number of clipped samples (always 0).
+// Returns the new sound, not yet added to the list of allocated sounds.
 
-static boolean ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
-                                   byte *data,
-                                   int samplerate,
-                                   int bits,
-                                   int length)
+static allocated_sound_t *ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
+                                              const byte *data,
+                                              int samplerate,
+                                              int bits,
+                                              int length)
 {
     SDL_AudioCVT convertor;
     allocated_sound_t *snd;
@@ -641,11 +822,11 @@ static boolean ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
 
     // Allocate a chunk in which to expand the sound
 
-    snd = AllocateSound(sfxinfo, expanded_length);
+    snd = NewSound(sfxinfo, expanded_length);
 
     if (snd == NULL)
     {
-        return false;
+        return NULL;
     }
 
     chunk = &snd->chunk;
@@ -740,27 +921,17 @@ static boolean ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
 #endif /* #ifdef LOW_PASS_FILTER */
     }
 
-    return true;
+    return snd;
 }
 
-// Load and convert a sound effect
-// Returns true if successful
+// Find the sample data in a sound lump.
+// Returns true if this is a valid sound.
 
-static boolean CacheSFX(sfxinfo_t *sfxinfo)
+static boolean ParseSFX(const byte *data, unsigned int lumplen,
+                        const byte **samples,
+                        int *samplerate, unsigned int *bits,
+                        unsigned int *length)
 {
-    int lumpnum;
-    unsigned int lumplen;
-    int samplerate;
-    unsigned int bits;
-    unsigned int length;
-    byte *data;
-
-    // need to load the sound
-
-    lumpnum = sfxinfo->lumpnum;
-    data = W_CacheLumpNum(lumpnum, PU_STATIC);
-    lumplen = W_LumpLength(lumpnum);
-
     // [crispy] Check if this is a valid RIFF wav file
     if (lumplen > 44 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WAVEfmt ", 8) == 0)
     {
@@ -784,16 +955,16 @@ static boolean CacheSFX(sfxinfo_t *sfxinfo)
         if (check != 1)
             return false;
 
-        samplerate = data[24] | (data[25] << 8) | (data[26] << 16) | (data[27] << 24);
-        length = data[40] | (data[41] << 8) | (data[42] << 16) | (data[43] << 24);
+        *samplerate = data[24] | (data[25] << 8) | (data[26] << 16) | (data[27] << 24);
+        *length = data[40] | (data[41] << 8) | (data[42] << 16) | (data[43] << 24);
 
-        if (length > lumplen - 44)
-            length = lumplen - 44;
+        if (*length > lumplen - 44)
+            *length = lumplen - 44;
 
-        bits = data[34] | (data[35] << 8);
+        *bits = data[34] | (data[35] << 8);
 
         // Reject non 8 or 16 bit
-        if (bits != 16 && bits != 8)
+        if (*bits != 16 && *bits != 8)
             return false;
 
         data += 44 - 8;
@@ -804,8 +975,8 @@ static boolean CacheSFX(sfxinfo_t *sfxinfo)
         // Valid DOOM sound
 
         // 16 bit sample rate field, 32 bit length field
-        samplerate = (data[3] << 8) | data[2];
-        length = (data[7] << 24) | (data[6] << 16) | (data[5] << 8) | data[4];
+        *samplerate = (data[3] << 8) | data[2];
+        *length = (data[7] << 24) | (data[6] << 16) | (data[5] << 8) | data[4];
 
         // If the header specifies that the length of the sound is greater than
         // the length of the lump itself, this is an invalid sound lump
@@ -816,19 +987,19 @@ static boolean CacheSFX(sfxinfo_t *sfxinfo)
         // further investigation to better understand the correct
         // behavior.
 
-        if (length > lumplen - 8 || length <= 48)
+        if (*length > lumplen - 8 || *length <= 48)
         {
             return false;
         }
 
         // All Doom sounds are 8-bit
-        bits = 8;
+        *bits = 8;
 
         // The DMX sound library seems to skip the first 16 and last 16
         // bytes of the lump - reason unknown.
 
         data += 16;
-        length -= 32;
+        *length -= 32;
     }
     else
     {
@@ -836,95 +1007,996 @@ static boolean CacheSFX(sfxinfo_t *sfxinfo)
         return false;
     }
 
+    *samples = data + 8;
+
+    return true;
+}
+
+// Load and convert a sound effect
+// Returns true if successful
+
+static boolean CacheSFX(sfxinfo_t *sfxinfo)
+{
+    int lumpnum;
+    int samplerate;
+    unsigned int bits;
+    unsigned int length;
+    const byte *data;
+    allocated_sound_t *snd;
+
+    // need to load the sound
+
+    lumpnum = sfxinfo->lumpnum;
+    data = W_CacheLumpNumRO(lumpnum, PU_STATIC);
+
+    if (!ParseSFX(data, W_LumpLength(lumpnum), &data,
+                  &samplerate, &bits, &length))
+    {
+        return false;
+    }
+
     // Sample rate conversion
 
-    if (!ExpandSoundData(sfxinfo, data + 8, samplerate, bits, length))
+    snd = ExpandSoundData(sfxinfo, data, samplerate, bits, length);
+
+    if (snd == NULL)
     {
         return false;
     }
 
+    ReserveCacheSpace(snd->chunk.alen);
+    AddSound(snd);
+
 #ifdef DEBUG_DUMP_WAVS
     {
         char filename[16];
-        allocated_sound_t * snd;
 
         M_snprintf(filename, sizeof(filename), "%s.wav",
                    DEH_String(sfxinfo->name));
-        snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH);
         WriteWAV(filename, snd->chunk.abuf, snd->chunk.alen,mixer_freq);
     }
 #endif
 
     // don't need the original lump any more
   
-    W_ReleaseLumpNum(lumpnum);
+    W_ReleaseLumpNumRO(lumpnum);
 
     return true;
 }
 
-static void GetSfxLumpName(sfxinfo_t *sfx, char *buf, size_t buf_len)
+// -----------------------------------------------------------------------------
+// [JN] Disk cache of converted sounds.
+//
+// Converted sounds are kept in files named after SHA-1 of the sound lump,
+// output sample rate and conversion mode, so following launches only have
+// to map them into memory instead of resampling. Every launch is a new
+// generation, and the generation each file was last used in is kept in
+// the index file. When the cache grows over snd_diskcachesize, files
+// which were not used for the longest time are removed.
+// -----------------------------------------------------------------------------
+
+#define DISKCACHE_MAGIC    "RDSFX1"
+#define DISKCACHE_INDEX    "index.txt"
+#define DISKCACHE_NAME_LEN 64
+
+typedef struct
 {
-    // Linked sfx lumps? Get the lump number for the sound linked to.
-
-    if (sfx->link != NULL)
+    char magic[8];
+    int32_t samplerate;
+    int32_t mode;
+    float scale;
+    uint32_t length;    // Length of PCM data following the header
+} diskcache_header_t;
+
+typedef struct
+{
+    char name[DISKCACHE_NAME_LEN];
+    unsigned int size;          // Size of the file, including header
+    unsigned int generation;    // Launch the file was last used in
+} diskcache_entry_t;
+
+static char *diskcache_dir;
+static diskcache_entry_t *diskcache;
+static int diskcache_count;
+static int diskcache_sorted;    // Entries loaded from the index, by name
+static int diskcache_alloced;
+static unsigned int diskcache_generation;
+static int diskcache_hits;
+static int diskcache_stores;
+
+// Conversion mode, as a part of the cache key.
+
+static int DiskCacheMode(void)
+{
+#ifdef HAVE_LIBSAMPLERATE
+    if (ExpandSoundData == ExpandSoundData_SRC)
     {
-        sfx = sfx->link;
+        return SRC_ConversionMode();
     }
+#endif
 
-    // Doom adds a DS* prefix to sound lumps; Heretic and Hexen don't
-    // do this.
+    return -1;
+}
 
-    if (use_sfx_prefix)
-    {
-        M_snprintf(buf, buf_len, "ds%s", DEH_String(sfx->name));
-    }
-    else
+// Header every cache file made with current settings starts with.
+
+static void DiskCacheHeader(diskcache_header_t *header, uint32_t length)
+{
+    memset(header, 0, sizeof(*header));
+    M_StringCopy(header->magic, DISKCACHE_MAGIC, sizeof(header->magic));
+    header->samplerate = mixer_freq;
+    header->mode = DiskCacheMode();
+    header->scale = libsamplerate_scale;
+    header->length = length;
+}
+
+static int DiskCacheCompareNames(const void *a, const void *b)
+{
+    return strcmp(((const diskcache_entry_t *) a)->name,
+                  ((const diskcache_entry_t *) b)->name);
+}
+
+// Most recently used first, so the tail of the list is evicted.
+
+static int DiskCacheCompareGenerations(const void *a, const void *b)
+{
+    const diskcache_entry_t *ea = a, *eb = b;
+
+    if (ea->generation != eb->generation)
     {
-        M_StringCopy(buf, DEH_String(sfx->name), buf_len);
+        return ea->generation > eb->generation ? -1 : 1;
     }
+
+    return 0;
 }
 
-// Preload all the sound effects - stops nasty ingame freezes
+// Entries loaded from the index are searched by name, the few added
+// during this launch follow them unsorted.
 
-static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
+static diskcache_entry_t *DiskCacheFind(const char *name)
 {
-    char namebuf[9];
+    diskcache_entry_t key;
+    diskcache_entry_t *entry = NULL;
     int i;
-    static boolean sounds_pracached = false;  // [JN] Precache sounds only once.
 
-    if (sounds_pracached)
+    M_StringCopy(key.name, name, sizeof(key.name));
+
+    if (diskcache_sorted > 0)
     {
-        return;
+        entry = bsearch(&key, diskcache, diskcache_sorted, sizeof(*diskcache),
+                        DiskCacheCompareNames);
     }
 
-    printf(english_language ?
-           "I_SDL_PrecacheSounds: Precaching all sound effects - " :
-           "I_SDL_PrecacheSounds: Кэширование звуковых эффектов - ");
-
-    printf("[");
-    for (i=0; i<num_sounds; ++i)
+    for (i = diskcache_sorted ; entry == NULL && i < diskcache_count ; ++i)
     {
-        
-        if ((i % 6) == 0)
+        if (!strcmp(diskcache[i].name, key.name))
         {
-            printf(".");
-            fflush(stdout);
+            entry = &diskcache[i];
         }
+    }
 
-        GetSfxLumpName(&sounds[i], namebuf, sizeof(namebuf));
+    return entry;
+}
 
-        sounds[i].lumpnum = W_CheckNumForName(namebuf);
+static diskcache_entry_t *DiskCacheNewEntry(const char *name)
+{
+    diskcache_entry_t *entry;
 
-        if (sounds[i].lumpnum != -1)
-        {
+    if (diskcache_count == diskcache_alloced)
+    {
+        diskcache_alloced = diskcache_alloced ? diskcache_alloced * 2 : 256;
+        diskcache = I_Realloc(diskcache,
+                              diskcache_alloced * sizeof(*diskcache));
+    }
+
+    entry = &diskcache[diskcache_count++];
+    M_StringCopy(entry->name, name, sizeof(entry->name));
+
+    return entry;
+}
+
+// Returns false if the file was in the cache already.
+
+static boolean DiskCacheAdd(const char *name, unsigned int size)
+{
+    diskcache_entry_t *entry = DiskCacheFind(name);
+    const boolean added = entry == NULL;
+
+    if (entry == NULL)
+    {
+        entry = DiskCacheNewEntry(name);
+    }
+
+    entry->size = size;
+    entry->generation = diskcache_generation;
+
+    return added;
+}
+
+static void DiskCacheInit(void)
+{
+    char *path;
+    FILE *index;
+    char name[DISKCACHE_NAME_LEN];
+    unsigned int size, generation;
+    int i, kept;
+
+    if (snd_diskcachesize <= 0)
+    {
+        return;
+    }
+
+    diskcache_dir = M_GetSfxCacheDir();
+    M_MakeDirectory(diskcache_dir);
+
+    path = M_StringJoin(diskcache_dir, DIR_SEPARATOR_S, DISKCACHE_INDEX, NULL);
+    index = M_fopen(path, "r");
+    free(path);
+
+    if (index != NULL)
+    {
+        if (fscanf(index, "generation %u", &diskcache_generation) != 1)
+        {
+            diskcache_generation = 0;
+        }
+
+        while (fscanf(index, "%63s %u %u", name, &size, &generation) == 3)
+        {
+            diskcache_entry_t *entry = DiskCacheNewEntry(name);
+
+            entry->size = size;
+            entry->generation = generation;
+        }
+
+        fclose(index);
+    }
+
+    diskcache_generation++;
+
+    qsort(diskcache, diskcache_count, sizeof(*diskcache),
+          DiskCacheCompareNames);
+
+    // Drop duplicate lines, which older versions could write.
+    for (i = 0, kept = 0 ; i < diskcache_count ; ++i)
+    {
+        if (kept > 0 && !strcmp(diskcache[kept - 1].name, diskcache[i].name))
+        {
+            diskcache[kept - 1].generation = MAX(diskcache[kept - 1].generation,
+                                                 diskcache[i].generation);
+            continue;
+        }
+
+        diskcache[kept++] = diskcache[i];
+    }
+
+    diskcache_count = diskcache_sorted = kept;
+}
+
+// Cache file name for the sound lump.
+
+static void DiskCacheName(const byte *lump, unsigned int lumplen,
+                          char *name, size_t name_len)
+{
+    sha1_context_t context;
+    sha1_digest_t digest;
+    char hex[sizeof(digest) * 2 + 1];
+    int mode = DiskCacheMode();
+    int i;
+
+    SHA1_Init(&context);
+    SHA1_Update(&context, (byte *) lump, lumplen);
+    SHA1_Final(digest, &context);
+
+    for (i = 0 ; i < sizeof(digest) ; ++i)
+    {
+        M_snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    }
+
+    if (mode < 0)
+    {
+        M_snprintf(name, name_len, "%s-%d-sdl.pcm", hex, mixer_freq);
+    }
+    else
+    {
+        M_snprintf(name, name_len, "%s-%d-src%d.pcm", hex, mixer_freq, mode);
+    }
+}
+
+// Loads a converted sound from the disk cache.
+
+static allocated_sound_t *DiskCacheLoad(sfxinfo_t *sfxinfo, const char *name)
+{
+    diskcache_entry_t *entry;
+    diskcache_header_t header, expected;
+    wad_file_t *file;
+    allocated_sound_t *snd = NULL;
+    char *path;
+
+    entry = DiskCacheFind(name);
+
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+
+    path = M_StringJoin(diskcache_dir, DIR_SEPARATOR_S, name, NULL);
+    file = W_OpenFileMapped(path);
+    free(path);
+
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    if (file->length >= sizeof(header))
+    {
+        if (file->mapped != NULL)
+        {
+            memcpy(&header, file->mapped, sizeof(header));
+        }
+        else
+        {
+            W_Read(file, 0, &header, sizeof(header));
+        }
+
+        DiskCacheHeader(&expected, file->length - sizeof(header));
+
+        if (memcmp(&header, &expected, sizeof(header)) == 0)
+        {
+            snd = NewSound(sfxinfo, header.length);
+        }
+    }
+
+    if (snd != NULL)
+    {
+        if (file->mapped != NULL)
+        {
+            memcpy(snd->chunk.abuf, file->mapped + sizeof(header),
+                   header.length);
+        }
+        else if (W_Read(file, sizeof(header), snd->chunk.abuf,
+                        header.length) != header.length)
+        {
+            free(snd);
+            snd = NULL;
+        }
+    }
+
+    W_CloseFile(file);
+
+    if (snd != NULL)
+    {
+        entry->generation = diskcache_generation;
+        diskcache_hits++;
+    }
+
+    return snd;
+}
+
+// Saves a converted sound into the disk cache. Doesn't touch the cache
+// index, so can be called from the precaching thread. Identical lumps
+// have the same file name and may be stored by both threads at once,
+// so every store writes its own temporary file.
+// Returns size of the file, or 0 if failed.
+
+static unsigned int DiskCacheStore(const char *name, allocated_sound_t *snd)
+{
+    static SDL_atomic_t store_count;
+    diskcache_header_t header;
+    char *path, *temp_path;
+    char suffix[16];
+    FILE *file;
+    boolean result;
+
+    M_snprintf(suffix, sizeof(suffix), ".%d.tmp",
+               SDL_AtomicAdd(&store_count, 1));
+    path = M_StringJoin(diskcache_dir, DIR_SEPARATOR_S, name, NULL);
+    temp_path = M_StringJoin(path, suffix, NULL);
+    file = M_fopen(temp_path, "wb");
+
+    if (file == NULL)
+    {
+        free(temp_path);
+        free(path);
+        return 0;
+    }
+
+    DiskCacheHeader(&header, snd->chunk.alen);
+
+    result = fwrite(&header, sizeof(header), 1, file) == 1
+          && fwrite(snd->chunk.abuf, 1, snd->chunk.alen, file) == snd->chunk.alen;
+    result = fclose(file) == 0 && result;
+
+    if (result)
+    {
+#ifdef _WIN32
+        // Rename doesn't overwrite existing files on Windows.
+        M_remove(path);
+#endif
+        result = M_rename(temp_path, path) == 0;
+    }
+    else
+    {
+        M_remove(temp_path);
+    }
+
+    free(temp_path);
+    free(path);
+
+    return result ? sizeof(header) + snd->chunk.alen : 0;
+}
+
+// Evicts files beyond the size limit and saves the index.
+// Called once all sounds are converted.
+
+static void DiskCacheShutdown(void)
+{
+    char *path, *temp_path;
+    FILE *index;
+    size_t total = 0;
+    int i, kept = 0;
+
+    if (diskcache_dir == NULL)
+    {
+        return;
+    }
+
+    qsort(diskcache, diskcache_count, sizeof(*diskcache),
+          DiskCacheCompareGenerations);
+
+    for (i = 0 ; i < diskcache_count ; ++i)
+    {
+        if (total + diskcache[i].size > snd_diskcachesize)
+        {
+            path = M_StringJoin(diskcache_dir, DIR_SEPARATOR_S,
+                                diskcache[i].name, NULL);
+            M_remove(path);
+            free(path);
+            continue;
+        }
+
+        total += diskcache[i].size;
+        diskcache[kept++] = diskcache[i];
+    }
+
+    path = M_StringJoin(diskcache_dir, DIR_SEPARATOR_S, DISKCACHE_INDEX, NULL);
+    temp_path = M_StringJoin(path, ".tmp", NULL);
+    index = M_fopen(temp_path, "w");
+
+    if (index != NULL)
+    {
+        fprintf(index, "generation %u\n", diskcache_generation);
+
+        for (i = 0 ; i < kept ; ++i)
+        {
+            fprintf(index, "%s %u %u\n", diskcache[i].name,
+                    diskcache[i].size, diskcache[i].generation);
+        }
+
+        if (fclose(index) == 0)
+        {
+#ifdef _WIN32
+            M_remove(path);
+#endif
+            M_rename(temp_path, path);
+        }
+        else
+        {
+            M_remove(temp_path);
+        }
+    }
+
+    printf(english_language ?
+           "I_SDL_PrecacheSounds: %d sounds loaded from disk cache, %d converted (%.1f MiB on disk).\n" :
+           "I_SDL_PrecacheSounds: %d звуков загружено из дискового кэша, %d преобразовано (%.1f МиБ на диске).\n",
+           diskcache_hits, diskcache_stores, total / (1024.0 * 1024.0));
+
+    free(temp_path);
+    free(path);
+    free(diskcache);
+    free(diskcache_dir);
+    diskcache = NULL;
+    diskcache_dir = NULL;
+    diskcache_count = diskcache_sorted = diskcache_alloced = 0;
+}
+
+// -----------------------------------------------------------------------------
+// [JN] Background precaching.
+//
+// Sound lumps are loaded and parsed on the main thread, as the WAD and
+// zone code is not thread safe, and their samples are copied out, so the
+// lumps can be released right away. Resampling is done by a worker
+// thread into plain malloc'ed sounds. Finished sounds are picked up by
+// the main thread on every sound update and added to the list of
+// allocated sounds. A sound that is played before the worker got to it
+// is converted right away on the main thread instead.
+// -----------------------------------------------------------------------------
+
+// Number of pitch-shifted copies to make in background, nearest
+// to the normal pitch: one and two steps of snd_pitchstep up and down.
+
+#define PITCH_PRECACHE_VARIANTS 4
+
+typedef enum
+{
+    SFXJOB_QUEUED,      // Waiting for the worker
+    SFXJOB_CONVERTING,  // Being resampled, by the worker or the main thread
+    SFXJOB_READY,       // Resampled, to be added to the allocated sounds
+    SFXJOB_DONE,        // Picked up by the main thread
+} sfxjobstate_t;
+
+typedef struct
+{
+    sfxinfo_t *sfxinfo;
+    byte *data;             // Copy of samples from the lump
+    int samplerate;
+    unsigned int bits;
+    unsigned int length;
+    allocated_sound_t *snd; // Result of conversion, NULL if failed
+    sfxjobstate_t state;
+    char cachename[DISKCACHE_NAME_LEN]; // Empty if disk cache is not used
+    unsigned int cachesize; // Size of the cache file written, 0 if none
+    allocated_sound_t *variants[PITCH_PRECACHE_VARIANTS];
+    int num_variants;       // Pitch-shifted copies made in background
+} sfxjob_t;
+
+static sfxjob_t *sfx_jobs;
+static int num_sfx_jobs;
+static int next_sfx_job;      // Next job for the worker
+static int next_sfx_collect;  // Next job for the main thread to pick up
+
+static SDL_Thread *precache_thread;
+static SDL_mutex *precache_mutex;
+static SDL_cond *precache_cond;
+static boolean precache_quit;
+static int precache_pitch_budget;   // Bytes left for pitch-shifted copies
+
+// Makes pitch-shifted copies of the converted sound while the budget
+// lasts. Sounds are precached in the order of the sfx table, which has
+// weapon sounds first in all of the games, so these get the copies.
+
+static void PrecachePitches(sfxjob_t *job)
+{
+    const int step = MAX(snd_pitchstep, 1);
+    boolean fits;
+    Uint32 length;
+    int pitch;
+    int i;
+
+    for (i = 0 ; i < PITCH_PRECACHE_VARIANTS ; ++i)
+    {
+        // Up one step, down one step, up two steps...
+        pitch = NORM_PITCH + (i / 2 + 1) * step * (i % 2 ? -1 : 1);
+
+        if (pitch <= 0 || pitch >= NORM_PITCH * 2)
+        {
+            continue;
+        }
+
+        length = PitchShiftLength(job->snd->chunk.alen, pitch);
+
+        SDL_LockMutex(precache_mutex);
+        fits = precache_pitch_budget >= (int) length;
+        if (fits)
+        {
+            precache_pitch_budget -= length;
+        }
+        SDL_UnlockMutex(precache_mutex);
+
+        if (!fits)
+        {
+            return;
+        }
+
+        job->variants[job->num_variants] = PitchShiftData(job->snd, pitch);
+
+        if (job->variants[job->num_variants] == NULL)
+        {
+            return;
+        }
+
+        job->num_variants++;
+    }
+}
+
+// Converts the sound and saves it to the disk cache, unless it was
+// loaded from there already. Called without precache_mutex locked.
+
+static void ConvertSfxJob(sfxjob_t *job, boolean precache_pitches)
+{
+    if (job->snd == NULL)
+    {
+        job->snd = ExpandSoundData(job->sfxinfo, job->data,
+                                   job->samplerate, job->bits, job->length);
+
+        if (job->snd != NULL && job->cachename[0] != '\0')
+        {
+            job->cachesize = DiskCacheStore(job->cachename, job->snd);
+        }
+    }
+
+    if (job->snd != NULL && precache_pitches)
+    {
+        PrecachePitches(job);
+    }
+}
+
+static int PrecacheThread(void *unused)
+{
+    sfxjob_t *job;
+
+    SDL_LockMutex(precache_mutex);
+
+    while (next_sfx_job < num_sfx_jobs && !precache_quit)
+    {
+        job = &sfx_jobs[next_sfx_job++];
+
+        // Already taken by the main thread?
+        if (job->state != SFXJOB_QUEUED)
+        {
+            continue;
+        }
+
+        job->state = SFXJOB_CONVERTING;
+
+        SDL_UnlockMutex(precache_mutex);
+        ConvertSfxJob(job, true);
+        SDL_LockMutex(precache_mutex);
+
+        job->state = SFXJOB_READY;
+        SDL_CondBroadcast(precache_cond);
+    }
+
+    SDL_UnlockMutex(precache_mutex);
+
+    return 0;
+}
+
+// Adds the converted sound to the allocated sounds.
+// Must be called with precache_mutex locked while the worker is running.
+
+static void FinishSfxJob(sfxjob_t *job)
+{
+    allocated_sound_t *variant;
+    int i;
+
+    if (job->state == SFXJOB_DONE)
+    {
+        return;
+    }
+
+    if (job->snd != NULL)
+    {
+        ReserveCacheSpace(job->snd->chunk.alen);
+        AddSound(job->snd);
+    }
+
+    for (i = 0 ; i < job->num_variants ; ++i)
+    {
+        variant = job->variants[i];
+
+        // Already made while the sound was played?
+        if (GetAllocatedSoundBySfxInfoAndPitch(variant->sfxinfo,
+                                               variant->pitch) != NULL)
+        {
+            free(variant);
+            continue;
+        }
+
+        ReservePitchCacheSpace(variant->chunk.alen);
+        ReserveCacheSpace(variant->chunk.alen);
+        AddSound(variant);
+        pitch_precached++;
+    }
+
+    if (job->cachesize != 0 && DiskCacheAdd(job->cachename, job->cachesize))
+    {
+        diskcache_stores++;
+    }
+
+    free(job->data);
+
+    job->sfxinfo->driver_data = NULL;
+    job->data = NULL;
+    job->snd = NULL;
+    job->state = SFXJOB_DONE;
+}
+
+static void FreeSfxJobs(void)
+{
+    // All sounds are converted now, so the disk cache can be trimmed.
+
+    DiskCacheShutdown();
+
+    if (precache_thread != NULL)
+    {
+        SDL_WaitThread(precache_thread, NULL);
+        precache_thread = NULL;
+    }
+
+    if (precache_cond != NULL)
+    {
+        SDL_DestroyCond(precache_cond);
+        precache_cond = NULL;
+    }
+
+    if (precache_mutex != NULL)
+    {
+        SDL_DestroyMutex(precache_mutex);
+        precache_mutex = NULL;
+    }
+
+    free(sfx_jobs);
+    sfx_jobs = NULL;
+    num_sfx_jobs = 0;
+    next_sfx_job = 0;
+    next_sfx_collect = 0;
+}
+
+// Picks up sounds finished by the worker. Called on every sound update.
+
+static void CollectPrecachedSounds(void)
+{
+    sfxjob_t *job;
+
+    if (sfx_jobs == NULL)
+    {
+        return;
+    }
+
+    SDL_LockMutex(precache_mutex);
+
+    while (next_sfx_collect < num_sfx_jobs)
+    {
+        job = &sfx_jobs[next_sfx_collect];
+
+        if (job->state == SFXJOB_QUEUED || job->state == SFXJOB_CONVERTING)
+        {
+            break;
+        }
+
+        FinishSfxJob(job);
+        next_sfx_collect++;
+    }
+
+    SDL_UnlockMutex(precache_mutex);
+
+    if (next_sfx_collect == num_sfx_jobs)
+    {
+        FreeSfxJobs();
+    }
+}
+
+// Makes sure the sound being precached is in the allocated sounds now,
+// either by waiting for the worker or by converting it right away.
+
+static void TakePrecachedSound(sfxinfo_t *sfxinfo)
+{
+    sfxjob_t *job = sfxinfo->driver_data;
+
+    if (job == NULL)
+    {
+        return;
+    }
+
+    SDL_LockMutex(precache_mutex);
+
+    if (job->state == SFXJOB_QUEUED)
+    {
+        // Worker has not got to it yet, so the worker will skip it.
+        job->state = SFXJOB_CONVERTING;
+
+        // Pitch-shifted copies are not made here, this would only make
+        // the delay longer.
+        SDL_UnlockMutex(precache_mutex);
+        ConvertSfxJob(job, false);
+        SDL_LockMutex(precache_mutex);
+
+        job->state = SFXJOB_READY;
+    }
+
+    // Being converted by the worker, it will be faster to wait for it.
+    while (job->state == SFXJOB_CONVERTING)
+    {
+        SDL_CondWait(precache_cond, precache_mutex);
+    }
+
+    FinishSfxJob(job);
+
+    SDL_UnlockMutex(precache_mutex);
+}
+
+// Stops the worker. Sounds it has not converted yet will be converted
+// on demand.
+
+static void StopPrecaching(void)
+{
+    int i;
+
+    if (sfx_jobs == NULL)
+    {
+        return;
+    }
+
+    if (precache_thread != NULL)
+    {
+        SDL_LockMutex(precache_mutex);
+        precache_quit = true;
+        SDL_UnlockMutex(precache_mutex);
+
+        SDL_WaitThread(precache_thread, NULL);
+        precache_thread = NULL;
+    }
+
+    for (i = next_sfx_collect ; i < num_sfx_jobs ; ++i)
+    {
+        // Not converted jobs are just dropped.
+        FinishSfxJob(&sfx_jobs[i]);
+    }
+
+    FreeSfxJobs();
+}
+
+static void GetSfxLumpName(sfxinfo_t *sfx, char *buf, size_t buf_len)
+{
+    // Linked sfx lumps? Get the lump number for the sound linked to.
+
+    if (sfx->link != NULL)
+    {
+        sfx = sfx->link;
+    }
+
+    // Doom adds a DS* prefix to sound lumps; Heretic and Hexen don't
+    // do this.
+
+    if (use_sfx_prefix)
+    {
+        M_snprintf(buf, buf_len, "ds%s", DEH_String(sfx->name));
+    }
+    else
+    {
+        M_StringCopy(buf, DEH_String(sfx->name), buf_len);
+    }
+}
+
+// Preload all the sound effects - stops nasty ingame freezes
+// [JN] Lumps are loaded right here, resampling is done in background.
+
+static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
+{
+    char namebuf[9];
+    int i;
+    const byte *lump, *data;
+    unsigned int lumplen;
+    sfxjob_t *job;
+    static boolean sounds_pracached = false;  // [JN] Precache sounds only once.
+
+    if (sounds_pracached)
+    {
+        return;
+    }
+
+    printf(english_language ?
+           "I_SDL_PrecacheSounds: Precaching all sound effects - " :
+           "I_SDL_PrecacheSounds: Кэширование звуковых эффектов - ");
+
+    sfx_jobs = malloc(num_sounds * sizeof(*sfx_jobs));
+    num_sfx_jobs = 0;
+    precache_pitch_budget = snd_pitchshift && snd_pitchprecache ?
+                            snd_pitchcachesize : 0;
+
+    DiskCacheInit();
+
+    printf("[");
+    for (i=0; i<num_sounds; ++i)
+    {
+        
+        if ((i % 6) == 0)
+        {
+            printf(".");
+            fflush(stdout);
+        }
+
+        GetSfxLumpName(&sounds[i], namebuf, sizeof(namebuf));
+
+        sounds[i].lumpnum = W_CheckNumForName(namebuf);
+
+        if (sounds[i].lumpnum == -1)
+        {
+            continue;
+        }
+
+        // Already loaded?
+        if (GetAllocatedSoundBySfxInfoAndPitch(&sounds[i], NORM_PITCH) != NULL)
+        {
+            continue;
+        }
+
+        if (sfx_jobs == NULL)
+        {
             CacheSFX(&sounds[i]);
+            continue;
+        }
+
+        job = &sfx_jobs[num_sfx_jobs];
+        job->cachename[0] = '\0';
+        job->cachesize = 0;
+        job->snd = NULL;
+        job->data = NULL;
+        job->num_variants = 0;
+        lump = W_CacheLumpNumRO(sounds[i].lumpnum, PU_STATIC);
+        lumplen = W_LumpLength(sounds[i].lumpnum);
+
+        // [JN] Converted already on one of previous launches?
+        if (diskcache_dir != NULL)
+        {
+            DiskCacheName(lump, lumplen, job->cachename, sizeof(job->cachename));
+            job->snd = DiskCacheLoad(&sounds[i], job->cachename);
+        }
+
+        if (job->snd != NULL)
+        {
+            // Still queued if pitch-shifted copies are to be made.
+            if (precache_pitch_budget <= 0)
+            {
+                ReserveCacheSpace(job->snd->chunk.alen);
+                AddSound(job->snd);
+                W_ReleaseLumpNumRO(sounds[i].lumpnum);
+                continue;
+            }
+        }
+        else if (ParseSFX(lump, lumplen, &data,
+                          &job->samplerate, &job->bits, &job->length))
+        {
+            job->data = malloc(job->length);
+
+            if (job->data != NULL)
+            {
+                memcpy(job->data, data, job->length);
+            }
         }
+
+        W_ReleaseLumpNumRO(sounds[i].lumpnum);
+
+        if (job->data == NULL && job->snd == NULL)
+        {
+            continue;
+        }
+
+        job->sfxinfo = &sounds[i];
+        job->state = SFXJOB_QUEUED;
+        sounds[i].driver_data = job;
+        num_sfx_jobs++;
     }
     printf("]");
 
     printf("\n");
 
     sounds_pracached = true;
+
+    if (num_sfx_jobs == 0)
+    {
+        FreeSfxJobs();
+        return;
+    }
+
+    next_sfx_job = 0;
+    next_sfx_collect = 0;
+    precache_quit = false;
+    precache_mutex = SDL_CreateMutex();
+    precache_cond = SDL_CreateCond();
+
+    if (precache_mutex != NULL && precache_cond != NULL)
+    {
+        precache_thread = SDL_CreateThread(PrecacheThread, "SFX precache", NULL);
+    }
+
+    // No thread, convert everything right away.
+    if (precache_thread == NULL)
+    {
+        PrecacheThread(NULL);
+        CollectPrecachedSounds();
+    }
 }
 
 // Load a SFX chunk into memory and ensure that it is locked.
@@ -934,7 +2006,11 @@ static boolean LockSound(sfxinfo_t *sfxinfo)
     // If the sound isn't loaded, load it now
     if (GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH) == NULL)
     {
-        if (!CacheSFX(sfxinfo))
+        // [JN] Take it from the precaching thread, if it's still there.
+        TakePrecachedSound(sfxinfo);
+
+        if (GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH) == NULL
+        && !CacheSFX(sfxinfo))
         {
             return false;
         }
@@ -1014,8 +2090,26 @@ static int I_SDL_StartSound(sfxinfo_t *sfxinfo, int channel, int vol, int sep, i
         return -1;
     }
 
+    // [JN] Fewer pitch-shifted copies are needed with rounded pitch.
+    if (snd_pitchshift)
+    {
+        pitch = QuantizePitch(pitch);
+    }
+
     snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, pitch);
 
+    if (pitch != NORM_PITCH)
+    {
+        if (snd != NULL)
+        {
+            pitch_hits++;
+        }
+        else
+        {
+            pitch_misses++;
+        }
+    }
+
     if (snd == NULL)
     {
         allocated_sound_t *newsnd;
@@ -1089,6 +2183,10 @@ static void I_SDL_UpdateSound(void)
 {
     int i;
 
+    // [JN] Pick up sounds resampled in background.
+
+    CollectPrecachedSounds();
+
     // Check all channels to see if a sound has finished
 
     for (i=0; i<NUM_CHANNELS; ++i)
@@ -1110,6 +2208,22 @@ static void I_SDL_ShutdownSound(void)
         return;
     }
 
+    StopPrecaching();
+
+    // [JN] Report how useful pitch-shifted sounds cache was.
+    if (pitch_hits + pitch_misses > 0)
+    {
+        printf(english_language ?
+               "I_SDL_ShutdownSound: pitch-shifted sounds: %u hits, %u misses (%.1f%% hit rate), %u made in background,\n"
+               "  %d cached, %.1f KiB (%.1f KiB peak)\n" :
+               "I_SDL_ShutdownSound: звуки со смещением высоты: %u попаданий, %u промахов (%.1f%% попаданий), %u создано в фоне,\n"
+               "  %d в кэше, %.1f КиБ (%.1f КиБ в пике)\n",
+               pitch_hits, pitch_misses,
+               100.0 * pitch_hits / (pitch_hits + pitch_misses),
+               pitch_precached, pitched_sounds_count,
+               pitched_sounds_size / 1024.0, pitched_sounds_peak / 1024.0);
+    }
+
     Mix_CloseAudio();
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
 
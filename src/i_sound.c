@@ -46,6 +46,19 @@ int snd_samplerate = 44100;
 
 int snd_cachesize = 64 * 1024 * 1024;
 
+// [JN] Maximum number of bytes to keep on disk for converted sound effects.
+// (Default: 32MB)
+
+int snd_diskcachesize = 32 * 1024 * 1024;
+
+// [JN] Maximum number of bytes to dedicate to pitch-shifted sound effects,
+// rounding step of pitch shifting and whether to make the most common
+// pitch-shifted sounds at startup. (Default: 16MB, exact pitch, no)
+
+int snd_pitchcachesize = 16 * 1024 * 1024;
+int snd_pitchstep = 1;
+int snd_pitchprecache = 0;
+
 // Config variable that controls the sound buffer size.
 // We default to 28ms (1000 / 35fps = 1 buffer per tic).
 
@@ -84,6 +97,8 @@ extern music_module_t music_opl_module;
 
 extern opl_driver_ver_t opl_drv_ver;
 extern int opl_io_port;
+extern int opl_render;
+extern int opl_diskcachesize;
 
 // For native music module:
 
@@ -454,7 +469,13 @@ void I_BindSoundVariables(void)
     M_BindStringVariable("snd_dmxoption",        &snd_dmxoption);
     M_BindIntVariable("snd_samplerate",          &snd_samplerate);
     M_BindIntVariable("snd_cachesize",           &snd_cachesize);
+    M_BindIntVariable("snd_diskcachesize",       &snd_diskcachesize);
+    M_BindIntVariable("snd_pitchcachesize",      &snd_pitchcachesize);
+    M_BindIntVariable("snd_pitchstep",           &snd_pitchstep);
+    M_BindIntVariable("snd_pitchprecache",       &snd_pitchprecache);
     M_BindIntVariable("opl_io_port",             &opl_io_port);
+    M_BindIntVariable("opl_render",              &opl_render);
+    M_BindIntVariable("opl_diskcachesize",       &opl_diskcachesize);
     M_BindIntVariable("snd_pitchshift",          &snd_pitchshift);
     M_BindIntVariable("mute_inactive_window",    &mute_inactive_window);
 
@@ -231,6 +231,10 @@ extern int snd_sfxdevice;
 extern int snd_musicdevice;
 extern int snd_samplerate;
 extern int snd_cachesize;
+extern int snd_diskcachesize;
+extern int snd_pitchcachesize;
+extern int snd_pitchstep;
+extern int snd_pitchprecache;
 extern int snd_maxslicetime_ms;
 extern char *snd_musiccmd;
 extern char *snd_dmxoption;
@@ -22,6 +22,11 @@
 
 #include "SDL.h"
 
+#ifdef __linux__
+#include <errno.h>
+#include <time.h>
+#endif
+
 #include "i_timer.h"
 #include "m_fixed.h" // [crispy]
 #include "doomtype.h"
@@ -86,6 +91,58 @@ void I_Sleep(int ms)
     SDL_Delay(ms);
 }
 
+// [JN] Sleep until given I_GetTimeUS time. Most of the time is slept with
+// the OS timer, and only the last part is busy-waited, so the wake up is
+// precise without burning a whole core.
+
+// clock_nanosleep wakes up within tens of us, SDL_Delay has about 1 ms
+// granularity.
+#define NANOSLEEP_SPIN_US 200
+#define DELAY_SPIN_US     2000
+
+void I_SleepUntilUS(uint64_t deadline)
+{
+    uint64_t now = I_GetTimeUS();
+
+#ifdef __linux__
+    // Translate the deadline to CLOCK_MONOTONIC once, then sleep to
+    // that absolute time, so interrupted sleeps don't accumulate error.
+    // On any other error, SDL_Delay below takes over.
+    if (deadline > now + NANOSLEEP_SPIN_US)
+    {
+        struct timespec ts;
+        uint64_t ns;
+
+        if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        {
+            ns = (uint64_t) ts.tv_nsec
+               + (deadline - now - NANOSLEEP_SPIN_US) * 1000ull;
+            ts.tv_sec += ns / 1000000000ull;
+            ts.tv_nsec = ns % 1000000000ull;
+
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                                   &ts, NULL) == EINTR)
+            {
+            }
+
+            now = I_GetTimeUS();
+        }
+    }
+#endif
+
+    while (deadline > now + DELAY_SPIN_US)
+    {
+        SDL_Delay((deadline - now - DELAY_SPIN_US) / 1000);
+        now = I_GetTimeUS();
+    }
+
+    // Bounded spin for the rest.
+    while (now < deadline)
+    {
+        now = I_GetTimeUS();
+    }
+}
+
 void I_WaitVBL(int count)
 {
     I_Sleep((count * 1000) / 70);
@@ -40,6 +40,9 @@ uint64_t I_GetTimeUS(void); // [crispy]
 // Pause for a specified number of ms
 void I_Sleep(int ms);
 
+// [JN] Pause until given I_GetTimeUS time
+void I_SleepUntilUS(uint64_t deadline);
+
 // Initialize timer
 void I_InitTimer(void);
 
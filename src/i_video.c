@@ -21,6 +21,7 @@
 
 
 #include <stdlib.h>
+#include <inttypes.h>
 #include <math.h>
 
 #include "SDL.h"
@@ -186,6 +187,11 @@ int real_fps;
 
 int smoothing = false;
 
+// [JN] Expand paletted screen buffer straight into the locked texture
+// through a lookup table, skipping intermediate 32-bit RGBA buffer.
+
+int fast_blit = true;
+
 // VGA Porch palette change emulation
 
 int vga_porch_flash = false;
@@ -289,6 +295,28 @@ const char *gammalevel_names_rus[] =
 // [JN] Used for realtime resizing of ENDOOM screen.
 boolean endoom_screen_active = false;
 
+// [JN] Palette lookup table for fast_blit, in texture's pixel format.
+
+static uint32_t palette_lut[256];
+
+// [JN] Timing statistics of frame presentation stages,
+// printed at exit with "-framestats" or "-timedemo".
+
+typedef struct
+{
+    uint64_t     total;  // microseconds
+    uint64_t     max;
+    double       sumsq;  // for standard deviation (jitter)
+    unsigned int count;
+} framestat_t;
+
+static boolean     framestats;
+static framestat_t framestat_blit;     // palette expansion and upload
+static framestat_t framestat_interval; // between two presented frames
+static framestat_t framestat_latency;  // blit start -> presented
+static framestat_t framestat_pacing;   // frame limiter wake up lateness
+static uint64_t    last_present_time;
+
 void *I_GetSDLWindow(void)
 {
     return screen;
@@ -839,7 +867,7 @@ fixed_t fractionaltic;
 // Used in screensize 9 for emulating 4:3 display aspect ratio.
 // -----------------------------------------------------------------------------
 
-void I_DrawBlackBorders (void)
+static void DrawBlackBorders (const SDL_Color *porch)
 {
     SDL_Rect rectangle_left;
     SDL_Rect rectangle_right;
@@ -848,8 +876,8 @@ void I_DrawBlackBorders (void)
     {
         // [JN] "flash" the pillars/letterboxes with palette 
         // changes, emulating VGA "porch" behaviour.
-        SDL_SetRenderDrawColor(renderer, palette[0].r, palette[0].g,
-                                         palette[0].b, SDL_ALPHA_OPAQUE);
+        SDL_SetRenderDrawColor(renderer, porch->r, porch->g,
+                                         porch->b, SDL_ALPHA_OPAQUE);
     }
     else
     {
@@ -871,6 +899,274 @@ void I_DrawBlackBorders (void)
     SDL_RenderFillRect(renderer, &rectangle_right);
 }
 
+void I_DrawBlackBorders (void)
+{
+    DrawBlackBorders(&palette[0]);
+}
+
+// -----------------------------------------------------------------------------
+// I_AddFrameStat
+// -----------------------------------------------------------------------------
+
+static void I_AddFrameStat (framestat_t *stat, const uint64_t time)
+{
+    stat->total += time;
+    stat->sumsq += (double) time * time;
+    stat->count++;
+
+    if (time > stat->max)
+    {
+        stat->max = time;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// I_PrintFrameStat
+// -----------------------------------------------------------------------------
+
+static void I_PrintFrameStat (const char *name, const framestat_t *stat)
+{
+    double avg, dev;
+
+    if (!stat->count)
+    {
+        return;
+    }
+
+    avg = (double) stat->total / stat->count;
+    dev = sqrt(MAX(stat->sumsq / stat->count - avg * avg, 0));
+
+    printf("  %-24s avg %8.1f us, dev %8.1f us, max %6" PRIu64 " us, %u frames\n",
+           name, avg, dev, stat->max, stat->count);
+}
+
+// -----------------------------------------------------------------------------
+// I_PrintFrameStats
+// -----------------------------------------------------------------------------
+
+static void I_PrintFrameStats (void)
+{
+    printf("I_PrintFrameStats:\n");
+    I_PrintFrameStat(fast_blit ? "blit + upload (LUT)" : "blit + upload (SDL)",
+                     &framestat_blit);
+    I_PrintFrameStat("present interval", &framestat_interval);
+    I_PrintFrameStat("blit to present", &framestat_latency);
+    I_PrintFrameStat("frame limiter lateness", &framestat_pacing);
+}
+
+// -----------------------------------------------------------------------------
+// I_UpdatePaletteLUT
+// [JN] Map the palette to texture's pixel format for fast_blit.
+// -----------------------------------------------------------------------------
+
+static void I_UpdatePaletteLUT (void)
+{
+    for (int i = 0 ; i < 256 ; i++)
+    {
+        palette_lut[i] = SDL_MapRGB(argbbuffer->format,
+                                    palette[i].r, palette[i].g, palette[i].b);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// I_ExpandRow
+// [JN] Expand one row of palette indices to 32-bit pixels.
+// -----------------------------------------------------------------------------
+
+static void I_ExpandRow (uint32_t *dest, const byte *src,
+                         const uint32_t *lut, const int width)
+{
+    int x = 0;
+
+    for ( ; x + 4 <= width ; x += 4)
+    {
+        dest[x + 0] = lut[src[x + 0]];
+        dest[x + 1] = lut[src[x + 1]];
+        dest[x + 2] = lut[src[x + 2]];
+        dest[x + 3] = lut[src[x + 3]];
+    }
+
+    for ( ; x < width ; x++)
+    {
+        dest[x] = lut[src[x]];
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+
+// [JN] AVX2 variant, gathers eight pixels from the lookup table at once.
+__attribute__((target("avx2")))
+static void I_ExpandRow_AVX2 (uint32_t *dest, const byte *src,
+                              const uint32_t *lut, const int width)
+{
+    int x = 0;
+
+    for ( ; x + 8 <= width ; x += 8)
+    {
+        const __m128i idx8 = _mm_loadl_epi64((const __m128i *) (src + x));
+        const __m256i idx = _mm256_cvtepu8_epi32(idx8);
+
+        _mm256_storeu_si256((__m256i *) (dest + x),
+                            _mm256_i32gather_epi32((const int *) lut, idx, 4));
+    }
+
+    I_ExpandRow(dest + x, src + x, lut, width - x);
+}
+#define HAVE_EXPANDROW_AVX2
+#endif
+
+// -----------------------------------------------------------------------------
+// I_ExpandScreen
+// [JN] Expand 8-bit screen buffer to 32-bit pixels, using the fastest
+// row expander this CPU supports.
+// -----------------------------------------------------------------------------
+
+static void I_ExpandScreen (void *dest, const int dest_pitch, const byte *src,
+                            const int src_pitch, const uint32_t *lut)
+{
+    static void (*expandrow) (uint32_t *, const byte *,
+                              const uint32_t *, const int);
+
+    if (!expandrow)
+    {
+        expandrow = I_ExpandRow;
+#ifdef HAVE_EXPANDROW_AVX2
+        if (__builtin_cpu_supports("avx2"))
+        {
+            expandrow = I_ExpandRow_AVX2;
+        }
+#endif
+    }
+
+    for (int y = 0 ; y < SCREENHEIGHT ; y++)
+    {
+        expandrow((uint32_t *) ((byte *) dest + y * dest_pitch),
+                  src + y * src_pitch, lut, screenwidth);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// I_BlitToTexture
+// [JN] Expand 8-bit screen buffer directly into the locked streaming texture.
+// Returns false if texture can't be locked, so SDL blitting must be used.
+// -----------------------------------------------------------------------------
+
+static boolean I_BlitToTexture (const byte *src, const int src_pitch,
+                                 const uint32_t *lut)
+{
+    void *pixels;
+    int   pitch;
+
+    if (argbbuffer->format->BytesPerPixel != 4
+    ||  SDL_LockTexture(texture, NULL, &pixels, &pitch) < 0)
+    {
+        return false;
+    }
+
+    I_ExpandScreen(pixels, pitch, src, src_pitch, lut);
+
+    SDL_UnlockTexture(texture);
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// I_RenderTexture
+// [JN] Render the intermediate texture to the screen and present it.
+// -----------------------------------------------------------------------------
+
+static void DrawBlackBorders (const SDL_Color *porch);
+
+static void I_RenderTexture (const SDL_Color *porch, const boolean porch_flash,
+                             const boolean draw_borders)
+{
+    if (porch_flash)
+    {
+        // "flash" the pillars/letterboxes with palette changes, emulating
+        // VGA "porch" behaviour (GitHub issue #832)
+        SDL_SetRenderDrawColor(renderer, porch->r, porch->g, porch->b,
+                               SDL_ALPHA_OPAQUE);
+    }
+
+    // Make sure the pillarboxes are kept clear each frame.
+
+    SDL_RenderClear(renderer);
+
+    if (smoothing)
+    {
+    // Render this intermediate texture into the upscaled texture
+    // using "nearest" integer scaling.
+
+    SDL_SetRenderTarget(renderer, texture_upscaled);
+    SDL_RenderCopy(renderer, texture, NULL, NULL);
+
+    // Finally, render this upscaled texture to screen using linear scaling.
+
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
+    }
+    else
+    {
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_RenderCopy(renderer, texture, NULL, NULL);
+    }
+
+    if (draw_borders)
+    {
+        DrawBlackBorders(porch);
+    }
+
+    // Draw!
+
+    SDL_RenderPresent(renderer);
+
+    if (framestats)
+    {
+        const uint64_t now = I_GetTimeUS();
+
+        if (last_present_time)
+        {
+            I_AddFrameStat(&framestat_interval, now - last_present_time);
+        }
+        last_present_time = now;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// I_PresentScreen
+// [JN] Expand, upload and present the screen buffer.
+// -----------------------------------------------------------------------------
+
+static void I_PresentScreen (void)
+{
+    const uint64_t blit_start = framestats ? I_GetTimeUS() : 0;
+
+    // [JN] Expand the paletted 8-bit screen buffer right into the texture,
+    // if possible. Otherwise, blit from the paletted 8-bit screen buffer
+    // to the intermediate 32-bit RGBA buffer that we can load into the
+    // texture, and update the texture with the contents of the RGBA buffer.
+
+    if (!fast_blit || !I_BlitToTexture(screenbuffer->pixels, screenbuffer->pitch, palette_lut))
+    {
+        SDL_BlitSurface(screenbuffer, &blit_rect, argbbuffer, &blit_rect);
+        SDL_UpdateTexture(texture, NULL, argbbuffer->pixels, argbbuffer->pitch);
+    }
+
+    if (framestats)
+    {
+        I_AddFrameStat(&framestat_blit, I_GetTimeUS() - blit_start);
+    }
+
+    I_RenderTexture(&palette[0], vga_porch_flash && aspect_ratio <= 1,
+                    aspect_ratio >= 2 && screenblocks == 9);
+
+    if (framestats)
+    {
+        I_AddFrameStat(&framestat_latency, I_GetTimeUS() - blit_start);
+    }
+}
+
 //
 // I_FinishUpdate
 //
@@ -956,83 +1252,39 @@ void I_FinishUpdate (void)
     if (palette_to_set)
     {
         SDL_SetPaletteColors(screenbuffer->format->palette, palette, 0, 256);
+        I_UpdatePaletteLUT();
         palette_to_set = false;
     }
 
-    if (vga_porch_flash && aspect_ratio <= 1)
-    {
-        // "flash" the pillars/letterboxes with palette changes, emulating
-        // VGA "porch" behaviour (GitHub issue #832)
-        SDL_SetRenderDrawColor(renderer, palette[0].r, palette[0].g,
-            palette[0].b, SDL_ALPHA_OPAQUE);
-    }
-
-    // Blit from the paletted 8-bit screen buffer to the intermediate
-    // 32-bit RGBA buffer that we can load into the texture.
-
-    SDL_BlitSurface(screenbuffer, &blit_rect, argbbuffer, &blit_rect);
-
-    // Update the intermediate texture with the contents of the RGBA buffer.
-
-    SDL_UpdateTexture(texture, NULL, argbbuffer->pixels, argbbuffer->pitch);
-
-    // Make sure the pillarboxes are kept clear each frame.
-
-    SDL_RenderClear(renderer);
-
-    if (smoothing)
-    {
-    // Render this intermediate texture into the upscaled texture
-    // using "nearest" integer scaling.
-
-    SDL_SetRenderTarget(renderer, texture_upscaled);
-    SDL_RenderCopy(renderer, texture, NULL, NULL);
-
-    // Finally, render this upscaled texture to screen using linear scaling.
-
-    SDL_SetRenderTarget(renderer, NULL);
-    SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
-    }
-    else
-    {
-    SDL_SetRenderTarget(renderer, NULL);
-    SDL_RenderCopy(renderer, texture, NULL, NULL);
-    }
-
-    if (aspect_ratio >= 2 && screenblocks == 9)
-    {
-        I_DrawBlackBorders();
-    }
-
-    // Draw!
-
-    SDL_RenderPresent(renderer);
+    I_PresentScreen();
 
     if (uncapped_fps && !singletics)
     {
         // Limit framerate
         if (max_fps >= TICRATE)
         {
-            uint64_t target_time = 1000000ull / max_fps;
-            static uint64_t start_time;
+            const uint64_t target_time = 1000000ull / max_fps;
+            const uint64_t current_time = I_GetTimeUS();
+            static uint64_t deadline;
 
-            while (1)
-            {
-                uint64_t current_time = I_GetTimeUS();
-                uint64_t elapsed_time = current_time - start_time;
-                uint64_t remaining_time = 0;
+            // [JN] Frames are scheduled to absolute deadlines, so sleep
+            // overshoots don't add up. If the game fell behind for more
+            // than a frame, or max_fps was changed, start over from now.
 
-                if (elapsed_time >= target_time)
-                {
-                    start_time = current_time;
-                    break;
-                }
+            deadline += target_time;
 
-                remaining_time = target_time - elapsed_time;
+            if (deadline + target_time < current_time
+            ||  deadline > current_time + target_time)
+            {
+                deadline = current_time;
+            }
+            else if (deadline > current_time)
+            {
+                I_SleepUntilUS(deadline);
 
-                if (remaining_time > 1000)
+                if (framestats)
                 {
-                    I_Sleep((remaining_time - 1000) / 1000);
+                    I_AddFrameStat(&framestat_pacing, I_GetTimeUS() - deadline);
                 }
             }
         }
@@ -1213,6 +1465,15 @@ void I_GraphicsCheckCommandLine(void)
 
     nograbmouse_override = M_ParmExists("-nograbmouse");
 
+    //!
+    // @category video
+    //
+    // Print timing statistics of frame presentation stages at exit.
+    // Implied by -timedemo.
+    //
+
+    framestats = M_ParmExists("-framestats") || M_ParmExists("-timedemo");
+
     // default to fullscreen mode, allow override with command line
     // nofullscreen because we love prboom
 
@@ -1722,6 +1983,11 @@ void I_InitGraphics(void)
     while (SDL_PollEvent(&dummy));
 
     initialized = true;
+
+    if (framestats)
+    {
+        I_AtExit(I_PrintFrameStats, true);
+    }
 }
 
 // -----------------------------------------------------------------------------
@@ -1932,6 +2198,7 @@ void I_BindVideoVariables(void)
     M_BindIntVariable("preserve_window_aspect_ratio",&preserve_window_aspect_ratio);
     M_BindIntVariable("smoothing",                   &smoothing);
     M_BindIntVariable("max_fps",                     &max_fps);
+    M_BindIntVariable("fast_blit",                   &fast_blit);
     M_BindIntVariable("vga_porch_flash",             &vga_porch_flash);
     M_BindIntVariable("startup_delay",               &startup_delay);
     M_BindIntVariable("resize_delay",                &resize_delay);
@@ -491,7 +491,7 @@ void I_WIN_ResumeSong(void)
     }
 }
 
-boolean I_WIN_RegisterSong(char *filename)
+boolean I_WIN_RegisterSong(void *data, int len)
 {
     int i;
     midi_file_t *file;
@@ -499,7 +499,7 @@ boolean I_WIN_RegisterSong(char *filename)
     MIDIPROPTEMPO tempo;
     MMRESULT mmr;
 
-    file = MIDI_LoadFile(filename);
+    file = MIDI_LoadMemory(data, len);
 
     if (file == NULL)
     {
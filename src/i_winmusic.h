@@ -29,7 +29,7 @@ void I_WIN_PauseSong(void);
 void I_WIN_ResumeSong(void);
 void I_WIN_StopSong(void);
 void I_WIN_SetMusicVolume(int volume);
-boolean I_WIN_RegisterSong(char* filename);
+boolean I_WIN_RegisterSong(void *data, int len);
 void I_WIN_UnRegisterSong(void);
 void I_WIN_ShutdownMusic(void);
 
@@ -342,6 +342,7 @@ extern int translucency;
 extern int improved_fuzz;
 extern int colored_blood;
 extern int swirling_liquids;
+extern int swirl_cache_size;
 extern int invul_sky;
 extern int linear_sky;
 extern int randomly_flipcorpses;
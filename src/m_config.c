@@ -26,6 +26,7 @@
 #include <ctype.h>
 #include <assert.h>
 #include <locale.h>
+#include <stdarg.h>
 
 #include "SDL_filesystem.h"
 
@@ -87,6 +88,11 @@ typedef struct
 {
     default_t *defaults;
     int numdefaults;
+
+    // Open addressing index of variables by name, built on first lookup.
+    // Slots hold index + 1, 0 marks an empty slot.
+    int *hashtable;
+    unsigned int hashmask;
 } default_collection_t;
 
 #define CONFIG_VARIABLE_GENERIC(name, type) \
@@ -409,6 +415,38 @@ static default_t defaults_list[] =
 
     CONFIG_VARIABLE_INT(snd_cachesize),
 
+    //!
+    // [JN] Maximum number of bytes to keep on disk for caching converted
+    // sound effects between launches. If set to zero, the disk cache is
+    // not used.
+    //
+
+    CONFIG_VARIABLE_INT(snd_diskcachesize),
+
+    //!
+    // [JN] Maximum number of bytes to keep pitch-shifted copies of sound
+    // effects in memory after they have been played. If set to zero, a
+    // copy is freed as soon as it stops playing.
+    //
+
+    CONFIG_VARIABLE_INT(snd_pitchcachesize),
+
+    //!
+    // [JN] Pitch shifting is rounded to multiples of this value, so
+    // fewer pitch-shifted copies of sound effects are needed. 1 keeps
+    // the pitch exactly as the game requests it.
+    //
+
+    CONFIG_VARIABLE_INT(snd_pitchstep),
+
+    //!
+    // [JN] If non-zero, pitch-shifted copies of sound effects nearest to
+    // the normal pitch are made in background at startup, until
+    // snd_pitchcachesize is used up.
+    //
+
+    CONFIG_VARIABLE_INT(snd_pitchprecache),
+
     //!
     // Maximum size of the output sound buffer size in milliseconds.
     // Sound output is generated periodically in slices. Higher values
@@ -440,6 +478,22 @@ static default_t defaults_list[] =
 
     CONFIG_VARIABLE_INT_HEX(opl_io_port),
 
+    //!
+    // [JN] If non-zero, OPL music is rendered into memory in background
+    // when a song starts, and the rendered copy is played instead of
+    // emulating the chip in real time. Only relevant when using software
+    // OPL emulation.
+    //
+
+    CONFIG_VARIABLE_INT(opl_render),
+
+    //!
+    // [JN] Maximum number of bytes to keep on disk for rendered OPL
+    // music between launches. If set to zero, the disk cache is not used.
+    //
+
+    CONFIG_VARIABLE_INT(opl_diskcachesize),
+
     //!
     // @game doom heretic strife
     //
@@ -534,6 +588,7 @@ static default_t defaults_list[] =
     CONFIG_VARIABLE_INT(show_fps),
     CONFIG_VARIABLE_INT(smoothing),
     CONFIG_VARIABLE_INT(max_fps),
+    CONFIG_VARIABLE_INT(fast_blit),
     CONFIG_VARIABLE_INT(smoothlight),
     CONFIG_VARIABLE_INT(show_diskicon),
     CONFIG_VARIABLE_INT(screen_wiping),
@@ -615,6 +670,7 @@ static default_t defaults_list[] =
     CONFIG_VARIABLE_INT(colored_blood),
     CONFIG_VARIABLE_INT(improved_fuzz),
     CONFIG_VARIABLE_INT(swirling_liquids),
+    CONFIG_VARIABLE_INT(swirl_cache_size),
     CONFIG_VARIABLE_INT(invul_sky),
     CONFIG_VARIABLE_INT(linear_sky),
     CONFIG_VARIABLE_INT(randomly_flipcorpses),
@@ -686,15 +742,21 @@ static default_t defaults_list[] =
     CONFIG_VARIABLE_INT(demotimerdir),
     CONFIG_VARIABLE_INT(demobar),
     CONFIG_VARIABLE_INT(no_internal_demos),
+
+    // Gameplay: Rewind
+    CONFIG_VARIABLE_INT(rewind_depth),
+    CONFIG_VARIABLE_INT(rewind_interval),
 };
 
 static default_collection_t default_collection =
 {
     defaults_list,
-    arrlen(defaults_list)
+    arrlen(defaults_list),
+    NULL,
+    0
 };
 
-static void DefaultHandler_Save(FILE* file, char* sectionName);
+static void DefaultHandler_Save(config_text_t* text, char* sectionName);
 static void DefaultHandler_HandleLine(char* keyName, char *value, size_t valueSize);
 static boolean DefaultHandler_isHandling(char* sectionName)
 {
@@ -729,24 +791,94 @@ static sectionHandler_t* handlers[] = {
 
 };
 
+// FNV-1a hash of a variable name.
+
+unsigned int M_HashConfigName(const char *name)
+{
+    unsigned int hash = 2166136261u;
+
+    while (*name != '\0')
+    {
+        hash = (hash ^ (byte) *name++) * 16777619u;
+    }
+
+    return hash;
+}
+
+// Builds the name index of a collection, at most half full.
+
+static boolean BuildCollectionIndex(default_collection_t *collection)
+{
+    unsigned int size = 16;
+    unsigned int slot;
+    int i;
+
+    while (size < (unsigned int) collection->numdefaults * 2)
+    {
+        size <<= 1;
+    }
+
+    collection->hashtable = calloc(size, sizeof(int));
+
+    if (collection->hashtable == NULL)
+    {
+        return false;
+    }
+
+    collection->hashmask = size - 1;
+
+    for (i = 0; i < collection->numdefaults; ++i)
+    {
+        slot = M_HashConfigName(collection->defaults[i].name) & collection->hashmask;
+
+        while (collection->hashtable[slot] != 0)
+        {
+            slot = (slot + 1) & collection->hashmask;
+        }
+
+        collection->hashtable[slot] = i + 1;
+    }
+
+    return true;
+}
+
 // Search a collection for a variable
 
 static default_t *SearchCollection(default_collection_t *collection, char *name)
 {
+    unsigned int slot;
     int i;
 
-    for (i=0; i<collection->numdefaults; ++i) 
+    if (collection->hashtable == NULL && !BuildCollectionIndex(collection))
+    {
+        // Out of memory, fall back to a linear search.
+        for (i=0; i<collection->numdefaults; ++i) 
+        {
+            if (!strcmp(name, collection->defaults[i].name))
+            {
+                return &collection->defaults[i];
+            }
+        }
+
+        return NULL;
+    }
+
+    slot = M_HashConfigName(name) & collection->hashmask;
+
+    while ((i = collection->hashtable[slot]) != 0)
     {
-        if (!strcmp(name, collection->defaults[i].name))
+        if (!strcmp(name, collection->defaults[i - 1].name))
         {
-            return &collection->defaults[i];
+            return &collection->defaults[i - 1];
         }
+
+        slot = (slot + 1) & collection->hashmask;
     }
 
     return NULL;
 }
 
-static void DefaultHandler_Save(FILE* file, char* sectionName)
+static void DefaultHandler_Save(config_text_t* text, char* sectionName)
 {
     default_t *defaults;
     int i;
@@ -765,19 +897,19 @@ static void DefaultHandler_Save(FILE* file, char* sectionName)
         switch (defaults[i].type) 
         {
             case DEFAULT_INT:
-	            fprintf(file, "%s = %i\n", defaults[i].name, *defaults[i].location.i);
+	            M_ConfigPrintf(text, "%s = %i\n", defaults[i].name, *defaults[i].location.i);
                 break;
 
             case DEFAULT_INT_HEX:
-	            fprintf(file, "%s = 0x%x\n", defaults[i].name, *defaults[i].location.i);
+	            M_ConfigPrintf(text, "%s = 0x%x\n", defaults[i].name, *defaults[i].location.i);
                 break;
 
             case DEFAULT_FLOAT:
-                fprintf(file, "%s = %f\n", defaults[i].name, *defaults[i].location.f);
+                M_ConfigPrintf(text, "%s = %f\n", defaults[i].name, *defaults[i].location.f);
                 break;
 
             case DEFAULT_STRING:
-	            fprintf(file, "%s = \"%s\"\n", defaults[i].name, *defaults[i].location.s);
+	            M_ConfigPrintf(text, "%s = \"%s\"\n", defaults[i].name, *defaults[i].location.s);
                 break;
         }
     }
@@ -895,13 +1027,109 @@ static void SetVariable(default_t *def, char *value)
     }
 }
 
+struct config_text_s
+{
+    char *data;
+    size_t length;
+    size_t size;
+    boolean failed;     // out of memory
+};
+
+// Text of the config file as last loaded or saved, to tell if anything
+// has changed since. NULL if unknown.
+static char *config_text;
+static size_t config_text_length;
+
+void M_ConfigPrintf(config_text_t *text, const char *format, ...)
+{
+    va_list args;
+    int len;
+
+    while (!text->failed)
+    {
+        va_start(args, format);
+        len = vsnprintf(text->data + text->length, text->size - text->length,
+                        format, args);
+        va_end(args);
+
+        if (len < 0)
+        {
+            text->failed = true;
+        }
+        else if ((size_t) len < text->size - text->length)
+        {
+            text->length += len;
+            return;
+        }
+        else
+        {
+            // Grow the buffer and print again.
+            size_t size = text->size * 2 + len;
+            char *data = realloc(text->data, size);
+
+            if (data == NULL)
+            {
+                text->failed = true;
+            }
+            else
+            {
+                text->data = data;
+                text->size = size;
+            }
+        }
+    }
+}
+
+// Remembers the text of the config file as it is on disk now.
+
+static void SetConfigText(const char *data, size_t length)
+{
+    free(config_text);
+    config_text = malloc(length);
+    config_text_length = length;
+
+    if (config_text != NULL)
+    {
+        memcpy(config_text, data, length);
+    }
+}
+
+static void ReadConfigText(const char *path)
+{
+    FILE *file;
+    long length;
+    char *data;
+
+    file = M_fopen(path, "rb");
+    if (file == NULL)
+    {
+        return;
+    }
+
+    length = M_FileLength(file);
+    data = length > 0 ? malloc(length) : NULL;
+
+    if (data != NULL && fread(data, 1, length, file) == (size_t) length)
+    {
+        SetConfigText(data, length);
+    }
+
+    free(data);
+    fclose(file);
+}
+
 //
 // M_SaveConfig
 //
+// [JN] The configuration is put together in memory first. If it is the
+// same as the file on disk, nothing is written. Otherwise the file is
+// replaced by M_SyncWriteFile, so a failed write never leaves a
+// truncated file behind.
+//
 
 void M_SaveConfig (void)
 {
-    FILE *f;
+    config_text_t text;
     section_t* section;
 
     if(!configPath.savePath)
@@ -912,35 +1140,53 @@ void M_SaveConfig (void)
         return;
     }
 
-    printf(english_language ?
-           "Saving configuration file:\n    %s\n" :
-           "Сохранение файла конфигурации:\n    %s\n",
-        configPath.savePath);
+    text.size = 16384;
+    text.length = 0;
+    text.data = malloc(text.size);
+    text.failed = text.data == NULL;
 
-    const char* config_dir = M_DirName(configPath.savePath);
-    M_MakeDirectory(config_dir);
-    free(config_dir);
+    M_ConfigPrintf(&text, "config_version = %i\n\n", CURRENT_CONFIG_VERSION);
+    section = sections;
+    while(section)
+    {
+        M_ConfigPrintf(&text, "[%s]\n", section->name);
+        section->handler->save(&text, section->name);
+        M_ConfigPrintf(&text, "\n");
+        section = section->next;
+    }
 
-    f = M_fopen(configPath.savePath, "w");
-    if(!f)
+    if(text.failed)
     {
         I_AddError(english_language ?
-                   "Unable to open configuration file for writing\n" :
-                   "Не удалось открыть файл конфигурации для записи\n");
-        return;
+                   "Unable to write configuration file\n" :
+                   "Не удалось записать файл конфигурации\n");
     }
-
-    fprintf(f, "config_version = %i\n\n", CURRENT_CONFIG_VERSION);
-    section = sections;
-    while(section)
+    else if(config_text == NULL
+         || config_text_length != text.length
+         || memcmp(config_text, text.data, text.length) != 0)
     {
-        fprintf(f, "[%s]\n", section->name);
-        section->handler->save(f, section->name);
-        fprintf(f, "\n");
-        section = section->next;
+        const char* config_dir = M_DirName(configPath.savePath);
+        M_MakeDirectory(config_dir);
+        free(config_dir);
+
+        printf(english_language ?
+               "Saving configuration file:\n    %s\n" :
+               "Сохранение файла конфигурации:\n    %s\n",
+            configPath.savePath);
+
+        if(M_SyncWriteFile(configPath.savePath, text.data, text.length))
+        {
+            SetConfigText(text.data, text.length);
+        }
+        else
+        {
+            I_AddError(english_language ?
+                       "Unable to write configuration file\n" :
+                       "Не удалось записать файл конфигурации\n");
+        }
     }
 
-    fclose(f);
+    free(text.data);
 }
 
 void M_AppendConfigSection(const char* sectionName, sectionHandler_t* handler)
@@ -1198,6 +1444,12 @@ void M_LoadConfig(void)
 
     fclose(file);
 
+    if(configPath.savePath != NULL
+    && strcmp(configPath.loadPath, configPath.savePath) == 0)
+    {
+        ReadConfigText(configPath.loadPath);
+    }
+
     if(!isBindsLoaded)
     {
         BK_ApplyDefaultBindings();
@@ -1350,3 +1602,27 @@ char* M_GetAutoloadDir(void)
     free(prefix);
     return autoload_path;
 }
+
+char* M_GetSfxCacheDir(void)
+{
+    char* prefix = M_DirName(configPath.savePath);
+    char* cache_path = M_StringJoin(prefix, DIR_SEPARATOR_S, "sfxcache", NULL);
+    free(prefix);
+    return cache_path;
+}
+
+char* M_GetMusicCacheDir(void)
+{
+    char* prefix = M_DirName(configPath.savePath);
+    char* cache_path = M_StringJoin(prefix, DIR_SEPARATOR_S, "musiccache", NULL);
+    free(prefix);
+    return cache_path;
+}
+
+char* M_GetPaletteCacheDir(void)
+{
+    char* prefix = M_DirName(configPath.savePath);
+    char* cache_path = M_StringJoin(prefix, DIR_SEPARATOR_S, "palcache", NULL);
+    free(prefix);
+    return cache_path;
+}
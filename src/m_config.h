@@ -25,6 +25,11 @@
 #include "doomtype.h"
 
 
+/**
+ * Text of the config file, built in memory by M_SaveConfig.
+ */
+typedef struct config_text_s config_text_t;
+
 typedef struct
 {
     /**
@@ -39,7 +44,7 @@ typedef struct
     /**
      * Saves all data of the handled section to the config file.
      */
-    void (*save) (FILE *file, char* sectionName);
+    void (*save) (config_text_t *text, char* sectionName);
 
     /**
      * Called in the end of section handling.
@@ -59,8 +64,21 @@ typedef enum
 void M_LoadConfig(void);
 void M_SaveConfig(void);
 void M_AppendConfigSection(const char* sectionName, sectionHandler_t* handler);
+
+/**
+ * Appends formatted text to the config text. Used by section handlers.
+ */
+void M_ConfigPrintf(config_text_t *text, const char *format, ...) PRINTF_ATTR(2, 3);
+
+/**
+ * FNV-1a hash of a config variable name.
+ */
+unsigned int M_HashConfigName(const char *name);
 void M_BindIntVariable(char *name, int *variable);
 void M_BindFloatVariable(char *name, float *variable);
 void M_BindStringVariable(char *name, char **variable);
 char* M_GetSaveGameDir(void);
 char* M_GetAutoloadDir(void);
+char* M_GetSfxCacheDir(void);
+char* M_GetMusicCacheDir(void);
+char* M_GetPaletteCacheDir(void);
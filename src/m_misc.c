@@ -36,6 +36,12 @@
 #include <unistd.h>
 #endif
 
+#include "SDL.h"
+
+#define MINIZ_NO_STDIO
+#define MINIZ_NO_ZLIB_APIS
+#include "miniz.h"
+
 #include "doomtype.h"
 #include "d_name.h"
 #include "i_system.h"
@@ -295,6 +301,441 @@ boolean M_WriteFileTimeout(const char *name, void *source, int length, int delay
     return res;
 }
 
+//
+// [JN] Background file writer.
+//
+// Jobs are done one by one on a separate thread in the order they were
+// queued, so a removal queued before a write of the same file can't undo it.
+// Files are written to a temporary file, synced and renamed over the old one.
+//
+// Savegames are deflated on the same thread. First "head" bytes (description
+// and version) are kept as is for the menus, followed by SAVEGAME_MAGIC,
+// length of the rest of the data (little endian) and the deflated data.
+//
+
+#define SAVEGAME_MAGIC "\xfeRDZ"
+#define SAVEGAME_MAGIC_SIZE 4
+#define SAVEGAME_MAX_RATIO 1032
+
+typedef struct asyncjob_s
+{
+    char *name;
+    byte *data;     // NULL for removal
+    size_t length;
+    boolean deflate;
+    boolean savegame;   // counted by M_GetSaveGameStatus
+    size_t head;
+    struct asyncjob_s *next;
+} asyncjob_t;
+
+static SDL_Thread *async_thread;
+static SDL_mutex *async_mutex;
+static SDL_cond *async_cond;
+static asyncjob_t *async_head, *async_tail;
+static boolean async_busy;
+static boolean async_quit;
+
+// Savegame writes not finished yet, and the result of those finished
+// since the last M_GetSaveGameStatus call. Guarded by async_mutex.
+static int savegame_pending;
+static boolean savegame_done;
+static boolean savegame_failed;
+
+boolean M_SyncWriteFile (const char *name, const void *data, size_t length)
+{
+    char *temp_name;
+    FILE *handle;
+    boolean result;
+
+    temp_name = M_StringJoin(name, ".tmp", NULL);
+    handle = M_fopen(temp_name, "wb");
+
+    if (handle == NULL)
+    {
+        free(temp_name);
+        return false;
+    }
+
+    result = fwrite(data, 1, length, handle) == length
+          && fflush(handle) == 0;
+
+    // Make sure data is on disk before the old file is replaced.
+    if (result)
+    {
+#ifdef _WIN32
+        _commit(_fileno(handle));
+#else
+        fsync(fileno(handle));
+#endif
+    }
+
+    result = fclose(handle) == 0 && result;
+
+    if (result)
+    {
+#ifdef _WIN32
+        // Rename doesn't overwrite existing files on Windows.
+        M_remove(name);
+#endif
+        result = M_rename(temp_name, name) == 0;
+    }
+    else
+    {
+        M_remove(temp_name);
+    }
+
+    free(temp_name);
+
+    return result;
+}
+
+static byte *M_DeflateSaveGame (const byte *data, size_t length, size_t head,
+                                size_t *out_length)
+{
+    byte *deflated, *result;
+    size_t deflated_length;
+
+    deflated = tdefl_compress_mem_to_heap(data + head, length - head,
+                                          &deflated_length,
+                                          TDEFL_DEFAULT_MAX_PROBES);
+
+    if (deflated == NULL)
+    {
+        return NULL;
+    }
+
+    *out_length = head + SAVEGAME_MAGIC_SIZE + 4 + deflated_length;
+    result = malloc(*out_length);
+
+    memcpy(result, data, head);
+    memcpy(result + head, SAVEGAME_MAGIC, SAVEGAME_MAGIC_SIZE);
+    result[head + SAVEGAME_MAGIC_SIZE + 0] = (length - head) & 0xff;
+    result[head + SAVEGAME_MAGIC_SIZE + 1] = ((length - head) >> 8) & 0xff;
+    result[head + SAVEGAME_MAGIC_SIZE + 2] = ((length - head) >> 16) & 0xff;
+    result[head + SAVEGAME_MAGIC_SIZE + 3] = ((length - head) >> 24) & 0xff;
+    memcpy(result + head + SAVEGAME_MAGIC_SIZE + 4, deflated, deflated_length);
+
+    mz_free(deflated);
+
+    return result;
+}
+
+static boolean M_DoAsyncJob (asyncjob_t *job)
+{
+    boolean result = true;
+
+    if (job->data != NULL && job->deflate)
+    {
+        size_t length;
+        byte *deflated = M_DeflateSaveGame(job->data, job->length,
+                                           job->head, &length);
+
+        // Should never happen, but better have uncompressed save than none.
+        if (deflated != NULL)
+        {
+            free(job->data);
+            job->data = deflated;
+            job->length = length;
+        }
+    }
+
+    if (job->data == NULL)
+    {
+        M_remove(job->name);
+    }
+    else if (!M_SyncWriteFile(job->name, job->data, job->length))
+    {
+        fprintf(stderr, english_language ?
+                "M_WriteFileAsync: failed to write %s\n" :
+                "M_WriteFileAsync: ошибка записи файла %s\n",
+                job->name);
+        result = false;
+    }
+
+    free(job->name);
+    free(job->data);
+    free(job);
+
+    return result;
+}
+
+static void M_FinishSaveGameJob (boolean result)
+{
+    savegame_pending--;
+    savegame_done = true;
+    savegame_failed |= !result;
+}
+
+static int AsyncWriterThread (void *unused)
+{
+    asyncjob_t *job;
+    boolean savegame, result;
+
+    SDL_LockMutex(async_mutex);
+
+    for (;;)
+    {
+        while (async_head == NULL && !async_quit)
+        {
+            SDL_CondWait(async_cond, async_mutex);
+        }
+
+        if (async_head == NULL)
+        {
+            break;
+        }
+
+        job = async_head;
+        async_head = job->next;
+        if (async_head == NULL)
+        {
+            async_tail = NULL;
+        }
+        async_busy = true;
+
+        SDL_UnlockMutex(async_mutex);
+        savegame = job->savegame;
+        result = M_DoAsyncJob(job);
+        SDL_LockMutex(async_mutex);
+
+        if (savegame)
+        {
+            M_FinishSaveGameJob(result);
+        }
+
+        async_busy = false;
+        SDL_CondBroadcast(async_cond);
+    }
+
+    SDL_UnlockMutex(async_mutex);
+
+    return 0;
+}
+
+static void M_ShutdownAsyncWriter (void)
+{
+    if (async_thread == NULL)
+    {
+        return;
+    }
+
+    // Pending saves are finished before quitting.
+    SDL_LockMutex(async_mutex);
+    async_quit = true;
+    SDL_CondBroadcast(async_cond);
+    SDL_UnlockMutex(async_mutex);
+
+    SDL_WaitThread(async_thread, NULL);
+    async_thread = NULL;
+
+    SDL_DestroyCond(async_cond);
+    SDL_DestroyMutex(async_mutex);
+}
+
+static void M_QueueAsyncJob (const char *name, const void *data, size_t length,
+                             boolean deflate, size_t head)
+{
+    asyncjob_t *job;
+    boolean result;
+
+    job = malloc(sizeof(*job));
+    job->name = M_StringDuplicate(name);
+    job->data = NULL;
+    job->length = length;
+    job->deflate = deflate && length >= head;
+    job->savegame = deflate;
+    job->head = head;
+    job->next = NULL;
+
+    if (data != NULL)
+    {
+        job->data = malloc(MAX(length, 1));
+        memcpy(job->data, data, length);
+    }
+
+    if (async_thread == NULL && !async_quit)
+    {
+        async_mutex = SDL_CreateMutex();
+        async_cond = SDL_CreateCond();
+        async_thread = SDL_CreateThread(AsyncWriterThread, "AsyncWriter", NULL);
+
+        if (async_thread != NULL)
+        {
+            I_AtExit(M_ShutdownAsyncWriter, true);
+        }
+        else
+        {
+            SDL_DestroyCond(async_cond);
+            SDL_DestroyMutex(async_mutex);
+            async_quit = true;
+        }
+    }
+
+    // No thread, no luck. Do it right away.
+    if (async_thread == NULL)
+    {
+        if (deflate)
+        {
+            savegame_pending++;
+            result = M_DoAsyncJob(job);
+            M_FinishSaveGameJob(result);
+        }
+        else
+        {
+            M_DoAsyncJob(job);
+        }
+        return;
+    }
+
+    SDL_LockMutex(async_mutex);
+
+    if (deflate)
+    {
+        savegame_pending++;
+    }
+
+    if (async_tail)
+        async_tail->next = job;
+    else
+        async_head = job;
+    async_tail = job;
+
+    SDL_CondSignal(async_cond);
+    SDL_UnlockMutex(async_mutex);
+}
+
+void M_WriteFileAsync (const char *name, const void *source, size_t length)
+{
+    M_QueueAsyncJob(name, source, length, false, 0);
+}
+
+void M_WriteSaveGameAsync (const char *name, const void *source, size_t length,
+                           size_t head)
+{
+    M_QueueAsyncJob(name, source, length, true, head);
+}
+
+void M_RemoveFileAsync (const char *name)
+{
+    M_QueueAsyncJob(name, NULL, 0, false, 0);
+}
+
+savegame_status_t M_GetSaveGameStatus (void)
+{
+    savegame_status_t status = SAVEGAME_IDLE;
+
+    if (async_thread != NULL)
+    {
+        SDL_LockMutex(async_mutex);
+    }
+
+    if (savegame_pending > 0)
+    {
+        status = SAVEGAME_PENDING;
+    }
+    else if (savegame_done)
+    {
+        status = savegame_failed ? SAVEGAME_FAILED : SAVEGAME_WRITTEN;
+        savegame_done = false;
+        savegame_failed = false;
+    }
+
+    if (async_thread != NULL)
+    {
+        SDL_UnlockMutex(async_mutex);
+    }
+
+    return status;
+}
+
+void M_FlushFileWrites (void)
+{
+    if (async_thread == NULL)
+    {
+        return;
+    }
+
+    SDL_LockMutex(async_mutex);
+
+    while (async_head != NULL || async_busy)
+    {
+        SDL_CondWait(async_cond, async_mutex);
+    }
+
+    SDL_UnlockMutex(async_mutex);
+}
+
+//
+// M_ReadSaveGame
+// Reads savegame written by M_WriteSaveGameAsync or an uncompressed one.
+// Returns NULL if file doesn't exist or can't be inflated.
+//
+
+byte *M_ReadSaveGame (char *name, size_t head, size_t *length)
+{
+    byte *data, *result;
+    size_t file_length, deflated_length, inflated_length;
+
+    M_FlushFileWrites();
+
+    if (!M_FileExists(name))
+    {
+        return NULL;
+    }
+
+    file_length = M_ReadFile(name, &data);
+
+    if (file_length < head + SAVEGAME_MAGIC_SIZE + 4
+    ||  memcmp(data + head, SAVEGAME_MAGIC, SAVEGAME_MAGIC_SIZE) != 0)
+    {
+        // Legacy uncompressed savegame.
+        *length = file_length;
+        return data;
+    }
+
+    inflated_length = data[head + SAVEGAME_MAGIC_SIZE + 0]
+                   | (data[head + SAVEGAME_MAGIC_SIZE + 1] << 8)
+                   | (data[head + SAVEGAME_MAGIC_SIZE + 2] << 16)
+                   | ((size_t) data[head + SAVEGAME_MAGIC_SIZE + 3] << 24);
+
+    deflated_length = file_length - head - SAVEGAME_MAGIC_SIZE - 4;
+
+    // Deflate can't compress better than about 1032:1, a larger length
+    // means the file is damaged. Don't let it make Z_Malloc fail.
+    if (inflated_length > deflated_length * SAVEGAME_MAX_RATIO)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = Z_Malloc(head + inflated_length, PU_STATIC, NULL);
+        memcpy(result, data, head);
+
+        if (tinfl_decompress_mem_to_mem(result + head, inflated_length,
+                                        data + head + SAVEGAME_MAGIC_SIZE + 4,
+                                        deflated_length, 0) != inflated_length)
+        {
+            Z_Free(result);
+            result = NULL;
+        }
+    }
+
+    if (result == NULL)
+    {
+        fprintf(stderr, english_language ?
+                "M_ReadSaveGame: %s is corrupted\n" :
+                "M_ReadSaveGame: файл %s поврежден\n",
+                name);
+        Z_Free(data);
+        return NULL;
+    }
+
+    Z_Free(data);
+
+    *length = head + inflated_length;
+    return result;
+}
+
 //
 // M_ReadFile
 //
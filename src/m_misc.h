@@ -35,6 +35,57 @@
 boolean M_WriteFile(const char *name, void *source, int length);
 boolean M_WriteFileTimeout(const char *name, void *source, int length, int delay);
 int M_ReadFile(char *name, byte **buffer);
+
+/**
+ * Writes the data to a temporary file, syncs it and renames it over the
+ * given file, so the old file is never left truncated. Returns false if
+ * any step failed; the old file is kept then.
+ */
+boolean M_SyncWriteFile(const char *name, const void *data, size_t length);
+
+/**
+ * Writes a copy of the given data to the file on a background thread.
+ * The file is replaced atomically once the data is written and synced.
+ */
+void M_WriteFileAsync(const char *name, const void *source, size_t length);
+
+/**
+ * Same as M_WriteFileAsync, but deflates everything after the first
+ * head bytes, which are kept readable for the save menus.
+ */
+void M_WriteSaveGameAsync(const char *name, const void *source, size_t length,
+                          size_t head);
+
+/**
+ * Reads a savegame written by M_WriteSaveGameAsync or an uncompressed one
+ * into a zone buffer. Returns NULL if the file is missing or corrupted.
+ */
+byte *M_ReadSaveGame(char *name, size_t head, size_t *length);
+
+/**
+ * Removes the file on a background thread, in order with queued writes.
+ */
+void M_RemoveFileAsync(const char *name);
+
+typedef enum
+{
+    SAVEGAME_IDLE,      // nothing written since the last call
+    SAVEGAME_PENDING,   // some savegame writes are not finished yet
+    SAVEGAME_WRITTEN,
+    SAVEGAME_FAILED     // previous files are kept
+} savegame_status_t;
+
+/**
+ * Returns the result of savegame writes queued by M_WriteSaveGameAsync.
+ * Once all of them are finished, the result is returned once, and
+ * SAVEGAME_IDLE after that.
+ */
+savegame_status_t M_GetSaveGameStatus(void);
+
+/**
+ * Waits until all queued background writes and removals are done.
+ */
+void M_FlushFileWrites(void);
 void M_MakeDirectory(char *dir);
 char *M_TempFile(char *s);
 boolean M_FileExists(char *file);
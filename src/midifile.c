@@ -26,6 +26,7 @@
 #include "m_misc.h"
 #include "i_system.h"
 #include "i_swap.h"
+#include "memio.h"
 #include "midifile.h"
 #include "jn.h"
 
@@ -112,11 +113,11 @@ static boolean CheckChunkHeader(chunk_header_t *chunk,
 
 // Read a single byte.  Returns false on error.
 
-static boolean ReadByte(byte *result, FILE *stream)
+static boolean ReadByte(byte *result, MEMFILE *stream)
 {
     int c;
 
-    c = fgetc(stream);
+    c = mem_fgetc(stream);
 
     if (c == EOF)
     {
@@ -135,7 +136,7 @@ static boolean ReadByte(byte *result, FILE *stream)
 
 // Read a variable-length value.
 
-static boolean ReadVariableLength(unsigned int *result, FILE *stream)
+static boolean ReadVariableLength(unsigned int *result, MEMFILE *stream)
 {
     int i;
     byte b = 0;
@@ -173,9 +174,8 @@ static boolean ReadVariableLength(unsigned int *result, FILE *stream)
 
 // Read a byte sequence into the data buffer.
 
-static void *ReadByteSequence(unsigned int num_bytes, FILE *stream)
+static void *ReadByteSequence(unsigned int num_bytes, MEMFILE *stream)
 {
-    unsigned int i;
     byte *result;
 
     // Allocate a buffer. Allocate one extra byte, as malloc(0) is
@@ -191,19 +191,16 @@ static void *ReadByteSequence(unsigned int num_bytes, FILE *stream)
         return NULL;
     }
 
-    // Read the data:
+    // Read the data: [JN] all at once, it's in memory anyway.
 
-    for (i=0; i<num_bytes; ++i)
+    if (num_bytes > 0 && mem_fread(result, num_bytes, 1, stream) != 1)
     {
-        if (!ReadByte(&result[i], stream))
-        {
-            printf(english_language ?
-                            "ReadByteSequence: Error while reading byte %u\n" :
-                            "ReadByteSequence: ошибка чтения байта %u\n",
-                            i);
-            free(result);
-            return NULL;
-        }
+        printf(english_language ?
+                        "ReadByteSequence: Unexpected end of file while reading %u bytes\n" :
+                        "ReadByteSequence: неожиданный конец файла при чтении %u байт\n",
+                        num_bytes);
+        free(result);
+        return NULL;
     }
 
     return result;
@@ -215,7 +212,7 @@ static void *ReadByteSequence(unsigned int num_bytes, FILE *stream)
 
 static boolean ReadChannelEvent(midi_event_t *event,
                                 byte event_type, boolean two_param,
-                                FILE *stream)
+                                MEMFILE *stream)
 {
     byte b = 0;
 
@@ -257,7 +254,7 @@ static boolean ReadChannelEvent(midi_event_t *event,
 // Read sysex event:
 
 static boolean ReadSysExEvent(midi_event_t *event, int event_type,
-                              FILE *stream)
+                              MEMFILE *stream)
 {
     event->event_type = event_type;
 
@@ -286,7 +283,7 @@ static boolean ReadSysExEvent(midi_event_t *event, int event_type,
 
 // Read meta event:
 
-static boolean ReadMetaEvent(midi_event_t *event, FILE *stream)
+static boolean ReadMetaEvent(midi_event_t *event, MEMFILE *stream)
 {
     byte b = 0;
 
@@ -330,7 +327,7 @@ static boolean ReadMetaEvent(midi_event_t *event, FILE *stream)
 }
 
 static boolean ReadEvent(midi_event_t *event, unsigned int *last_event_type,
-                         FILE *stream)
+                         MEMFILE *stream)
 {
     byte event_type = 0;
 
@@ -359,7 +356,7 @@ static boolean ReadEvent(midi_event_t *event, unsigned int *last_event_type,
     {
         event_type = *last_event_type;
 
-        if (fseek(stream, -1, SEEK_CUR) < 0)
+        if (mem_fseek(stream, -1, MEM_SEEK_CUR) < 0)
         {
             printf(english_language ?
                     "ReadEvent: Unable to seek in stream\n" :
@@ -443,12 +440,12 @@ static void FreeEvent(midi_event_t *event)
 
 // Read and check the track chunk header
 
-static boolean ReadTrackHeader(midi_track_t *track, FILE *stream)
+static boolean ReadTrackHeader(midi_track_t *track, MEMFILE *stream)
 {
     size_t records_read;
     chunk_header_t chunk_header;
 
-    records_read = fread(&chunk_header, sizeof(chunk_header_t), 1, stream);
+    records_read = mem_fread(&chunk_header, sizeof(chunk_header_t), 1, stream);
 
     if (records_read < 1)
     {
@@ -465,7 +462,7 @@ static boolean ReadTrackHeader(midi_track_t *track, FILE *stream)
     return true;
 }
 
-static boolean ReadTrack(midi_track_t *track, FILE *stream)
+static boolean ReadTrack(midi_track_t *track, MEMFILE *stream)
 {
     midi_event_t *new_events;
     midi_event_t *event;
@@ -535,7 +532,7 @@ static void FreeTrack(midi_track_t *track)
     free(track->events);
 }
 
-static boolean ReadAllTracks(midi_file_t *file, FILE *stream)
+static boolean ReadAllTracks(midi_file_t *file, MEMFILE *stream)
 {
     unsigned int i;
 
@@ -565,12 +562,12 @@ static boolean ReadAllTracks(midi_file_t *file, FILE *stream)
 
 // Read and check the header chunk.
 
-static boolean ReadFileHeader(midi_file_t *file, FILE *stream)
+static boolean ReadFileHeader(midi_file_t *file, MEMFILE *stream)
 {
     size_t records_read;
     unsigned int format_type;
 
-    records_read = fread(&file->header, sizeof(midi_header_t), 1, stream);
+    records_read = mem_fread(&file->header, sizeof(midi_header_t), 1, stream);
 
     if (records_read < 1)
     {
@@ -619,10 +616,10 @@ void MIDI_FreeFile(midi_file_t *file)
     free(file);
 }
 
-midi_file_t *MIDI_LoadFile(char *filename)
+midi_file_t *MIDI_LoadMemory(void *buf, size_t buflen)
 {
     midi_file_t *file;
-    FILE *stream;
+    MEMFILE *stream;
 
     file = malloc(sizeof(midi_file_t));
 
@@ -636,6 +633,38 @@ midi_file_t *MIDI_LoadFile(char *filename)
     file->buffer = NULL;
     file->buffer_size = 0;
 
+    stream = mem_fopen_read(buf, buflen);
+
+    // Read MIDI file header
+
+    if (!ReadFileHeader(file, stream))
+    {
+        mem_fclose(stream);
+        MIDI_FreeFile(file);
+        return NULL;
+    }
+
+    // Read all tracks:
+
+    if (!ReadAllTracks(file, stream))
+    {
+        mem_fclose(stream);
+        MIDI_FreeFile(file);
+        return NULL;
+    }
+
+    mem_fclose(stream);
+
+    return file;
+}
+
+midi_file_t *MIDI_LoadFile(char *filename)
+{
+    midi_file_t *file;
+    FILE *stream;
+    byte *buf;
+    long length;
+
     // Open file
 
     stream = M_fopen(filename, "rb");
@@ -646,30 +675,27 @@ midi_file_t *MIDI_LoadFile(char *filename)
                 "MIDI_LoadFile: Failed to open '%s'\n" :
                 "MIDI_LoadFile: ошибка открытия '%s'\n",
                 filename);
-        MIDI_FreeFile(file);
         return NULL;
     }
 
-    // Read MIDI file header
+    // [JN] Read the whole file at once and parse it in memory.
 
-    if (!ReadFileHeader(file, stream))
-    {
-        fclose(stream);
-        MIDI_FreeFile(file);
-        return NULL;
-    }
+    length = M_FileLength(stream);
+    buf = malloc(length > 0 ? length : 1);
 
-    // Read all tracks:
-
-    if (!ReadAllTracks(file, stream))
+    if (buf == NULL || fread(buf, 1, length, stream) != length)
     {
         fclose(stream);
-        MIDI_FreeFile(file);
+        free(buf);
         return NULL;
     }
 
     fclose(stream);
 
+    file = MIDI_LoadMemory(buf, length);
+
+    free(buf);
+
     return file;
 }
 
@@ -772,6 +798,161 @@ void MIDI_RestartIterator(midi_track_iter_t *iter)
     iter->position = 0;
 }
 
+// [JN] Converts an event into a flat one. Returns false if the event
+// doesn't matter for playback.
+
+static boolean FlattenEvent(midi_event_t *event, unsigned int time,
+                            midi_flat_event_t *result)
+{
+    result->time = time;
+    result->event_type = event->event_type;
+    result->channel = 0;
+    result->param1 = 0;
+    result->param2 = 0;
+    result->tempo = 0;
+
+    switch (event->event_type)
+    {
+        case MIDI_EVENT_NOTE_OFF:
+        case MIDI_EVENT_NOTE_ON:
+        case MIDI_EVENT_CONTROLLER:
+        case MIDI_EVENT_PROGRAM_CHANGE:
+        case MIDI_EVENT_PITCH_BEND:
+            result->channel = event->data.channel.channel;
+            result->param1 = event->data.channel.param1;
+            result->param2 = event->data.channel.param2;
+            return true;
+
+        case MIDI_EVENT_META:
+            if (event->data.meta.type == MIDI_META_SET_TEMPO
+             && event->data.meta.length == 3)
+            {
+                const byte *data = event->data.meta.data;
+
+                result->param1 = MIDI_META_SET_TEMPO;
+                result->tempo = (data[0] << 16) | (data[1] << 8) | data[2];
+                return true;
+            }
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+midi_flat_song_t *MIDI_FlattenFile(midi_file_t *file)
+{
+    midi_flat_song_t *song;
+    midi_track_t *track;
+    midi_event_t *event;
+    unsigned int *positions;
+    unsigned int *times;
+    unsigned int end_time = 0;
+    unsigned int time;
+    unsigned int i, best;
+
+    song = malloc(sizeof(*song));
+    positions = calloc(file->num_tracks, sizeof(*positions));
+    times = calloc(file->num_tracks, sizeof(*times));
+
+    if (song != NULL)
+    {
+        song->events = malloc((MIDI_NumEvents(file) + 1)
+                              * sizeof(midi_flat_event_t));
+        song->num_events = 0;
+        song->time_division = MIDI_GetFileTimeDivision(file);
+    }
+
+    if (song == NULL || song->events == NULL
+     || positions == NULL || times == NULL)
+    {
+        if (song != NULL)
+        {
+            free(song->events);
+        }
+        free(song);
+        free(positions);
+        free(times);
+        return NULL;
+    }
+
+    // Absolute time of the first event in each track.
+
+    for (i = 0; i < file->num_tracks; ++i)
+    {
+        if (file->tracks[i].num_events > 0)
+        {
+            times[i] = file->tracks[i].events[0].delta_time;
+        }
+    }
+
+    for (;;)
+    {
+        // Take the earliest of the next events of all tracks. Events
+        // at the same time are taken in the order of tracks.
+
+        best = file->num_tracks;
+
+        for (i = 0; i < file->num_tracks; ++i)
+        {
+            if (positions[i] < file->tracks[i].num_events
+             && (best == file->num_tracks || times[i] < times[best]))
+            {
+                best = i;
+            }
+        }
+
+        if (best == file->num_tracks)
+        {
+            break;
+        }
+
+        track = &file->tracks[best];
+        event = &track->events[positions[best]++];
+        time = times[best];
+
+        if (positions[best] < track->num_events)
+        {
+            times[best] += track->events[positions[best]].delta_time;
+        }
+
+        // The song ends when the last of its tracks ends.
+
+        if (event->event_type == MIDI_EVENT_META
+         && event->data.meta.type == MIDI_META_END_OF_TRACK)
+        {
+            end_time = MAX(end_time, time);
+            continue;
+        }
+
+        if (FlattenEvent(event, time, &song->events[song->num_events]))
+        {
+            ++song->num_events;
+        }
+    }
+
+    free(positions);
+    free(times);
+
+    // Finish with a single end of track event.
+
+    song->events[song->num_events].time = end_time;
+    song->events[song->num_events].event_type = MIDI_EVENT_META;
+    song->events[song->num_events].channel = 0;
+    song->events[song->num_events].param1 = MIDI_META_END_OF_TRACK;
+    song->events[song->num_events].param2 = 0;
+    song->events[song->num_events].tempo = 0;
+    ++song->num_events;
+
+    return song;
+}
+
+void MIDI_FreeFlatSong(midi_flat_song_t *song)
+{
+    free(song->events);
+    free(song);
+}
+
 #ifdef TEST
 
 static char *MIDI_EventTypeToString(midi_event_type_t event_type)
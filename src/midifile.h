@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <stddef.h>
+
 
 typedef struct midi_file_s midi_file_t;
 typedef struct midi_track_iter_s midi_track_iter_t;
@@ -132,10 +134,47 @@ typedef struct
     } data;
 } midi_event_t;
 
+// [JN] Event of a song with all of its tracks merged into a single stream,
+// in time order. Only events which matter for playback are kept, and none
+// of them have heap allocated data.
+
+typedef struct
+{
+    // Time since the start of the song, in ticks:
+    unsigned int time;
+
+    // Type of event (midi_event_type_t):
+    byte event_type;
+
+    // Channel number for channel events:
+    byte channel;
+
+    // Parameters for channel events, meta event type for meta events:
+    byte param1;
+    byte param2;
+
+    // New tempo for MIDI_META_SET_TEMPO events:
+    unsigned int tempo;
+} midi_flat_event_t;
+
+typedef struct
+{
+    // Events, the last one is always MIDI_META_END_OF_TRACK:
+    midi_flat_event_t *events;
+    unsigned int num_events;
+
+    // Time division value from the MIDI header:
+    unsigned int time_division;
+} midi_flat_song_t;
+
 // Load a MIDI file.
 
 midi_file_t *MIDI_LoadFile(char *filename);
 
+// [JN] Load a MIDI file from memory. The buffer is not needed after loading.
+
+midi_file_t *MIDI_LoadMemory(void *buf, size_t buflen);
+
 // Free a MIDI file.
 
 void MIDI_FreeFile(midi_file_t *file);
@@ -171,3 +210,12 @@ int MIDI_GetNextEvent(midi_track_iter_t *iter, midi_event_t **event);
 // Reset an iterator to the beginning of a track.
 
 void MIDI_RestartIterator(midi_track_iter_t *iter);
+
+// [JN] Merge all tracks of a MIDI file into a single stream of events.
+// The file is not needed after this.
+
+midi_flat_song_t *MIDI_FlattenFile(midi_file_t *file);
+
+// [JN] Free a merged stream of events.
+
+void MIDI_FreeFlatSong(midi_flat_song_t *song);
@@ -123,6 +123,7 @@ static const char* bkToName[] = {
     "Demo_speed",
     "Suicide",
     "Show_message_list",
+    "Rewind",
 
     // Toggles
     "Toggle_crosshair",
@@ -1187,7 +1188,7 @@ void KeybindsHandler_HandleLine(char* keyName, char *value, size_t valueSize)
     }
 }
 
-void KeybindsHandler_Save(FILE* file, char* sectionName)
+void KeybindsHandler_Save(config_text_t* text, char* sectionName)
 {
     int i;
     bind_descriptor_t* bind;
@@ -1196,7 +1197,7 @@ void KeybindsHandler_Save(FILE* file, char* sectionName)
     {
         if(bind_descriptor[i])
         {
-            fprintf(file, "%s = ", bkToName[i]);
+            M_ConfigPrintf(text, "%s = ", bkToName[i]);
             bind = bind_descriptor[i];
             while(bind)
             {
@@ -1220,12 +1221,12 @@ void KeybindsHandler_Save(FILE* file, char* sectionName)
                         bind = bind->next;
                         continue;
                 }
-                fprintf(file, "\"%c_%s\"", deviceChar, keyString);
+                M_ConfigPrintf(text, "\"%c_%s\"", deviceChar, keyString);
                 if(bind->next != NULL)
-                    fprintf(file, ", ");
+                    M_ConfigPrintf(text, ", ");
                 bind = bind->next;
             }
-            fprintf(file, "\n");
+            M_ConfigPrintf(text, "\n");
         }
     }
 }
@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include "doomtype.h"
 #include "d_event.h"
+#include "m_config.h"
 
 
 typedef enum
@@ -115,6 +116,7 @@ typedef enum
     bk_demo_speed, // [crispy] demo fast-forward
     bk_suicide,
     bk_show_message_list,
+    bk_rewind,
 
     // Toggles
     bk_toggle_crosshair,
@@ -217,6 +219,6 @@ boolean KeybindsHandler_isHandling(char* sectionName);
 
 void KeybindsHandler_HandleLine(char* keyName, char *value, size_t valueSize);
 
-void KeybindsHandler_Save(FILE* file, char* sectionName);
+void KeybindsHandler_Save(config_text_t* text, char* sectionName);
 
 void BK_TraverseBinds(void (*lambda)(bound_key_t key, bind_descriptor_t* bindDescriptor));
@@ -18,6 +18,7 @@
 #include <locale.h>
 #include <SDL_scancode.h>
 #include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
 #include "d_name.h"
 #include "i_video.h"
@@ -37,6 +38,11 @@ int config_version = 0;
 static defaultTracker_t* defaultTrackers;
 static keybindsTracker_t* keybindsTrackers;
 
+// [JN] Trackers are looked up for every line of the "General" section,
+// so they are also chained in a small hash table by name.
+#define TRACKER_HASH_SIZE 64
+static defaultTracker_t* defaultTrackerHash[TRACKER_HASH_SIZE];
+
 void M_RegisterTrackedFields()
 {
     if(config_version == CURRENT_CONFIG_VERSION)
@@ -339,12 +345,17 @@ void M_ApplyMigration()
 
 defaultTracker_t* M_GetDefaultTracker(const char* name)
 {
-    defaultTracker_t* tracker = defaultTrackers;
+    defaultTracker_t* tracker;
+
+    if(defaultTrackers == NULL)
+        return NULL;
+
+    tracker = defaultTrackerHash[M_HashConfigName(name) % TRACKER_HASH_SIZE];
     while(tracker != NULL)
     {
         if(strcmp(tracker->name, name) == 0)
             return tracker;
-        tracker = tracker->next;
+        tracker = tracker->hashNext;
     }
     return NULL;
 }
@@ -431,6 +442,8 @@ static void SetKeyBindingsToTracked(const bound_key_t key, const keybindsTracker
 static void RegisterTrackedDefault(const char* name, const default_type_t type)
 {
     defaultTracker_t* tracker = malloc(sizeof(defaultTracker_t));
+    unsigned int hash;
+
     tracker->name = name;
     tracker->type = type;
     tracker->value.s = NULL;
@@ -441,6 +454,10 @@ static void RegisterTrackedDefault(const char* name, const default_type_t type)
         tracker->next = defaultTrackers;
 
     defaultTrackers = tracker;
+
+    hash = M_HashConfigName(name) % TRACKER_HASH_SIZE;
+    tracker->hashNext = defaultTrackerHash[hash];
+    defaultTrackerHash[hash] = tracker;
 }
 
 static void RegisterTrackedKeybind(const char* keyName)
@@ -474,6 +491,7 @@ static void FreeTrackers(void)
         defaultTrackers = dTracker->next;
         free(dTracker);
     }
+    memset(defaultTrackerHash, 0, sizeof(defaultTrackerHash));
 
     while(keybindsTrackers != NULL)
     {
@@ -46,6 +46,7 @@ extern int config_version;
 typedef struct defaultTracker_s
 {
     struct defaultTracker_s* next;
+    struct defaultTracker_s* hashNext; // Next tracker in the same hash chain
     const char* name;    // Name of the config variable
     default_type_t type; // Type of the variable
     union {
@@ -0,0 +1,430 @@
+//
+// Copyright(C) 2016-2025 Julian Nechaevsky
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Rewind buffer of in-memory savestates.
+//
+//  Only the newest snapshot is kept in full. Every older one is stored
+//  as a delta against the snapshot that followed it: both are XORed
+//  byte by byte (most of the level does not change within a second, so
+//  the result is mostly zeros), and the result is run-length encoded as
+//  pairs of <zero run, literal run> lengths followed by literal bytes.
+//  Stepping back decodes a single delta against the newest snapshot.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rd_rewind.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "jn.h"
+#include "m_argv.h"
+#include "m_misc.h"
+
+
+int rewind_depth = 0;
+int rewind_interval = TICRATE;
+
+typedef struct
+{
+    byte   *data;       // Encoded XOR against the next newer snapshot
+    size_t  length;     // Length of encoded data
+    size_t  rawlength;  // Length of the snapshot it decodes to
+    int     tic;        // Tic the snapshot was taken at
+} rwdelta_t;
+
+// Ring buffer of deltas, oldest first.
+static rwdelta_t *deltas;
+static int capacity;
+static int delta_first;
+static int delta_count;
+static size_t delta_bytes;
+
+// The newest snapshot, stored in full.
+static byte *newest;
+static size_t newest_length;
+static int newest_tic;
+
+// Encoding is done into this buffer, then copied out at exact size.
+static byte *scratch;
+static size_t scratch_size;
+
+// Statistics, printed at exit.
+static unsigned int stat_snapshots;
+static unsigned int stat_restores;
+static uint64_t stat_total_us;
+static uint64_t stat_max_us;
+static uint64_t stat_raw_bytes;
+static uint64_t stat_encoded_bytes;
+static size_t stat_peak_bytes;
+
+
+// -----------------------------------------------------------------------------
+// Delta encoding
+// -----------------------------------------------------------------------------
+
+static size_t PutVarint(byte *p, size_t value)
+{
+    size_t n = 0;
+
+    while (value >= 0x80)
+    {
+        p[n++] = (byte) (value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = (byte) value;
+
+    return n;
+}
+
+static size_t GetVarint(const byte **p)
+{
+    size_t value = 0;
+    int shift = 0;
+    byte b;
+
+    do
+    {
+        b = *(*p)++;
+        value |= (size_t) (b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+
+    return value;
+}
+
+// Byte of "older" XORed with the matching byte of "newer"; the part
+// beyond the end of "newer" is XORed with zeros.
+#define XORBYTE(i) (older[i] ^ ((i) < newerlen ? newer[i] : 0))
+
+static size_t EncodeDelta(const byte *older, size_t olderlen,
+                          const byte *newer, size_t newerlen)
+{
+    // A literal run is only broken by 4 or more zero bytes, which keeps
+    // the output within this bound.
+    const size_t bound = olderlen + olderlen / 8 + 32;
+    size_t i = 0;
+    size_t out = 0;
+    size_t start;
+
+    if (scratch_size < bound)
+    {
+        free(scratch);
+        scratch = malloc(bound);
+        scratch_size = scratch ? bound : 0;
+
+        if (scratch == NULL)
+        {
+            return 0;
+        }
+    }
+
+    while (i < olderlen)
+    {
+        start = i;
+        while (i < olderlen && XORBYTE(i) == 0)
+        {
+            i++;
+        }
+        out += PutVarint(scratch + out, i - start);
+
+        start = i;
+        while (i < olderlen)
+        {
+            if (i + 4 <= olderlen
+            &&  XORBYTE(i) == 0 && XORBYTE(i + 1) == 0
+            &&  XORBYTE(i + 2) == 0 && XORBYTE(i + 3) == 0)
+            {
+                break;
+            }
+            i++;
+        }
+        out += PutVarint(scratch + out, i - start);
+
+        for ( ; start < i ; start++)
+        {
+            scratch[out++] = XORBYTE(start);
+        }
+    }
+
+    return out;
+}
+
+static void DecodeDelta(const rwdelta_t *delta, const byte *newer,
+                        size_t newerlen, byte *out)
+{
+    const byte *p = delta->data;
+    const byte *end = p + delta->length;
+    size_t i = 0;
+    size_t run;
+
+    while (p < end)
+    {
+        for (run = GetVarint(&p) ; run > 0 ; run--, i++)
+        {
+            out[i] = i < newerlen ? newer[i] : 0;
+        }
+        for (run = GetVarint(&p) ; run > 0 ; run--, i++)
+        {
+            out[i] = *p++ ^ (i < newerlen ? newer[i] : 0);
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// Ring buffer
+// -----------------------------------------------------------------------------
+
+static rwdelta_t *DeltaAt(int i)
+{
+    return &deltas[(delta_first + i) % capacity];
+}
+
+static void DropOldest(void)
+{
+    rwdelta_t *delta = DeltaAt(0);
+
+    delta_bytes -= delta->length;
+    free(delta->data);
+    delta->data = NULL;
+    delta_first = (delta_first + 1) % capacity;
+    delta_count--;
+}
+
+// Replaces the newest snapshot by the one preceding it.
+static void StepBack(void)
+{
+    rwdelta_t *delta;
+    byte *older;
+
+    if (delta_count == 0)
+    {
+        free(newest);
+        newest = NULL;
+        return;
+    }
+
+    delta = DeltaAt(delta_count - 1);
+    older = malloc(delta->rawlength);
+
+    if (older == NULL)
+    {
+        RW_Clear();
+        return;
+    }
+
+    DecodeDelta(delta, newest, newest_length, older);
+
+    free(newest);
+    newest = older;
+    newest_length = delta->rawlength;
+    newest_tic = delta->tic;
+
+    delta_bytes -= delta->length;
+    free(delta->data);
+    delta->data = NULL;
+    delta_count--;
+}
+
+void RW_Clear(void)
+{
+    while (delta_count > 0)
+    {
+        DropOldest();
+    }
+
+    delta_first = 0;
+    free(newest);
+    newest = NULL;
+}
+
+
+// -----------------------------------------------------------------------------
+// Snapshots
+// -----------------------------------------------------------------------------
+
+boolean RW_SnapshotDue(int tic)
+{
+    return capacity > 0 && tic > 0
+        && tic % MAX(rewind_interval, 1) == 0;
+}
+
+void RW_Store(const byte *data, size_t length, int tic, uint64_t cost_us)
+{
+    byte *copy;
+
+    if (capacity == 0)
+    {
+        return;
+    }
+
+    // After rewinding, the timeline continues from the restored snapshot,
+    // so everything that was taken later is no longer reachable.
+    while (newest != NULL && newest_tic >= tic)
+    {
+        StepBack();
+    }
+
+    copy = malloc(length);
+
+    if (copy == NULL)
+    {
+        RW_Clear();
+        return;
+    }
+
+    memcpy(copy, data, length);
+
+    if (newest != NULL)
+    {
+        const size_t encoded = EncodeDelta(newest, newest_length, copy, length);
+        rwdelta_t *delta;
+
+        if (delta_count == capacity)
+        {
+            DropOldest();
+        }
+
+        delta = DeltaAt(delta_count);
+        delta->data = encoded ? malloc(encoded) : NULL;
+
+        if (delta->data == NULL)
+        {
+            // Out of memory: keep only the new snapshot.
+            free(copy);
+            RW_Clear();
+            return;
+        }
+
+        memcpy(delta->data, scratch, encoded);
+        delta->length = encoded;
+        delta->rawlength = newest_length;
+        delta->tic = newest_tic;
+        delta_count++;
+        delta_bytes += encoded;
+
+        stat_raw_bytes += newest_length;
+        stat_encoded_bytes += encoded;
+
+        free(newest);
+    }
+
+    newest = copy;
+    newest_length = length;
+    newest_tic = tic;
+
+    stat_snapshots++;
+    stat_total_us += cost_us;
+    stat_max_us = MAX(stat_max_us, cost_us);
+    stat_peak_bytes = MAX(stat_peak_bytes, newest_length + delta_bytes);
+}
+
+boolean RW_Available(void)
+{
+    return newest != NULL;
+}
+
+byte *RW_Restore(int now, size_t *length, int *tic)
+{
+    if (newest == NULL)
+    {
+        return NULL;
+    }
+
+    if (now - newest_tic < MAX(rewind_interval, 1) / 2 && delta_count > 0)
+    {
+        StepBack();
+
+        if (newest == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    stat_restores++;
+    *length = newest_length;
+    *tic = newest_tic;
+
+    return newest;
+}
+
+
+// -----------------------------------------------------------------------------
+// Initialization and statistics
+// -----------------------------------------------------------------------------
+
+static void RW_PrintStats(void)
+{
+    const int interval = MAX(rewind_interval, 1);
+
+    if (stat_snapshots == 0)
+    {
+        return;
+    }
+
+    printf(english_language ?
+           "RW_PrintStats: %u snapshots, %u rewinds.\n" :
+           "RW_PrintStats: %u снимков, %u перемоток.\n",
+           stat_snapshots, stat_restores);
+    printf(english_language ?
+           "  snapshot: %.1f us average, %.1f us max, %.2f us per tic\n" :
+           "  снимок: %.1f мкс в среднем, %.1f мкс макс., %.2f мкс на тик\n",
+           (double) stat_total_us / stat_snapshots, (double) stat_max_us,
+           (double) stat_total_us / stat_snapshots / interval);
+    printf(english_language ?
+           "  memory: %.1f KiB peak, deltas compressed to %.1f%%\n" :
+           "  память: %.1f КиБ в пике, дельты сжаты до %.1f%%\n",
+           stat_peak_bytes / 1024.0,
+           stat_raw_bytes ? 100.0 * stat_encoded_bytes / stat_raw_bytes : 100.0);
+}
+
+void RW_Init(void)
+{
+    int depth = rewind_depth;
+    int p;
+
+    //!
+    // @arg <seconds>
+    // @category game
+    //
+    // Keep in-memory snapshots of the last <seconds> of single player
+    // game, which can be stepped back through with the "Rewind" key.
+    // Default is 30 seconds if no value is given.
+    //
+
+    p = M_CheckParm("-rewind");
+
+    if (p)
+    {
+        depth = (p < myargc - 1 && myargv[p + 1][0] != '-') ?
+                       atoi(myargv[p + 1]) : 30;
+    }
+
+    if (depth > 0)
+    {
+        capacity = MAX(depth * TICRATE / MAX(rewind_interval, 1), 1);
+        deltas = calloc(capacity, sizeof(*deltas));
+
+        if (deltas == NULL)
+        {
+            capacity = 0;
+            return;
+        }
+
+        I_AtExit(RW_PrintStats, true);
+    }
+}
@@ -0,0 +1,70 @@
+//
+// Copyright(C) 2016-2025 Julian Nechaevsky
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Rewind buffer of in-memory savestates.
+//
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "doomtype.h"
+
+/**
+ * Rewind depth in seconds, 0 disables rewinding. Overridden by "-rewind".
+ */
+extern int rewind_depth;
+
+/**
+ * Interval between two snapshots in tics.
+ */
+extern int rewind_interval;
+
+/**
+ * Checks "-rewind" command line parameter and registers statistics output at exit.
+ */
+void RW_Init(void);
+
+/**
+ * Returns true if a snapshot should be taken at given tic.
+ */
+boolean RW_SnapshotDue(int tic);
+
+/**
+ * Stores a serialized game state taken at given tic. Data is copied.
+ * Snapshots taken at the same or a later tic are discarded first.
+ * @param cost_us time spent serializing the state, used for statistics only
+ */
+void RW_Store(const byte *data, size_t length, int tic, uint64_t cost_us);
+
+/**
+ * Returns true if there is a snapshot to rewind to.
+ */
+boolean RW_Available(void);
+
+/**
+ * Steps back to the previous snapshot and returns it. If the newest snapshot was
+ * taken less than half of the interval before "now", one more step back is made,
+ * so repeated presses keep going back in time.
+ * Returned buffer belongs to the rewind buffer and stays valid until next RW_ call.
+ * @param tic receives the tic the snapshot was taken at
+ * @return NULL if there is nothing to rewind to
+ */
+byte *RW_Restore(int now, size_t *length, int *tic);
+
+/**
+ * Drops all snapshots. Called when a new level is entered.
+ */
+void RW_Clear(void);
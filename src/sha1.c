@@ -43,9 +43,33 @@
 #include <string.h>
 #include <assert.h>
 
+#include "SDL_atomic.h"
+
 #include "i_swap.h"
 #include "sha1.h"
 
+// [JN] Hashing of whole blocks may be done by the SHA instructions of
+// the CPU. x86 support is checked at run time, ARMv8 support is only
+// used when the compiler targets it anyway.
+
+#if (defined(__x86_64__) || defined(__i386__)) \
+ && (defined(__GNUC__) || defined(__clang__))
+#define SHA1_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) \
+ && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#define SHA1_ARM
+#include <arm_neon.h>
+#endif
+
+typedef void (*sha1_transform_t)(sha1_context_t *hd, const byte *data,
+                                 size_t nblocks);
+
+static sha1_transform_t SelectTransform(void);
+
 void SHA1_Init(sha1_context_t *hd)
 {
     hd->h0 = 0x67452301;
@@ -55,13 +79,14 @@ void SHA1_Init(sha1_context_t *hd)
     hd->h4 = 0xc3d2e1f0;
     hd->nblocks = 0;
     hd->count = 0;
+    hd->transform = SelectTransform();
 }
 
 
 /****************
  * Transform the message X which consists of 16 32-bit-words
  */
-static void Transform(sha1_context_t *hd, byte *data)
+static void Transform(sha1_context_t *hd, const byte *data)
 {
     uint32_t a,b,c,d,e,tm;
     uint32_t x[16];
@@ -200,6 +225,227 @@ static void Transform(sha1_context_t *hd, byte *data)
     hd->h4 += e;
 }
 
+static void TransformGeneric(sha1_context_t *hd, const byte *data,
+                             size_t nblocks)
+{
+    for ( ; nblocks > 0 ; nblocks--, data += 64)
+    {
+        Transform(hd, data);
+    }
+}
+
+#ifdef SHA1_X86
+
+// Four rounds per instruction. The message schedule is kept as four
+// vectors of four words, W[i & 3] holding words 4*i .. 4*i+3 with the
+// first word in the highest lane.
+
+#define X86_SCHEDULE(i)                                                 \
+    W[(i) & 3] = _mm_sha1msg2_epu32(                                    \
+                 _mm_xor_si128(_mm_sha1msg1_epu32(W[(i) & 3],           \
+                                                  W[((i) + 1) & 3]),    \
+                               W[((i) + 2) & 3]),                       \
+                 W[((i) + 3) & 3])
+
+#define X86_ROUNDS(i, f)                                                \
+    E = _mm_sha1nexte_epu32(prev, W[(i) & 3]);                          \
+    prev = abcd;                                                        \
+    abcd = _mm_sha1rnds4_epu32(abcd, E, f)
+
+__attribute__((target("sha,ssse3,sse4.1")))
+static void TransformX86(sha1_context_t *hd, const byte *data,
+                         size_t nblocks)
+{
+    const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL,
+                                        0x08090a0b0c0d0e0fULL);
+    __m128i abcd, abcd_saved, e0, e0_saved, E, prev;
+    __m128i W[4];
+    int i;
+
+    abcd = _mm_set_epi32(hd->h0, hd->h1, hd->h2, hd->h3);
+    e0 = _mm_set_epi32(hd->h4, 0, 0, 0);
+
+    for ( ; nblocks > 0 ; nblocks--, data += 64)
+    {
+        abcd_saved = abcd;
+        e0_saved = e0;
+
+        for (i = 0 ; i < 4 ; i++)
+        {
+            W[i] = _mm_shuffle_epi8(
+                   _mm_loadu_si128((const __m128i *) (data + i * 16)), mask);
+        }
+
+        E = _mm_add_epi32(e0, W[0]);
+        prev = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, E, 0);
+
+        X86_ROUNDS(1, 0);
+        X86_ROUNDS(2, 0);
+        X86_ROUNDS(3, 0);
+        X86_SCHEDULE(4);  X86_ROUNDS(4, 0);
+        X86_SCHEDULE(5);  X86_ROUNDS(5, 1);
+        X86_SCHEDULE(6);  X86_ROUNDS(6, 1);
+        X86_SCHEDULE(7);  X86_ROUNDS(7, 1);
+        X86_SCHEDULE(8);  X86_ROUNDS(8, 1);
+        X86_SCHEDULE(9);  X86_ROUNDS(9, 1);
+        X86_SCHEDULE(10); X86_ROUNDS(10, 2);
+        X86_SCHEDULE(11); X86_ROUNDS(11, 2);
+        X86_SCHEDULE(12); X86_ROUNDS(12, 2);
+        X86_SCHEDULE(13); X86_ROUNDS(13, 2);
+        X86_SCHEDULE(14); X86_ROUNDS(14, 2);
+        X86_SCHEDULE(15); X86_ROUNDS(15, 3);
+        X86_SCHEDULE(16); X86_ROUNDS(16, 3);
+        X86_SCHEDULE(17); X86_ROUNDS(17, 3);
+        X86_SCHEDULE(18); X86_ROUNDS(18, 3);
+        X86_SCHEDULE(19); X86_ROUNDS(19, 3);
+
+        e0 = _mm_sha1nexte_epu32(prev, e0_saved);
+        abcd = _mm_add_epi32(abcd, abcd_saved);
+    }
+
+    hd->h0 = _mm_extract_epi32(abcd, 3);
+    hd->h1 = _mm_extract_epi32(abcd, 2);
+    hd->h2 = _mm_extract_epi32(abcd, 1);
+    hd->h3 = _mm_extract_epi32(abcd, 0);
+    hd->h4 = _mm_extract_epi32(e0, 3);
+}
+
+#undef X86_SCHEDULE
+#undef X86_ROUNDS
+
+static boolean CheckX86SHA(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid_max(0, NULL) < 7)
+    {
+        return false;
+    }
+
+    __cpuid(1, eax, ebx, ecx, edx);
+
+    if ((ecx & bit_SSSE3) == 0 || (ecx & bit_SSE4_1) == 0)
+    {
+        return false;
+    }
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+    return (ebx & (1 << 29)) != 0;
+}
+
+// [JN] Hashing is done from several threads, so the CPUID result is
+// kept in an atomic: 0 until checked, then 1 if absent, 2 if present.
+// Threads checking at the same time all store the same value.
+
+static boolean HaveX86SHA(void)
+{
+    static SDL_atomic_t have_sha;
+    int state = SDL_AtomicGet(&have_sha);
+
+    if (state == 0)
+    {
+        state = CheckX86SHA() ? 2 : 1;
+        SDL_AtomicSet(&have_sha, state);
+    }
+
+    return state == 2;
+}
+
+#endif
+
+#ifdef SHA1_ARM
+
+// Same layout as on x86, but with the first word in the lowest lane.
+
+#define ARM_SCHEDULE(i)                                                 \
+    W[(i) & 3] = vsha1su1q_u32(vsha1su0q_u32(W[(i) & 3],                \
+                                             W[((i) + 1) & 3],          \
+                                             W[((i) + 2) & 3]),         \
+                               W[((i) + 3) & 3])
+
+#define ARM_ROUNDS(i, op, k)                                            \
+    e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));                           \
+    abcd = op(abcd, e0, vaddq_u32(W[(i) & 3], vdupq_n_u32(k)));         \
+    e0 = e1
+
+static void TransformARM(sha1_context_t *hd, const byte *data,
+                         size_t nblocks)
+{
+    uint32x4_t abcd, abcd_saved;
+    uint32x4_t W[4];
+    uint32_t e0, e0_saved, e1;
+    int i;
+
+    abcd = vsetq_lane_u32(hd->h0, vdupq_n_u32(0), 0);
+    abcd = vsetq_lane_u32(hd->h1, abcd, 1);
+    abcd = vsetq_lane_u32(hd->h2, abcd, 2);
+    abcd = vsetq_lane_u32(hd->h3, abcd, 3);
+    e0 = hd->h4;
+
+    for ( ; nblocks > 0 ; nblocks--, data += 64)
+    {
+        abcd_saved = abcd;
+        e0_saved = e0;
+
+        for (i = 0 ; i < 4 ; i++)
+        {
+            W[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + i * 16)));
+        }
+
+        ARM_ROUNDS(0, vsha1cq_u32, K1);
+        ARM_ROUNDS(1, vsha1cq_u32, K1);
+        ARM_ROUNDS(2, vsha1cq_u32, K1);
+        ARM_ROUNDS(3, vsha1cq_u32, K1);
+        ARM_SCHEDULE(4);  ARM_ROUNDS(4, vsha1cq_u32, K1);
+        ARM_SCHEDULE(5);  ARM_ROUNDS(5, vsha1pq_u32, K2);
+        ARM_SCHEDULE(6);  ARM_ROUNDS(6, vsha1pq_u32, K2);
+        ARM_SCHEDULE(7);  ARM_ROUNDS(7, vsha1pq_u32, K2);
+        ARM_SCHEDULE(8);  ARM_ROUNDS(8, vsha1pq_u32, K2);
+        ARM_SCHEDULE(9);  ARM_ROUNDS(9, vsha1pq_u32, K2);
+        ARM_SCHEDULE(10); ARM_ROUNDS(10, vsha1mq_u32, K3);
+        ARM_SCHEDULE(11); ARM_ROUNDS(11, vsha1mq_u32, K3);
+        ARM_SCHEDULE(12); ARM_ROUNDS(12, vsha1mq_u32, K3);
+        ARM_SCHEDULE(13); ARM_ROUNDS(13, vsha1mq_u32, K3);
+        ARM_SCHEDULE(14); ARM_ROUNDS(14, vsha1mq_u32, K3);
+        ARM_SCHEDULE(15); ARM_ROUNDS(15, vsha1pq_u32, K4);
+        ARM_SCHEDULE(16); ARM_ROUNDS(16, vsha1pq_u32, K4);
+        ARM_SCHEDULE(17); ARM_ROUNDS(17, vsha1pq_u32, K4);
+        ARM_SCHEDULE(18); ARM_ROUNDS(18, vsha1pq_u32, K4);
+        ARM_SCHEDULE(19); ARM_ROUNDS(19, vsha1pq_u32, K4);
+
+        abcd = vaddq_u32(abcd, abcd_saved);
+        e0 += e0_saved;
+    }
+
+    hd->h0 = vgetq_lane_u32(abcd, 0);
+    hd->h1 = vgetq_lane_u32(abcd, 1);
+    hd->h2 = vgetq_lane_u32(abcd, 2);
+    hd->h3 = vgetq_lane_u32(abcd, 3);
+    hd->h4 = e0;
+}
+
+#undef ARM_SCHEDULE
+#undef ARM_ROUNDS
+
+#endif
+
+static sha1_transform_t SelectTransform(void)
+{
+#ifdef SHA1_X86
+    if (HaveX86SHA())
+    {
+        return TransformX86;
+    }
+#endif
+#ifdef SHA1_ARM
+    return TransformARM;
+#endif
+
+    return TransformGeneric;
+}
+
 
 /* Update the message digest with the contents
  * of INBUF with length INLEN.
@@ -209,7 +455,7 @@ void SHA1_Update(sha1_context_t *hd, byte *inbuf, size_t inlen)
     if (hd->count == 64)
     {
         /* flush the buffer */
-	Transform(hd, hd->buf);
+	hd->transform(hd, hd->buf, 1);
 	hd->count = 0;
 	hd->nblocks++;
     }
@@ -224,13 +470,15 @@ void SHA1_Update(sha1_context_t *hd, byte *inbuf, size_t inlen)
 	    return;
     }
 
-    while (inlen >= 64)
+    if (inlen >= 64)
     {
-	Transform(hd, inbuf);
+	const size_t nblocks = inlen / 64;
+
+	hd->transform(hd, inbuf, nblocks);
 	hd->count = 0;
-	hd->nblocks++;
-	inlen -= 64;
-	inbuf += 64;
+	hd->nblocks += nblocks;
+	inlen -= nblocks * 64;
+	inbuf += nblocks * 64;
     }
     for (; inlen && hd->count < 64; inlen--)
 	hd->buf[hd->count++] = *inbuf++;
@@ -290,7 +538,7 @@ void SHA1_Final(sha1_digest_t digest, sha1_context_t *hd)
     hd->buf[61] = lsb >> 16;
     hd->buf[62] = lsb >>  8;
     hd->buf[63] = lsb	   ;
-    Transform(hd, hd->buf);
+    hd->transform(hd, hd->buf, 1);
 
     p = hd->buf;
 #ifdef SYS_BIG_ENDIAN
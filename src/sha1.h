@@ -31,6 +31,8 @@ struct sha1_context_s {
     uint32_t nblocks;
     byte buf[64];
     int count;
+    // [JN] Block transform, chosen by SHA1_Init for this CPU.
+    void (*transform)(sha1_context_t *hd, const byte *data, size_t nblocks);
 };
 
 void SHA1_Init(sha1_context_t *context);
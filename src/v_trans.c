@@ -16,9 +16,22 @@
 //
 
 
+#include <limits.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
 #include "d_name.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_config.h"
+#include "m_misc.h"
+#include "sha1.h"
 #include "v_trans.h"
+#include "jn.h"
 
 
 // -----------------------------------------------------------------------------
@@ -731,7 +744,7 @@ static void rgb_to_hsv(vect *rgb, vect *hsv)
 
  
 // [crispy] copied over from i_video.c
-int V_GetPaletteIndex(byte *palette, int r, int g, int b)
+int V_GetPaletteIndex(const byte *palette, int r, int g, int b)
 {
     int best, best_diff, diff;
     int i;
@@ -972,3 +985,446 @@ byte V_Colorize (byte *playpal, Translation_CR_t cr, byte source, boolean keepgr
 
     return V_GetPaletteIndex(playpal, (int) rgb.x, (int) rgb.y, (int) rgb.z);
 }
+
+
+// -----------------------------------------------------------------------------
+// [JN] Nearest color lookup.
+//
+//  RGB space is split into a grid of cells, 8 values wide on each side.
+//  For every cell, only palette colors that may be the nearest one to some
+//  point of the cell are kept as candidates: those whose distance to the
+//  cell is not above the farthest distance of the best color. Cells are
+//  filled in when first used, so a lookup only costs for the colors that
+//  are actually looked up. Candidates are kept in palette order, so ties
+//  are resolved the same way as by V_GetPaletteIndex.
+// -----------------------------------------------------------------------------
+
+#define LOOKUP_BITS     5
+#define LOOKUP_SIZE     (1 << LOOKUP_BITS)
+#define LOOKUP_SHIFT    (8 - LOOKUP_BITS)
+#define LOOKUP_CELLS    (LOOKUP_SIZE * LOOKUP_SIZE * LOOKUP_SIZE)
+#define LOOKUP_CHUNK    65536
+
+typedef struct lookup_chunk_s
+{
+    struct lookup_chunk_s *next;
+    int used;
+    byte data[LOOKUP_CHUNK];
+} lookup_chunk_t;
+
+struct palette_lookup_s
+{
+    byte palette[256 * 3];
+    const byte *candidates[LOOKUP_CELLS];   // NULL if not filled in yet
+    short num_candidates[LOOKUP_CELLS];
+    lookup_chunk_t *chunks;
+};
+
+// Used for a cell if there is no memory for its own list.
+static const byte all_colors[256] = {
+#define C4(n) n, n + 1, n + 2, n + 3
+#define C16(n) C4(n), C4(n + 4), C4(n + 8), C4(n + 12)
+#define C64(n) C16(n), C16(n + 16), C16(n + 32), C16(n + 48)
+    C64(0), C64(64), C64(128), C64(192)
+#undef C64
+#undef C16
+#undef C4
+};
+
+palette_lookup_t *V_CreatePaletteLookup(const byte *palette)
+{
+    palette_lookup_t *lookup = calloc(1, sizeof(*lookup));
+
+    if (lookup != NULL)
+    {
+        memcpy(lookup->palette, palette, sizeof(lookup->palette));
+    }
+
+    return lookup;
+}
+
+void V_FreePaletteLookup(palette_lookup_t *lookup)
+{
+    lookup_chunk_t *chunk, *next;
+
+    if (lookup == NULL)
+    {
+        return;
+    }
+
+    for (chunk = lookup->chunks ; chunk != NULL ; chunk = next)
+    {
+        next = chunk->next;
+        free(chunk);
+    }
+
+    free(lookup);
+}
+
+// Squared distances from a value to the nearest and farthest values
+// of the range [lo, hi].
+
+static int NearDistance(int c, int lo, int hi)
+{
+    const int d = c < lo ? lo - c : c > hi ? c - hi : 0;
+
+    return d * d;
+}
+
+static int FarDistance(int c, int lo, int hi)
+{
+    const int d = MAX(abs(c - lo), abs(c - hi));
+
+    return d * d;
+}
+
+static void FillCell(palette_lookup_t *lookup, int cell)
+{
+    const int r0 = (cell >> (2 * LOOKUP_BITS)) << LOOKUP_SHIFT;
+    const int g0 = ((cell >> LOOKUP_BITS) & (LOOKUP_SIZE - 1)) << LOOKUP_SHIFT;
+    const int b0 = (cell & (LOOKUP_SIZE - 1)) << LOOKUP_SHIFT;
+    const int width = (1 << LOOKUP_SHIFT) - 1;
+    const byte *pal = lookup->palette;
+    int neardist[256];
+    int bound = INT_MAX;
+    byte list[256];
+    int count = 0;
+    lookup_chunk_t *chunk;
+    int i;
+
+    for (i = 0 ; i < 256 ; i++, pal += 3)
+    {
+        neardist[i] = NearDistance(pal[0], r0, r0 + width)
+                    + NearDistance(pal[1], g0, g0 + width)
+                    + NearDistance(pal[2], b0, b0 + width);
+
+        bound = MIN(bound, FarDistance(pal[0], r0, r0 + width)
+                         + FarDistance(pal[1], g0, g0 + width)
+                         + FarDistance(pal[2], b0, b0 + width));
+    }
+
+    for (i = 0 ; i < 256 ; i++)
+    {
+        if (neardist[i] <= bound)
+        {
+            list[count++] = i;
+        }
+    }
+
+    chunk = lookup->chunks;
+
+    if (chunk == NULL || chunk->used + count > LOOKUP_CHUNK)
+    {
+        chunk = malloc(sizeof(*chunk));
+
+        if (chunk == NULL)
+        {
+            lookup->candidates[cell] = all_colors;
+            lookup->num_candidates[cell] = 256;
+            return;
+        }
+
+        chunk->next = lookup->chunks;
+        chunk->used = 0;
+        lookup->chunks = chunk;
+    }
+
+    memcpy(chunk->data + chunk->used, list, count);
+    lookup->candidates[cell] = chunk->data + chunk->used;
+    lookup->num_candidates[cell] = count;
+    chunk->used += count;
+}
+
+void V_LookupPaletteIndexes(palette_lookup_t *lookup, const byte *rgb,
+                            byte *out, int count)
+{
+    const byte *pal = lookup->palette;
+    int n;
+
+    for (n = 0 ; n < count ; n++, rgb += 3)
+    {
+        const int r = rgb[0], g = rgb[1], b = rgb[2];
+        const int cell = ((r >> LOOKUP_SHIFT) << (2 * LOOKUP_BITS))
+                       | ((g >> LOOKUP_SHIFT) << LOOKUP_BITS)
+                       |  (b >> LOOKUP_SHIFT);
+        const byte *cand;
+        int best, best_diff, diff;
+        int i, num;
+
+        if (lookup->candidates[cell] == NULL)
+        {
+            FillCell(lookup, cell);
+        }
+
+        cand = lookup->candidates[cell];
+        num = lookup->num_candidates[cell];
+        best = cand[0];
+        best_diff = INT_MAX;
+
+        for (i = 0 ; i < num ; i++)
+        {
+            const byte *c = pal + 3 * cand[i];
+
+            diff = (r - c[0]) * (r - c[0])
+                 + (g - c[1]) * (g - c[1])
+                 + (b - c[2]) * (b - c[2]);
+
+            if (diff < best_diff)
+            {
+                best = cand[i];
+                best_diff = diff;
+
+                if (diff == 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        out[n] = best;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// [JN] Translucency tables for modified palettes.
+//
+//  Making the tables takes 9 * 256 * 256 nearest color searches, which
+//  is noticeable at startup even with the lookup grid. Rows of
+//  background colors are split between threads, and the result is
+//  stored in "palcache" next to the config file, named after the SHA-1
+//  of the palette. Next launch with the same palette only reads the
+//  file.
+// -----------------------------------------------------------------------------
+
+#define TRANS_TABLE_SIZE    (256 * 256)
+#define TRANS_CACHE_MAGIC   "RDTRANS1"
+#define TRANS_MAX_THREADS   16
+
+// Statistics, printed at exit.
+static boolean stats_registered;
+static boolean stat_trans_cached;
+static uint64_t stat_trans_us;
+
+typedef struct
+{
+    const byte *playpal;
+    byte **tables;
+    int first_row;
+    int last_row;
+} transjob_t;
+
+static int MakeTransRows(void *data)
+{
+    const transjob_t *job = data;
+    const byte *playpal = job->playpal;
+    palette_lookup_t *lookup = V_CreatePaletteLookup(playpal);
+    byte blend[256 * 3];
+    int i, j, t;
+
+    // [crispy] background color
+    for (i = job->first_row ; i < job->last_row ; i++)
+    {
+        const byte *bg = playpal + 3 * i;
+
+        for (t = 0 ; t < TRANS_TABLES ; t++)
+        {
+            const int alpha = (t + 1) * 10;
+            byte *row = job->tables[t] + i * 256;
+
+            // [crispy] foreground color
+            for (j = 0 ; j < 256 * 3 ; j++)
+            {
+                blend[j] = (alpha * playpal[j] + (100 - alpha) * bg[j % 3]) / 100;
+            }
+
+            if (lookup != NULL)
+            {
+                V_LookupPaletteIndexes(lookup, blend, row, 256);
+            }
+            else
+            {
+                for (j = 0 ; j < 256 ; j++)
+                {
+                    row[j] = V_GetPaletteIndex(playpal, blend[3 * j],
+                                               blend[3 * j + 1],
+                                               blend[3 * j + 2]);
+                }
+            }
+
+            // [crispy] shortcut: identical foreground and background
+            row[i] = i;
+        }
+    }
+
+    V_FreePaletteLookup(lookup);
+
+    return 0;
+}
+
+static void MakeTransTables(const byte *playpal, byte **tables)
+{
+    SDL_Thread *threads[TRANS_MAX_THREADS];
+    transjob_t jobs[TRANS_MAX_THREADS];
+    const int numjobs = BETWEEN(1, TRANS_MAX_THREADS, SDL_GetCPUCount());
+    int i;
+
+    for (i = 0 ; i < numjobs ; i++)
+    {
+        jobs[i].playpal = playpal;
+        jobs[i].tables = tables;
+        jobs[i].first_row = 256 * i / numjobs;
+        jobs[i].last_row = 256 * (i + 1) / numjobs;
+    }
+
+    // The first job is done on this thread, as are jobs whose
+    // thread could not be created.
+
+    for (i = 1 ; i < numjobs ; i++)
+    {
+        threads[i] = SDL_CreateThread(MakeTransRows, "Trans tables", &jobs[i]);
+
+        if (threads[i] == NULL)
+        {
+            MakeTransRows(&jobs[i]);
+        }
+    }
+
+    MakeTransRows(&jobs[0]);
+
+    for (i = 1 ; i < numjobs ; i++)
+    {
+        if (threads[i] != NULL)
+        {
+            SDL_WaitThread(threads[i], NULL);
+        }
+    }
+}
+
+static char *TransCachePath(const byte *playpal)
+{
+    sha1_context_t context;
+    sha1_digest_t digest;
+    char hex[sizeof(digest) * 2 + 1];
+    char *dir, *path;
+    int i;
+
+    SHA1_Init(&context);
+    SHA1_Update(&context, (byte *) playpal, 256 * 3);
+    SHA1_Final(digest, &context);
+
+    for (i = 0 ; i < sizeof(digest) ; ++i)
+    {
+        M_snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    }
+
+    dir = M_GetPaletteCacheDir();
+    M_MakeDirectory(dir);
+    path = M_StringJoin(dir, DIR_SEPARATOR_S, hex, ".tr", NULL);
+    free(dir);
+
+    return path;
+}
+
+static boolean TransCacheLoad(const char *path, byte **tables)
+{
+    char magic[sizeof(TRANS_CACHE_MAGIC) - 1];
+    FILE *file;
+    boolean result;
+    int i;
+
+    file = M_fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    result = fread(magic, sizeof(magic), 1, file) == 1
+          && memcmp(magic, TRANS_CACHE_MAGIC, sizeof(magic)) == 0;
+
+    for (i = 0 ; result && i < TRANS_TABLES ; i++)
+    {
+        result = fread(tables[i], TRANS_TABLE_SIZE, 1, file) == 1;
+    }
+
+    fclose(file);
+
+    return result;
+}
+
+static void TransCacheStore(const char *path, byte **tables)
+{
+    char *temp_path;
+    FILE *file;
+    boolean result;
+    int i;
+
+    temp_path = M_StringJoin(path, ".tmp", NULL);
+    file = M_fopen(temp_path, "wb");
+
+    if (file == NULL)
+    {
+        free(temp_path);
+        return;
+    }
+
+    result = fwrite(TRANS_CACHE_MAGIC, sizeof(TRANS_CACHE_MAGIC) - 1, 1, file) == 1;
+
+    for (i = 0 ; result && i < TRANS_TABLES ; i++)
+    {
+        result = fwrite(tables[i], TRANS_TABLE_SIZE, 1, file) == 1;
+    }
+
+    result = fclose(file) == 0 && result;
+
+    if (result)
+    {
+#ifdef _WIN32
+        M_remove(path);
+#endif
+        M_rename(temp_path, path);
+    }
+    else
+    {
+        M_remove(temp_path);
+    }
+
+    free(temp_path);
+}
+
+static void V_PrintTransStats(void)
+{
+    printf(english_language ?
+           "V_PrintTransStats: translucency tables %s in %.1f ms.\n" :
+           "V_PrintTransStats: таблицы прозрачности %s за %.1f мс.\n",
+           english_language ?
+           (stat_trans_cached ? "loaded from cache" : "generated") :
+           (stat_trans_cached ? "загружены из кэша" : "сгенерированы"),
+           stat_trans_us / 1000.0);
+}
+
+void V_InitTransTables(const byte *playpal, byte **tables)
+{
+    const uint64_t start = I_GetTimeUS();
+    char *path = TransCachePath(playpal);
+
+    stat_trans_cached = TransCacheLoad(path, tables);
+
+    if (!stat_trans_cached)
+    {
+        MakeTransTables(playpal, tables);
+        TransCacheStore(path, tables);
+    }
+
+    free(path);
+
+    // Printed at exit, so the startup progress line is left alone.
+    stat_trans_us = I_GetTimeUS() - start;
+
+    if (!stats_registered)
+    {
+        I_AtExit(V_PrintTransStats, true);
+        stats_registered = true;
+    }
+}
@@ -113,5 +113,28 @@ extern char **crstr;
 
 #define cr_esc '~'
 
-int V_GetPaletteIndex(byte *palette, int r, int g, int b);
+int V_GetPaletteIndex(const byte *palette, int r, int g, int b);
 byte V_Colorize (byte *playpal, Translation_CR_t cr, byte source, boolean keepgray109);
+
+// [JN] Nearest color lookup for one palette. Gives the same results as
+// V_GetPaletteIndex, but only checks the few colors that may be nearest
+// to the looked up one. Not to be shared between threads.
+typedef struct palette_lookup_s palette_lookup_t;
+
+// [JN] Returns NULL if out of memory. The palette is copied.
+palette_lookup_t *V_CreatePaletteLookup(const byte *palette);
+void V_FreePaletteLookup(palette_lookup_t *lookup);
+
+// [JN] Maps "count" RGB triplets to palette indexes.
+void V_LookupPaletteIndexes(palette_lookup_t *lookup, const byte *rgb,
+                            byte *out, int count);
+
+// [JN] Number of translucency tables made by V_InitTransTables,
+// for 10% up to 90% of foreground color.
+#define TRANS_TABLES 9
+
+// [JN] Makes translucency tables for a modified palette. tables[0] is for
+// 10% of foreground color, tables[8] for 90%. Each table is indexed by
+// background * 256 + foreground and must be 256*256 bytes. Tables are
+// made on all CPU cores and kept in a disk cache, keyed by the palette.
+void V_InitTransTables(const byte *playpal, byte **tables);
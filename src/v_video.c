@@ -22,6 +22,7 @@
 //
 
 
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
@@ -187,6 +188,444 @@ void V_SetPatchClipCallback(vpatchclipfunc_t func)
     patchclip_callback = func;
 }
 
+// -----------------------------------------------------------------------------
+// [JN] Pre-scaled patch cache.
+//
+// Menus, status bar and HUD text are redrawn every frame, and each call walks
+// patch posts and scales every pixel by hand. Instead, a patch is expanded to
+// the current scale once and kept as runs of opaque (or shadow) pixels for
+// each source row, so drawing becomes a memcpy per run and screen row.
+// Entries are keyed by patch address. The zone allocation number and the
+// patch header are kept along to notice when a purged PU_CACHE lump has
+// been replaced with another one at the same address. Patches outside of
+// the zone are read from mapped WAD files and don't move.
+// -----------------------------------------------------------------------------
+
+#define PATCHCACHE_HASHSIZE 512
+#define PATCHCACHE_BUDGET   (8 * 1024 * 1024)
+
+enum
+{
+    PCSPAN_PATCH = 1,
+    PCSPAN_SHADOW
+};
+
+typedef struct
+{
+    short x;        // first column, in source pixels
+    short length;   // length, in source pixels
+    byte  kind;     // PCSPAN_PATCH or PCSPAN_SHADOW
+} pcspan_t;
+
+typedef struct patchcache_s
+{
+    const patch_t *patch;
+    const byte    *translation;
+    int            shift;
+    boolean        shadow;
+
+    int            width, height;   // in source pixels, including shadow
+    int            rowbytes;        // width << shift
+    byte          *pixels;          // one scaled row per source row
+    int           *rowspans;        // first span of every row, height+1 items
+    pcspan_t      *spans;
+    unsigned int   serial;          // Z_GetSerial of the patch
+    byte           header[8];       // width, height and offsets
+    size_t         size;
+
+    struct patchcache_s *hashnext;
+    struct patchcache_s *prev, *next;   // LRU order, most recent first
+} patchcache_t;
+
+static patchcache_t *patchcache_hash[PATCHCACHE_HASHSIZE];
+static patchcache_t *patchcache_head, *patchcache_tail;
+static size_t patchcache_size;
+
+static unsigned int PatchCacheHash (const patch_t *patch, const byte *translation,
+                                    const int shift, const boolean shadow)
+{
+    uintptr_t key = (uintptr_t) patch >> 3;
+
+    key ^= (uintptr_t) translation >> 8;
+    key ^= (uintptr_t) (shift * 2 + shadow) * 0x9e3779b1u;
+
+    return (unsigned int) (key ^ (key >> 9)) & (PATCHCACHE_HASHSIZE - 1);
+}
+
+static void PatchCacheUnlink (patchcache_t *pc)
+{
+    patchcache_t **link;
+
+    link = &patchcache_hash[PatchCacheHash(pc->patch, pc->translation,
+                                           pc->shift, pc->shadow)];
+    while (*link != pc)
+    {
+        link = &(*link)->hashnext;
+    }
+    *link = pc->hashnext;
+
+    if (pc->prev)
+        pc->prev->next = pc->next;
+    else
+        patchcache_head = pc->next;
+
+    if (pc->next)
+        pc->next->prev = pc->prev;
+    else
+        patchcache_tail = pc->prev;
+}
+
+static void PatchCacheFree (patchcache_t *pc)
+{
+    PatchCacheUnlink(pc);
+    patchcache_size -= pc->size;
+
+    free(pc->pixels);
+    free(pc->rowspans);
+    free(pc->spans);
+    free(pc);
+}
+
+// -----------------------------------------------------------------------------
+// V_FlushPatchCache
+// Drops every pre-scaled patch, must be called when resolution is changed.
+// -----------------------------------------------------------------------------
+
+void V_FlushPatchCache (void)
+{
+    while (patchcache_head)
+    {
+        PatchCacheFree(patchcache_head);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// PatchCacheBuild
+// Expands given patch to 1 << shift scale. Returns NULL if patch
+// is malformed or too big to be worth caching.
+// -----------------------------------------------------------------------------
+
+static patchcache_t *PatchCacheBuild (const patch_t *patch, const byte *translation,
+                                      const int shift, const boolean shadow)
+{
+    const int w = SHORT(patch->width);
+    const column_t *column;
+    patchcache_t *pc;
+    byte *kinds, *colors;
+    int h, cw, ch;
+    int col, row, numspans;
+    size_t size;
+
+    if (w <= 0 || w > ORIGWIDTH * 4)
+    {
+        return NULL;
+    }
+
+    // Find out real height.
+    h = 0;
+
+    for (col = 0 ; col < w ; col++)
+    {
+        const int ofs = LONG(patch->columnofs[col]);
+
+        column = (const column_t *) ((const byte *) patch + ofs);
+
+        while (column->topdelta != 0xff)
+        {
+            h = MAX(h, column->topdelta + column->length);
+            column = (const column_t *) ((const byte *) column + column->length + 4);
+        }
+    }
+
+    if (h == 0)
+    {
+        return NULL;
+    }
+
+    cw = w + shadow;
+    ch = h + shadow;
+
+    size = sizeof(*pc) + (size_t) (cw << shift) * ch
+         + (ch + 1) * sizeof(int);
+
+    if (size > PATCHCACHE_BUDGET / 4)
+    {
+        return NULL;
+    }
+
+    // Compose patch and its shadow in source pixels first.
+    // Patch pixels always win over shadow, just like drawing
+    // shadow before the next column does.
+    kinds = calloc(cw * ch, 1);
+    colors = calloc(cw * ch, 1);
+    pc = calloc(1, sizeof(*pc));
+
+    if (kinds == NULL || colors == NULL || pc == NULL)
+    {
+        free(kinds);
+        free(colors);
+        free(pc);
+        return NULL;
+    }
+
+    for (col = 0 ; col < w ; col++)
+    {
+        column = (const column_t *) ((const byte *) patch + LONG(patch->columnofs[col]));
+
+        while (column->topdelta != 0xff)
+        {
+            const byte *source = (const byte *) column + 3;
+            int i;
+
+            for (i = 0 ; i < column->length ; i++)
+            {
+                const int pos = (column->topdelta + i) * cw + col;
+
+                kinds[pos] = PCSPAN_PATCH;
+                colors[pos] = translation ? translation[source[i]] : source[i];
+
+                if (shadow && !kinds[pos + cw + 1])
+                {
+                    kinds[pos + cw + 1] = PCSPAN_SHADOW;
+                }
+            }
+
+            column = (const column_t *) ((const byte *) column + column->length + 4);
+        }
+    }
+
+    pc->patch = patch;
+    pc->translation = translation;
+    pc->shift = shift;
+    pc->shadow = shadow;
+    pc->width = cw;
+    pc->height = ch;
+    pc->rowbytes = cw << shift;
+    pc->pixels = malloc(pc->rowbytes * ch);
+    pc->rowspans = malloc((ch + 1) * sizeof(*pc->rowspans));
+    pc->serial = Z_GetSerial(patch);
+    memcpy(pc->header, patch, sizeof(pc->header));
+
+    // Count runs of the same kind to size span list.
+    numspans = 0;
+
+    for (row = 0 ; row < ch ; row++)
+    {
+        for (col = 0 ; col < cw ; col++)
+        {
+            const byte kind = kinds[row * cw + col];
+
+            if (kind && (col == 0 || kinds[row * cw + col - 1] != kind))
+            {
+                numspans++;
+            }
+        }
+    }
+
+    pc->spans = malloc(MAX(numspans, 1) * sizeof(*pc->spans));
+
+    if (pc->pixels == NULL || pc->rowspans == NULL || pc->spans == NULL)
+    {
+        free(pc->pixels);
+        free(pc->rowspans);
+        free(pc->spans);
+        free(pc);
+        free(kinds);
+        free(colors);
+        return NULL;
+    }
+
+    numspans = 0;
+
+    for (row = 0 ; row < ch ; row++)
+    {
+        const byte *kindrow = kinds + row * cw;
+        const byte *colorrow = colors + row * cw;
+        byte *dest = pc->pixels + row * pc->rowbytes;
+
+        pc->rowspans[row] = numspans;
+
+        for (col = 0 ; col < cw ; col++)
+        {
+            memset(dest + (col << shift), colorrow[col], 1 << shift);
+
+            if (!kindrow[col])
+            {
+                continue;
+            }
+
+            if (col == 0 || kindrow[col - 1] != kindrow[col])
+            {
+                pc->spans[numspans].x = col;
+                pc->spans[numspans].length = 0;
+                pc->spans[numspans].kind = kindrow[col];
+                numspans++;
+            }
+
+            pc->spans[numspans - 1].length++;
+        }
+    }
+
+    pc->rowspans[ch] = numspans;
+    pc->size = size + numspans * sizeof(*pc->spans);
+
+    free(kinds);
+    free(colors);
+
+    return pc;
+}
+
+// -----------------------------------------------------------------------------
+// PatchCacheGet
+// Returns pre-scaled copy of given patch, creating it if needed.
+// -----------------------------------------------------------------------------
+
+static patchcache_t *PatchCacheGet (const patch_t *patch, const byte *translation,
+                                    const int shift, const boolean shadow)
+{
+    const unsigned int hash = PatchCacheHash(patch, translation, shift, shadow);
+    patchcache_t *pc;
+
+    for (pc = patchcache_hash[hash] ; pc != NULL ; pc = pc->hashnext)
+    {
+        if (pc->patch == patch && pc->translation == translation
+        &&  pc->shift == shift && pc->shadow == shadow)
+        {
+            break;
+        }
+    }
+
+    // Lump was purged and something else is placed at the same address.
+    if (pc != NULL && (pc->serial != Z_GetSerial(patch)
+                   ||  memcmp(pc->header, patch, sizeof(pc->header)) != 0))
+    {
+        PatchCacheFree(pc);
+        pc = NULL;
+    }
+
+    if (pc == NULL)
+    {
+        pc = PatchCacheBuild(patch, translation, shift, shadow);
+
+        if (pc == NULL)
+        {
+            return NULL;
+        }
+
+        while (patchcache_tail && patchcache_size + pc->size > PATCHCACHE_BUDGET)
+        {
+            PatchCacheFree(patchcache_tail);
+        }
+
+        pc->hashnext = patchcache_hash[hash];
+        patchcache_hash[hash] = pc;
+        patchcache_size += pc->size;
+    }
+    else if (pc != patchcache_head)
+    {
+        PatchCacheUnlink(pc);
+        pc->hashnext = patchcache_hash[hash];
+        patchcache_hash[hash] = pc;
+    }
+    else
+    {
+        return pc;
+    }
+
+    // Move to the head of LRU list.
+    pc->prev = NULL;
+    pc->next = patchcache_head;
+
+    if (patchcache_head)
+        patchcache_head->prev = pc;
+    else
+        patchcache_tail = pc;
+
+    patchcache_head = pc;
+
+    return pc;
+}
+
+// -----------------------------------------------------------------------------
+// V_BlitCachedPatch
+// Draws pre-scaled patch with top left corner at x, y (in source pixels),
+// clipped to clipw by cliph area. If table is given, patch is blended by it,
+// shadow is drawn if shadowtable is given. Returns false if patch can't be
+// cached, caller has to draw it by posts then.
+// -----------------------------------------------------------------------------
+
+static boolean V_BlitCachedPatch (const int x, const int y, const patch_t *patch,
+                                  const int shift, const int clipw, const int cliph,
+                                  const byte *table, const byte *shadowtable)
+{
+    const patchcache_t *pc;
+    int row;
+
+    pc = PatchCacheGet(patch, dp_translation, shift, shadowtable != NULL);
+
+    if (pc == NULL)
+    {
+        return false;
+    }
+
+    for (row = 0 ; row < pc->height ; row++)
+    {
+        const int sy = y + row;
+        int s;
+
+        if (sy < 0)
+        {
+            continue;
+        }
+        if (sy >= cliph)
+        {
+            break;
+        }
+
+        for (s = pc->rowspans[row] ; s < pc->rowspans[row + 1] ; s++)
+        {
+            const pcspan_t *span = &pc->spans[s];
+            const byte *source;
+            byte *dest;
+            int x1 = x + span->x;
+            int x2 = x1 + span->length;
+            int count, i, j;
+
+            x1 = MAX(x1, 0);
+            x2 = MIN(x2, clipw);
+
+            if (x1 >= x2)
+            {
+                continue;
+            }
+
+            source = pc->pixels + row * pc->rowbytes + ((x1 - x) << shift);
+            dest = dest_screen + (sy << shift) * screenwidth + (x1 << shift);
+            count = (x2 - x1) << shift;
+
+            for (i = 0 ; i < (1 << shift) ; i++, dest += screenwidth)
+            {
+                if (span->kind == PCSPAN_SHADOW)
+                {
+                    for (j = 0 ; j < count ; j++)
+                        dest[j] = shadowtable[dest[j] << 8];
+                }
+                else if (table != NULL)
+                {
+                    for (j = 0 ; j < count ; j++)
+                        dest[j] = table[(dest[j] << 8) + source[j]];
+                }
+                else
+                {
+                    memcpy(dest, source, count);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
 // -----------------------------------------------------------------------------
 // V_DrawPatch
 // Masks a column based masked pic to the screen. 
@@ -215,6 +654,12 @@ void V_DrawPatch (int x, int y, const patch_t *patch, const byte *table)
 
     V_MarkRect(x, y, SHORT(patch->width), SHORT(patch->height));
 
+    // [JN] Use pre-scaled copy of the patch, if possible.
+    if (V_BlitCachedPatch(x, y, patch, hires, origwidth, ORIGHEIGHT, table, NULL))
+    {
+        return;
+    }
+
     col = 0;
     desttop1 = dest_screen + (y << hires) * screenwidth + x;
     desttop2 = dest_screen + ((y << hires) + quadres) * screenwidth + x;
@@ -960,6 +1405,13 @@ void V_DrawShadowedPatchDoom (int x, int y, const patch_t *patch)
     y -= SHORT(patch->topoffset);
     x -= SHORT(patch->leftoffset);
 
+    // [JN] Use pre-scaled copy of the patch, if possible.
+    if (V_BlitCachedPatch(x, y, patch, hires, origwidth, ORIGHEIGHT, NULL,
+                          draw_shadowed_text && !vanillaparm ? transtable60 : NULL))
+    {
+        return;
+    }
+
     col = 0;
     desttop1 = dest_screen + (y << hires) * screenwidth + x;
     desttop2 = dest_screen + ((y << hires) + quadres) * screenwidth + x;
@@ -1118,6 +1570,13 @@ void V_DrawShadowedPatchRaven (int x, int y, const patch_t *patch)
     y -= SHORT(patch->topoffset);
     x -= SHORT(patch->leftoffset);
 
+    // [JN] Use pre-scaled copy of the patch, if possible.
+    if (V_BlitCachedPatch(x, y, patch, hires, origwidth, ORIGHEIGHT, NULL,
+                          draw_shadowed_text && !vanillaparm ? tinttable : NULL))
+    {
+        return;
+    }
+
     col = 0;
     desttop1 = dest_screen + (y << hires) * screenwidth + x;
     desttop2 = dest_screen + ((y << hires) + quadres) * screenwidth + x;
@@ -1340,6 +1799,12 @@ void V_DrawPatchUnscaledHigh (int x, int y, const patch_t *patch, const byte *ta
 
     V_MarkRect(x, y, SHORT(patch->width), SHORT(patch->height));
 
+    // [JN] Use pre-scaled copy of the patch, if possible.
+    if (V_BlitCachedPatch(x, y, patch, 0, screenwidth, SCREENHEIGHT, table, NULL))
+    {
+        return;
+    }
+
     col = 0;
     desttop = dest_screen + y * screenwidth + x;
 
@@ -1425,6 +1890,13 @@ void V_DrawPatchUnscaledQuad (int x, int y, const patch_t *patch, const byte *ta
 
     V_MarkRect(x, y, SHORT(patch->width), SHORT(patch->height));
 
+    // [JN] Use pre-scaled copy of the patch, if possible.
+    if (V_BlitCachedPatch(x, y, patch, quadres, screenwidth >> quadres,
+                          SCREENHEIGHT >> quadres, table, NULL))
+    {
+        return;
+    }
+
     col = 0;
     desttop = dest_screen + (y << quadres) * screenwidth + x;
 
@@ -1868,6 +2340,9 @@ void V_Init (void)
     }
 
     fullscreenwidth = screenwidth * hires;
+
+    // [JN] Pre-scaled patches are no longer valid for new resolution.
+    V_FlushPatchCache();
 }
 
 // Set the buffer that the code draws to.
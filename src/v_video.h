@@ -63,6 +63,9 @@ void V_SetPatchClipCallback(vpatchclipfunc_t func);
 // Allocates buffer screens, call before R_Init.
 void V_Init (void);
 
+// [JN] Drops pre-scaled copies of patches.
+void V_FlushPatchCache (void);
+
 // Draw a block from the specified source screen to the screen.
 
 void V_CopyRect(int srcx, int srcy, byte *source,
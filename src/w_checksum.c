@@ -32,16 +32,27 @@
 
 static wad_file_t **open_wadfiles = NULL;
 static int num_open_wadfiles = 0;
+static int last_wadfile = 0;
 
 static int GetFileNumber(wad_file_t *handle)
 {
     int i;
     int result;
 
+    // [JN] Lumps of a file are mostly next to each other in the
+    // directory, so the file of the previous lump is checked first.
+
+    if (last_wadfile < num_open_wadfiles
+     && open_wadfiles[last_wadfile] == handle)
+    {
+        return last_wadfile;
+    }
+
     for (i = 0; i < num_open_wadfiles; ++i)
     {
         if (open_wadfiles[i] == handle)
         {
+            last_wadfile = i;
             return i;
         }
     }
@@ -55,19 +66,37 @@ static int GetFileNumber(wad_file_t *handle)
 
     result = num_open_wadfiles;
     ++num_open_wadfiles;
+    last_wadfile = result;
 
     return result;
 }
 
+static byte *PutInt32(byte *p, unsigned int val)
+{
+    p[0] = (val >> 24) & 0xff;
+    p[1] = (val >> 16) & 0xff;
+    p[2] = (val >> 8) & 0xff;
+    p[3] = val & 0xff;
+
+    return p + 4;
+}
+
+// [JN] The entry is put together in a buffer and hashed at once. The
+// bytes are the same as hashing the name string and the three integers
+// one by one, so the checksum still matches other versions.
+
 static void ChecksumAddLump(sha1_context_t *sha1_context, lumpinfo_t *lump)
 {
-    char buf[9];
+    byte buf[9 + 3 * 4];
+    byte *p;
+
+    M_StringCopy((char *) buf, lump->name, 9);
+    p = buf + strlen((char *) buf) + 1;
+    p = PutInt32(p, GetFileNumber(lump->wad_file));
+    p = PutInt32(p, lump->position);
+    p = PutInt32(p, lump->size);
 
-    M_StringCopy(buf, lump->name, sizeof(buf));
-    SHA1_UpdateString(sha1_context, buf);
-    SHA1_UpdateInt32(sha1_context, GetFileNumber(lump->wad_file));
-    SHA1_UpdateInt32(sha1_context, lump->position);
-    SHA1_UpdateInt32(sha1_context, lump->size);
+    SHA1_Update(sha1_context, buf, p - buf);
 }
 
 void W_Checksum(sha1_digest_t digest)
@@ -78,6 +107,7 @@ void W_Checksum(sha1_digest_t digest)
     SHA1_Init(&sha1_context);
 
     num_open_wadfiles = 0;
+    last_wadfile = 0;
 
     // Go through each entry in the WAD directory, adding information
     // about each entry to the SHA1 hash.
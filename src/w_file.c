@@ -50,19 +50,26 @@ static wad_file_class_t *wad_file_classes[] =
 
 wad_file_t *W_OpenFile(char *path)
 {
-    wad_file_t *result;
-    int i;
-
     //!
-    // Use the OS's virtual memory subsystem to map WAD files
-    // directly into memory.
+    // Do not use the OS's virtual memory subsystem to map WAD files
+    // directly into memory, read lumps with stdio instead.
     //
 
-    if (!M_CheckParm("-mmap"))
+    // [JN] Mappings are read-only, so mapping is safe to use by default.
+
+    if (M_CheckParm("-nommap"))
     {
         return stdc_wad_file.OpenFile(path);
     }
 
+    return W_OpenFileMapped(path);
+}
+
+wad_file_t *W_OpenFileMapped(char *path)
+{
+    wad_file_t *result;
+    int i;
+
     // Try all classes in order until we find one that works
 
     result = NULL;
@@ -91,3 +98,11 @@ size_t W_Read(wad_file_t *wad, unsigned int offset,
     return wad->file_class->Read(wad, offset, buffer, buffer_len);
 }
 
+void W_WillNeed(wad_file_t *wad, unsigned int offset, size_t length)
+{
+    if (wad->mapped != NULL && wad->file_class->WillNeed != NULL)
+    {
+        wad->file_class->WillNeed(wad, offset, length);
+    }
+}
+
@@ -39,6 +39,10 @@ typedef struct
     // provided buffer.  Returns the number of bytes read.
     size_t (*Read)(wad_file_t *file, unsigned int offset,
                    void *buffer, size_t buffer_len);
+
+    // [JN] Hint that the specified part of a mapped file will be read
+    // soon. May be NULL.
+    void (*WillNeed)(wad_file_t *file, unsigned int offset, size_t length);
 } wad_file_class_t;
 
 struct _wad_file_s
@@ -48,7 +52,8 @@ struct _wad_file_s
 
     // If this is NULL, the file cannot be mapped into memory.  If this
     // is non-NULL, it is a pointer to the mapped file.
-    byte *mapped;
+    // [JN] The mapping is read-only.
+    const byte *mapped;
 
     // Length of the file, in bytes.
     unsigned int length;
@@ -62,6 +67,11 @@ struct _wad_file_s
 
 wad_file_t *W_OpenFile(char *path);
 
+// [JN] Same as W_OpenFile, but tries to map the file into memory even
+// with "-nommap" parameter. Check "mapped" field of the result.
+
+wad_file_t *W_OpenFileMapped(char *path);
+
 // Close the specified WAD file.
 
 void W_CloseFile(wad_file_t *wad);
@@ -72,3 +82,8 @@ void W_CloseFile(wad_file_t *wad);
 
 size_t W_Read(wad_file_t *wad, unsigned int offset,
               void *buffer, size_t buffer_len);
+
+// [JN] Hint that the specified part of the file will be read soon.
+// Does nothing if the file is not mapped.
+
+void W_WillNeed(wad_file_t *wad, unsigned int offset, size_t length);
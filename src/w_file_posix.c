@@ -46,15 +46,14 @@ static void MapFile(posix_wad_file_t *wad, char *filename)
     int protection;
     int flags;
 
-    // Mapped area can be read and written to.  Ideally
-    // this should be read-only, as none of the Doom code should 
-    // change the WAD files after being read.  However, there may
-    // be code lurking in the source that does.
+    // [JN] Mapped area is read-only. Lumps which are written to are
+    // copied into the zone by W_CacheLumpNum, only W_CacheLumpNumRO
+    // returns pointers into the mapped area.
 
-    protection = PROT_READ|PROT_WRITE;
+    protection = PROT_READ;
 
-    // Writes to the mapped area result in private changes that are
-    // *not* written to disk.
+    // Private mapping, so the file can't change under us through
+    // this process.
 
     flags = MAP_PRIVATE;
 
@@ -62,6 +61,11 @@ static void MapFile(posix_wad_file_t *wad, char *filename)
                   protection, flags, 
                   wad->handle, 0);
 
+    if (result == MAP_FAILED)
+    {
+        result = NULL;
+    }
+
     wad->wad.mapped = result;
 
     if (result == NULL)
@@ -113,6 +117,11 @@ static void W_POSIX_CloseFile(wad_file_t *wad)
 
     // If mapped, unmap it.
 
+    if (posix_wad->wad.mapped != NULL)
+    {
+        munmap((void *) posix_wad->wad.mapped, posix_wad->wad.length);
+    }
+
     // Close the file
   
     close(posix_wad->handle);
@@ -162,11 +171,41 @@ size_t W_POSIX_Read(wad_file_t *wad, unsigned int offset,
 }
 
 
+// [JN] Ask the kernel to read the pages ahead.
+
+static void W_POSIX_WillNeed(wad_file_t *wad, unsigned int offset,
+                             size_t length)
+{
+    static long pagesize;
+    uintptr_t start, end;
+
+    if (pagesize <= 0)
+    {
+        pagesize = sysconf(_SC_PAGESIZE);
+
+        if (pagesize <= 0)
+        {
+            pagesize = 4096;
+        }
+    }
+
+    // madvise() needs a page-aligned start address.
+
+    start = (uintptr_t) (wad->mapped + offset) & ~(uintptr_t) (pagesize - 1);
+    end = (uintptr_t) (wad->mapped + offset + length);
+
+    if (end > start)
+    {
+        madvise((void *) start, end - start, MADV_WILLNEED);
+    }
+}
+
 wad_file_class_t posix_wad_file = 
 {
     W_POSIX_OpenFile,
     W_POSIX_CloseFile,
     W_POSIX_Read,
+    W_POSIX_WillNeed,
 };
 
 
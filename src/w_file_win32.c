@@ -50,7 +50,7 @@ static void MapFile(win32_wad_file_t *wad, char *filename)
 {
     wad->handle_map = CreateFileMapping(wad->handle,
                                         NULL,
-                                        PAGE_WRITECOPY,
+                                        PAGE_READONLY,
                                         0,
                                         0,
                                         NULL);
@@ -65,7 +65,7 @@ static void MapFile(win32_wad_file_t *wad, char *filename)
     }
 
     wad->wad.mapped = MapViewOfFile(wad->handle_map,
-                                    FILE_MAP_COPY,
+                                    FILE_MAP_READ,
                                     0, 0, 0);
 
     if (wad->wad.mapped == NULL)
@@ -203,6 +203,7 @@ wad_file_class_t win32_wad_file =
     W_Win32_OpenFile,
     W_Win32_CloseFile,
     W_Win32_Read,
+    NULL,
 };
 
 
@@ -46,6 +46,13 @@ typedef struct
 {
     lumpinfo_t **lumps;
     int numlumps;
+
+    // [JN] Hash table of lump names, built on the first search:
+    // hash_first[] holds the first lump of every chain, hash_next[]
+    // the lump following each one. Chains are in list order.
+    int *hash_first;
+    int *hash_next;
+    unsigned int hash_mask;
 } searchlist_t;
 
 typedef struct
@@ -53,6 +60,9 @@ typedef struct
     char sprname[4];
     char frame;
     lumpinfo_t *angle_lumps[8];
+
+    uint64_t key;   // [JN] Upper-cased sprite name, see W_LumpNameKey
+    int next;       // [JN] Next frame in hash chain, or -1
 } sprite_frame_t;
 
 static searchlist_t iwad;
@@ -68,18 +78,76 @@ static sprite_frame_t *sprite_frames;
 static int num_sprite_frames;
 static int sprite_frames_alloced;
 
+// [JN] Hash table of sprite frames, twice as large as the frames array.
+static int *sprite_frames_hash;
+
+// [JN] Points a search list to the given lumps, dropping its hash table.
+
+static void InitList(searchlist_t *list, lumpinfo_t **lumps, int numlumps)
+{
+    if (list->hash_first != NULL)
+    {
+        Z_Free(list->hash_first);
+        Z_Free(list->hash_next);
+        list->hash_first = NULL;
+        list->hash_next = NULL;
+    }
+
+    list->lumps = lumps;
+    list->numlumps = numlumps;
+}
+
+static void HashList(searchlist_t *list)
+{
+    unsigned int size = 1;
+    unsigned int i;
+    int n;
+
+    while (size < (unsigned int) list->numlumps)
+    {
+        size <<= 1;
+    }
+
+    list->hash_first = Z_Malloc(size * sizeof(int), PU_STATIC, NULL);
+    list->hash_next = Z_Malloc(MAX(list->numlumps, 1) * sizeof(int),
+                               PU_STATIC, NULL);
+    list->hash_mask = size - 1;
+
+    for (i = 0; i < size; ++i)
+    {
+        list->hash_first[i] = -1;
+    }
+
+    // Add backwards, so that the first lump of a name heads its chain.
+
+    for (n = list->numlumps - 1; n >= 0; --n)
+    {
+        const unsigned int hash =
+            W_LumpKeyHash(list->lumps[n]->key) & list->hash_mask;
+
+        list->hash_next[n] = list->hash_first[hash];
+        list->hash_first[hash] = n;
+    }
+}
+
 // Search in a list to find a lump with a particular name
-// Linear search (slow!)
 //
 // Returns -1 if not found
 
 static int FindInList(searchlist_t *list, char *name)
 {
+    const uint64_t key = W_LumpNameKey(name);
     int i;
 
-    for (i=0; i<list->numlumps; ++i)
+    if (list->hash_first == NULL)
+    {
+        HashList(list);
+    }
+
+    for (i = list->hash_first[W_LumpKeyHash(key) & list->hash_mask];
+         i != -1; i = list->hash_next[i])
     {
-        if (!strncasecmp(list->lumps[i]->name, name, 8))
+        if (list->lumps[i]->key == key)
             return i;
     }
 
@@ -92,7 +160,7 @@ static boolean SetupList(searchlist_t *list, searchlist_t *src_list,
 {
     int startlump, endlump;
 
-    list->numlumps = 0;
+    InitList(list, NULL, 0);
     startlump = FindInList(src_list, startname);
 
     if (startname2 != NULL && startlump < 0)
@@ -111,8 +179,8 @@ static boolean SetupList(searchlist_t *list, searchlist_t *src_list,
 
         if (endlump > startlump)
         {
-            list->lumps = src_list->lumps + startlump + 1;
-            list->numlumps = endlump - startlump - 1;
+            InitList(list, src_list->lumps + startlump + 1,
+                     endlump - startlump - 1);
             return true;
         }
     }
@@ -151,16 +219,43 @@ static void SetupLists(void)
 
 static void InitSpriteList(void)
 {
+    int i;
+
     if (sprite_frames == NULL)
     {
         sprite_frames_alloced = 128;
         sprite_frames = Z_Malloc(sizeof(*sprite_frames) * sprite_frames_alloced,
                                  PU_STATIC, NULL);
+        sprite_frames_hash = Z_Malloc(sizeof(int) * sprite_frames_alloced * 2,
+                                      PU_STATIC, NULL);
+    }
+
+    for (i = 0; i < sprite_frames_alloced * 2; ++i)
+    {
+        sprite_frames_hash[i] = -1;
     }
 
     num_sprite_frames = 0;
 }
 
+// [JN] Key of the sprite name, the first four characters of a lump name.
+
+static uint64_t SpriteNameKey(const char *name)
+{
+    char sprname[5];
+
+    memcpy(sprname, name, 4);
+    sprname[4] = '\0';
+
+    return W_LumpNameKey(sprname);
+}
+
+static unsigned int SpriteFrameHash(uint64_t key, int frame)
+{
+    return (W_LumpKeyHash(key) ^ (unsigned int) (frame * 0x9E3779B1u))
+         & (sprite_frames_alloced * 2 - 1);
+}
+
 static boolean ValidSpriteLumpName(char *name)
 {
     if (name[0] == '\0' || name[1] == '\0'
@@ -190,16 +285,20 @@ static boolean ValidSpriteLumpName(char *name)
 
 static sprite_frame_t *FindSpriteFrame(char *name, int frame)
 {
+    const uint64_t key = SpriteNameKey(name);
     sprite_frame_t *result;
+    unsigned int hash;
     int i;
 
     // Search the list and try to find the frame
 
-    for (i=0; i<num_sprite_frames; ++i)
+    hash = SpriteFrameHash(key, frame);
+
+    for (i = sprite_frames_hash[hash]; i != -1; i = sprite_frames[i].next)
     {
         sprite_frame_t *cur = &sprite_frames[i];
 
-        if (!strncasecmp(cur->sprname, name, 4) && cur->frame == frame)
+        if (cur->key == key && cur->frame == frame)
         {
             return cur;
         }
@@ -220,6 +319,28 @@ static sprite_frame_t *FindSpriteFrame(char *name, int frame)
         Z_Free(sprite_frames);
         sprite_frames_alloced *= 2;
         sprite_frames = newframes;
+
+        // [JN] Rebuild the hash table at the new size.
+
+        Z_Free(sprite_frames_hash);
+        sprite_frames_hash = Z_Malloc(sizeof(int) * sprite_frames_alloced * 2,
+                                      PU_STATIC, NULL);
+
+        for (i = 0; i < sprite_frames_alloced * 2; ++i)
+        {
+            sprite_frames_hash[i] = -1;
+        }
+
+        for (i = 0; i < num_sprite_frames; ++i)
+        {
+            const unsigned int h = SpriteFrameHash(sprite_frames[i].key,
+                                                   sprite_frames[i].frame);
+
+            sprite_frames[i].next = sprite_frames_hash[h];
+            sprite_frames_hash[h] = i;
+        }
+
+        hash = SpriteFrameHash(key, frame);
     }
 
     // Add to end of list
@@ -227,10 +348,14 @@ static sprite_frame_t *FindSpriteFrame(char *name, int frame)
     result = &sprite_frames[num_sprite_frames];
     memcpy(result->sprname, name, 4);
     result->frame = frame;
+    result->key = key;
 
     for (i=0; i<8; ++i)
         result->angle_lumps[i] = NULL;
 
+    result->next = sprite_frames_hash[hash];
+    sprite_frames_hash[hash] = num_sprite_frames;
+
     ++num_sprite_frames;
 
     return result;
@@ -589,11 +714,8 @@ void W_MergeFile(char *filename)
 
     // IWAD is at the start, PWAD was appended to the end
 
-    iwad.lumps = lumpinfo;
-    iwad.numlumps = old_numlumps;
-
-    pwad.lumps = lumpinfo + old_numlumps;
-    pwad.numlumps = numlumps - old_numlumps;
+    InitList(&iwad, lumpinfo, old_numlumps);
+    InitList(&pwad, lumpinfo + old_numlumps, numlumps - old_numlumps);
     
     // Setup sprite/flat lists
 
@@ -646,11 +768,8 @@ void W_NWTMergeFile(char *filename, int flags)
 
     // IWAD is at the start, PWAD was appended to the end
 
-    iwad.lumps = lumpinfo;
-    iwad.numlumps = old_numlumps;
-
-    pwad.lumps = lumpinfo + old_numlumps;
-    pwad.numlumps = numlumps - old_numlumps;
+    InitList(&iwad, lumpinfo, old_numlumps);
+    InitList(&pwad, lumpinfo + old_numlumps, numlumps - old_numlumps);
 
     // Setup sprite/flat lists
 
@@ -698,11 +817,8 @@ void W_NWTDashMerge(char *filename)
 
     // IWAD is at the start, PWAD was appended to the end
 
-    iwad.lumps = lumpinfo;
-    iwad.numlumps = old_numlumps;
-
-    pwad.lumps = lumpinfo + old_numlumps;
-    pwad.numlumps = numlumps - old_numlumps;
+    InitList(&iwad, lumpinfo, old_numlumps);
+    InitList(&pwad, lumpinfo + old_numlumps, numlumps - old_numlumps);
 
     // Setup sprite/flat lists
 
@@ -718,6 +834,7 @@ void W_NWTDashMerge(char *filename)
             // nwt -merge does.
 
             M_StringCopy(iwad_sprites.lumps[i]->name, "", 8);
+            iwad_sprites.lumps[i]->key = W_LumpNameKey("");
         }
     }
 
@@ -27,6 +27,7 @@
 
 #include "doomtype.h"
 
+#include "deh_str.h"
 #include "i_swap.h"
 #include "i_system.h"
 #include "i_video.h"
@@ -34,6 +35,7 @@
 #include "v_diskicon.h"
 #include "z_zone.h"
 #include "w_wad.h"
+#include "w_zip.h"
 #include "jn.h"
 
 typedef PACKED_STRUCT (
@@ -71,21 +73,61 @@ static lumpinfo_t *reloadlumps = NULL;
 static char *reloadname = NULL;
 static int reloadlump = -1;
 
-// Hash function used for lump names.
-unsigned int W_LumpNameHash(const char *s)
-{
-    // This is the djb2 string hash function, modded to work on strings
-    // that have a maximum length of 8.
+// [JN] Lump handles resolved in an older generation resolve again.
+static unsigned int lumphandle_generation = 1;
+
+// [JN] Lumps returned by W_CacheLumpNumRO from mapped files, and
+// statistics of them, printed at exit.
+static byte *mapped_used;
+static unsigned int mapped_used_size;
+static unsigned int stat_mapped_lookups;
+static unsigned int stat_mapped_lumps;
+static uint64_t stat_mapped_bytes;
+static boolean mapped_stats_registered;
+
+static void W_PrintMappedStats(void);
 
-    unsigned int result = 5381;
-    unsigned int i;
+// [JN] Names are compared and hashed as 8-byte integer keys, made once
+// for every lump when its file is added.
 
-    for (i=0; i < 8 && s[i] != '\0'; ++i)
+uint64_t W_LumpNameKey(const char *name)
+{
+    const uint64_t ones = UINT64_C(0x0101010101010101);
+    const uint64_t high = UINT64_C(0x8080808080808080);
+    char padded[8] = { 0 };
+    uint64_t key, low, above_a, above_z;
+    int i;
+
+    for (i = 0; i < 8 && name[i] != '\0'; ++i)
     {
-        result = ((result << 5) ^ result ) ^ toupper(s[i]);
+        padded[i] = name[i];
     }
 
-    return result;
+    memcpy(&key, padded, sizeof(key));
+
+    // Upper-case all eight bytes at once: the high bit of every byte of
+    // "above_a" is set if it is 'a' or above, of "above_z" if it is above
+    // 'z'. Bytes with their own high bit set are left as they are.
+
+    low = key & ~high;
+    above_a = low + ones * (0x80 - 'a');
+    above_z = low + ones * (0x80 - 'z' - 1);
+
+    return key - (((above_a & ~above_z & ~key) & high) >> 2);
+}
+
+unsigned int W_LumpKeyHash(uint64_t key)
+{
+    // Fibonacci hashing: the multiplication mixes every byte of the key
+    // into the upper bits of the result.
+
+    return (unsigned int) ((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32);
+}
+
+// Hash function used for lump names.
+unsigned int W_LumpNameHash(const char *s)
+{
+    return W_LumpKeyHash(W_LumpNameKey(s));
 }
 
 //
@@ -98,6 +140,8 @@ unsigned int W_LumpNameHash(const char *s)
 //  found (PWAD, if all required lumps are present).
 // Files with a .wad extension are wadlink files
 //  with multiple lumps.
+// [JN] Files with a .zip or .pk3 extension are archives,
+//  every file in them is a lump.
 // Other files are single lumps with the base filename
 //  for the lump name.
 
@@ -111,6 +155,7 @@ wad_file_t *W_AddFile (char *filename)
     filelump_t *fileinfo;
     filelump_t *filerover;
     lumpinfo_t *filelumps;
+    zip_lump_t *ziplumps = NULL;
     int numfilelumps;
 
     // If the filename begins with a ~, it indicates that we should use the
@@ -141,7 +186,10 @@ wad_file_t *W_AddFile (char *filename)
     }
 
     // Open the file and add to directory
-    wad_file = W_OpenFile(filename);
+    // [JN] Archives are mapped even with "-nommap", so stored lumps
+    // can be used in place.
+    wad_file = W_ZIP_IsArchive(filename) ? W_OpenFileMapped(filename)
+                                         : W_OpenFile(filename);
 
     if (wad_file == NULL)
     {
@@ -151,7 +199,28 @@ wad_file_t *W_AddFile (char *filename)
         return NULL;
     }
 
-    if (strcasecmp(filename+strlen(filename)-3 , "wad" ) )
+    if (wad_file->mapped != NULL && !mapped_stats_registered)
+    {
+        I_AtExit(W_PrintMappedStats, true);
+        mapped_stats_registered = true;
+    }
+
+    if (W_ZIP_IsArchive(filename))
+    {
+        // [JN] ZIP archive
+        fileinfo = NULL;
+        ziplumps = W_ZIP_ReadDirectory(wad_file, &numfilelumps);
+
+        if (ziplumps == NULL)
+        {
+            W_CloseFile(wad_file);
+            I_QuitWithError(english_language ?
+                            "%s is not a readable ZIP archive\n" :
+                            "Невозможно прочитать ZIP-архив %s\n",
+                            filename);
+        }
+    }
+    else if (strcasecmp(filename+strlen(filename)-3 , "wad" ) )
     {
 	// single lump file
 
@@ -240,16 +309,36 @@ wad_file_t *W_AddFile (char *filename)
     {
         lumpinfo_t *lump_p = &filelumps[i - startlump];
         lump_p->wad_file = wad_file;
-        lump_p->position = LONG(filerover->filepos);
-        lump_p->size = LONG(filerover->size);
         lump_p->cache = NULL;
-        strncpy(lump_p->name, filerover->name, 8);
-        lumpinfo[i] = lump_p;
 
-        ++filerover;
+        if (ziplumps != NULL)
+        {
+            const zip_lump_t *zip = &ziplumps[i - startlump];
+            lump_p->position = zip->position;
+            lump_p->size = zip->size;
+            lump_p->packed_size = zip->packed_size;
+            memcpy(lump_p->name, zip->name, 8);
+        }
+        else
+        {
+            lump_p->position = LONG(filerover->filepos);
+            lump_p->size = LONG(filerover->size);
+            strncpy(lump_p->name, filerover->name, 8);
+            ++filerover;
+        }
+
+        lump_p->key = W_LumpNameKey(lump_p->name);
+        lumpinfo[i] = lump_p;
     }
 
-    Z_Free(fileinfo);
+    if (ziplumps != NULL)
+    {
+        free(ziplumps);
+    }
+    else
+    {
+        Z_Free(fileinfo);
+    }
 
     if (lumphash != NULL)
     {
@@ -257,6 +346,8 @@ wad_file_t *W_AddFile (char *filename)
         lumphash = NULL;
     }
 
+    W_InvalidateLumpHandles();
+
     // If this is the reload file, we need to save some details about the
     // file so that we can close it later on when we do a reload.
     if (reloadname)
@@ -287,6 +378,7 @@ int W_NumLumps (void)
 
 lumpindex_t W_CheckNumForName(char* name)
 {
+    const uint64_t key = W_LumpNameKey(name);
     lumpindex_t i;
 
     // Do we have a hash table yet?
@@ -297,11 +389,11 @@ lumpindex_t W_CheckNumForName(char* name)
 
         // We do! Excellent.
 
-        hash = W_LumpNameHash(name) % numlumps;
+        hash = W_LumpKeyHash(key) % numlumps;
 
         for (i = lumphash[hash]; i != -1; i = lumpinfo[i]->next)
         {
-            if (!strncasecmp(lumpinfo[i]->name, name, 8))
+            if (lumpinfo[i]->key == key)
             {
                 return i;
             }
@@ -315,7 +407,7 @@ lumpindex_t W_CheckNumForName(char* name)
 
         for (i = numlumps - 1; i >= 0; --i)
         {
-            if (!strncasecmp(lumpinfo[i]->name, name, 8))
+            if (lumpinfo[i]->key == key)
             {
                 return i;
             }
@@ -329,18 +421,19 @@ lumpindex_t W_CheckNumForName(char* name)
 
 lumpindex_t W_CheckNumForNameRevers(char* name)
 {
+    const uint64_t key = W_LumpNameKey(name);
     lumpindex_t i;
 
     // Do we have a hash table yet?
     if(lumphash != NULL)
     {
         // We do! Excellent.
-        int hash = W_LumpNameHash(name) % numlumps;
+        int hash = W_LumpKeyHash(key) % numlumps;
         lumpindex_t lastFound = -1;
 
         for(i = lumphash[hash]; i != -1; i = lumpinfo[i]->next)
         {
-            if(!strncasecmp(lumpinfo[i]->name, name, 8))
+            if(lumpinfo[i]->key == key)
             {
                 lastFound = i;
             }
@@ -354,7 +447,7 @@ lumpindex_t W_CheckNumForNameRevers(char* name)
         // Scan forwards to find original lump
         for(i = 0; i < numlumps; i++)
         {
-            if(!strncasecmp(lumpinfo[i]->name, name, 8))
+            if(lumpinfo[i]->key == key)
             {
                 return i;
             }
@@ -373,10 +466,11 @@ lumpindex_t W_CheckNumForNameRevers(char* name)
 //
 int W_CheckMultipleLumps(char *name)
 {
+    const uint64_t key = W_LumpNameKey(name);
     int count = 0;
 
     for (lumpindex_t i = numlumps - 1; i >= 0; i--)
-        if (!strncasecmp(lumpinfo[i]->name, name, 8))
+        if (lumpinfo[i]->key == key)
             count++;
 
     return count;
@@ -421,11 +515,12 @@ lumpindex_t W_GetNumForNameRevers(char* name)
 
 lumpindex_t W_CheckNumForNameFromTo(const char *name, int from, int to)
 {
+    const uint64_t key = W_LumpNameKey(name);
     lumpindex_t i;
 
     for (i = from; i >= to; i--)
     {
-        if (!strncasecmp(lumpinfo[i]->name, name, 8))
+        if (lumpinfo[i]->key == key)
         {
             return i;
         }
@@ -436,6 +531,7 @@ lumpindex_t W_CheckNumForNameFromTo(const char *name, int from, int to)
 
 lumpindex_t W_CheckNextNum(lumpindex_t lumpIndex)
 {
+    const uint64_t key = lumpinfo[lumpIndex]->key;
     lumpindex_t i;
 
     // Do we have a hash table yet?
@@ -444,7 +540,7 @@ lumpindex_t W_CheckNextNum(lumpindex_t lumpIndex)
         // We do! Excellent.
         for(i = lumpinfo[lumpIndex]->prev; i != -1; i = lumpinfo[i]->prev)
         {
-            if(!strncasecmp(lumpinfo[i]->name, lumpinfo[lumpIndex]->name, 8))
+            if(lumpinfo[i]->key == key)
             {
                 return i;
             }
@@ -456,7 +552,7 @@ lumpindex_t W_CheckNextNum(lumpindex_t lumpIndex)
         // Scan forwards to find nex loaded lump
         for(i = lumpIndex + 1; i < numlumps; i++)
         {
-            if(!strncasecmp(lumpinfo[i]->name, lumpinfo[lumpIndex]->name, 8))
+            if(lumpinfo[i]->key == key)
             {
                 return i;
             }
@@ -500,6 +596,29 @@ void W_ReadLump(lumpindex_t lump, void *dest)
 
     V_BeginRead(l->size);
 
+    if (l->packed_size != 0)
+    {
+        // [JN] Deflated lump in a ZIP archive.
+        if (!W_ZIP_Inflate(l->wad_file, l->position, l->packed_size,
+                           dest, l->size))
+        {
+            I_QuitWithError(english_language ?
+                            "W_ReadLump: failed to inflate lump %i" :
+                            "W_ReadLump: ошибка распаковки блока %i",
+                            lump);
+        }
+        return;
+    }
+
+    // [JN] Copy from the mapping instead of reading the file again.
+
+    if (l->wad_file->mapped != NULL
+    &&  (uint64_t) l->position + l->size <= l->wad_file->length)
+    {
+        memcpy(dest, l->wad_file->mapped + l->position, l->size);
+        return;
+    }
+
     c = W_Read(l->wad_file, l->position, dest, l->size);
 
     if(c < l->size)
@@ -538,23 +657,23 @@ void *W_CacheLumpNum(lumpindex_t lumpnum, int tag)
 
     lump = lumpinfo[lumpnum];
 
-    // Get the pointer to return.  If the lump is in a memory-mapped
-    // file, we can just return a pointer to within the memory-mapped
-    // region.  If the lump is in an ordinary file, we may already
-    // have it cached; otherwise, load it into memory.
+    // Get the pointer to return.  We may already have it cached;
+    // otherwise, load it into memory.
 
-    if (lump->wad_file->mapped != NULL)
-    {
-        // Memory mapped file, return from the mmapped region.
+    // [JN] Mapped files are read-only, so lumps in them are copied into
+    // the cache as well. Use W_CacheLumpNumRO to read them in place.
 
-        result = lump->wad_file->mapped + lump->position;
-    }
-    else if (lump->cache != NULL)
+    if (lump->cache != NULL)
     {
         // Already cached, so just switch the zone tag.
 
         result = lump->cache;
         Z_ChangeTag(lump->cache, tag);
+
+        if (lump->packed_size != 0)
+        {
+            W_ZIP_CacheHit();
+        }
     }
     else
     {
@@ -578,6 +697,118 @@ void *W_CacheLumpName(char *name, int tag)
     return W_CacheLumpNum(W_GetNumForName(name), tag);
 }
 
+//
+// [JN] W_CacheLumpNumRO
+//
+// Same as W_CacheLumpNum for lumps which are never written to. Lumps
+// stored in a mapped file are returned from the mapping, so they take
+// no zone memory and are shared with the page cache (and with other
+// running copies of the game using the same IWAD).
+//
+
+const void *W_CacheLumpNumRO(lumpindex_t lumpnum, int tag)
+{
+    lumpinfo_t *lump;
+
+    if((unsigned)lumpnum >= numlumps)
+    {
+        I_QuitWithError("W_CacheLumpNumRO: %i >= numlumps", lumpnum);
+    }
+
+    lump = lumpinfo[lumpnum];
+
+    if (lump->wad_file->mapped == NULL || lump->packed_size != 0)
+    {
+        return W_CacheLumpNum(lumpnum, tag);
+    }
+
+    // Count every lump once for the statistics.
+
+    if ((unsigned)lumpnum >= mapped_used_size)
+    {
+        mapped_used = I_Realloc(mapped_used, numlumps);
+        memset(mapped_used + mapped_used_size, 0, numlumps - mapped_used_size);
+        mapped_used_size = numlumps;
+    }
+
+    if (!mapped_used[lumpnum])
+    {
+        mapped_used[lumpnum] = true;
+        stat_mapped_lumps++;
+        stat_mapped_bytes += lump->size;
+    }
+
+    stat_mapped_lookups++;
+
+    return lump->wad_file->mapped + lump->position;
+}
+
+const void *W_CacheLumpNameRO(char *name, int tag)
+{
+    return W_CacheLumpNumRO(W_GetNumForName(name), tag);
+}
+
+//
+// [JN] W_WillNeedLump
+//
+// Lumps in mapped files are read ahead by the OS, other lumps are
+// loaded into the cache.
+//
+
+void W_WillNeedLump(lumpindex_t lumpnum)
+{
+    lumpinfo_t *lump;
+
+    if((unsigned)lumpnum >= numlumps)
+    {
+        return;
+    }
+
+    lump = lumpinfo[lumpnum];
+
+    if (lump->wad_file->mapped != NULL && lump->packed_size == 0)
+    {
+        W_WillNeed(lump->wad_file, lump->position, lump->size);
+    }
+    else if (lump->cache == NULL)
+    {
+        W_CacheLumpNum(lumpnum, PU_CACHE);
+    }
+}
+
+static void W_PrintMappedStats(void)
+{
+    unsigned int files = 0;
+    uint64_t bytes = 0;
+    lumpindex_t i;
+
+    for (i = 0; i < numlumps; ++i)
+    {
+        // The first lump of every file is enough to count it.
+
+        if (lumpinfo[i]->wad_file->mapped != NULL
+        && (i == 0 || lumpinfo[i - 1]->wad_file != lumpinfo[i]->wad_file))
+        {
+            files++;
+            bytes += lumpinfo[i]->wad_file->length;
+        }
+    }
+
+    if (stat_mapped_lookups == 0)
+    {
+        return;
+    }
+
+    printf(english_language ?
+           "W_PrintMappedStats: %u files mapped, %.1f MiB.\n" :
+           "W_PrintMappedStats: %u файлов отображено, %.1f МиБ.\n",
+           files, bytes / (1024.0 * 1024.0));
+    printf(english_language ?
+           "  read-only lumps: %u used, %.1f MiB kept out of the zone\n" :
+           "  блоки только для чтения: %u использовано, %.1f МиБ вне зоны\n",
+           stat_mapped_lumps, stat_mapped_bytes / (1024.0 * 1024.0));
+}
+
 // 
 // Release a lump back to the cache, so that it can be reused later 
 // without having to read from disk again, or alternatively, discarded
@@ -599,9 +830,10 @@ void W_ReleaseLumpNum(lumpindex_t lumpnum)
 
     lump = lumpinfo[lumpnum];
 
-    if (lump->wad_file->mapped != NULL)
+    if (lump->cache == NULL)
     {
-        // Memory-mapped file, so nothing needs to be done here.
+        // [JN] Read-only lump returned from a memory-mapped file,
+        // so nothing needs to be done here.
     }
     else
     {
@@ -614,6 +846,59 @@ void W_ReleaseLumpName(char *name)
     W_ReleaseLumpNum(W_GetNumForName(name));
 }
 
+//
+// [JN] W_ReleaseLumpNumRO
+// Releases a lump returned by W_CacheLumpNumRO. A pointer into the
+// mapping holds no zone block, so there is nothing to release; the zone
+// copy of the same lump may belong to another caller and must be kept.
+//
+
+void W_ReleaseLumpNumRO(lumpindex_t lumpnum)
+{
+    lumpinfo_t *lump;
+
+    if ((unsigned)lumpnum >= numlumps)
+    {
+        I_QuitWithError("W_ReleaseLumpNumRO: %i >= numlumps", lumpnum);
+    }
+
+    lump = lumpinfo[lumpnum];
+
+    if (lump->wad_file->mapped == NULL || lump->packed_size != 0)
+    {
+        W_ReleaseLumpNum(lumpnum);
+    }
+}
+
+//
+// [JN] Lump handles.
+//
+// Drawers call W_CacheLumpName(DEH_String(...)) for the same lumps every
+// frame, which hashes the name twice. A handle keeps the lump number
+// found the first time, until the set of lumps or replacements changes.
+//
+
+lumpindex_t W_GetNumForHandle(lumphandle_t *handle)
+{
+    if (handle->generation != lumphandle_generation)
+    {
+        handle->lumpnum = W_GetNumForName(DEH_String(handle->name));
+        handle->generation = lumphandle_generation;
+    }
+
+    return handle->lumpnum;
+}
+
+void *W_CacheLumpHandle(lumphandle_t *handle, int tag)
+{
+    return W_CacheLumpNum(W_GetNumForHandle(handle), tag);
+}
+
+void W_InvalidateLumpHandles(void)
+{
+    ++lumphandle_generation;
+}
+
 #if 0
 
 //
@@ -706,7 +991,7 @@ void W_GenerateHashTable(void)
         {
             unsigned int hash;
 
-            hash = W_LumpNameHash(lumpinfo[i]->name) % numlumps;
+            hash = W_LumpKeyHash(lumpinfo[i]->key) % numlumps;
 
             // Hook into the hash table
 
@@ -718,6 +1003,9 @@ void W_GenerateHashTable(void)
         }
     }
 
+    // Lumps may have been reordered by merging.
+    W_InvalidateLumpHandles();
+
     // All done!
 }
 
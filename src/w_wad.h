@@ -40,9 +40,11 @@ typedef int lumpindex_t;
 struct lumpinfo_s
 {
     char	name[8];
+    uint64_t    key;        // [JN] Upper-cased name, see W_LumpNameKey
     wad_file_t *wad_file;
     int		position;
     int		size;
+    int         packed_size;    // [JN] Size of deflated data in a ZIP, 0 if stored
     void       *cache;
 
     // Used for hash table lookups
@@ -86,9 +88,69 @@ void W_ReadLump(lumpindex_t lump, void *dest);
 void *W_CacheLumpNum(lumpindex_t lumpnum, int tag);
 void *W_CacheLumpName(char *name, int tag);
 
+/**
+ * Same as W_CacheLumpNum for lumps which are never written to, such as
+ * patches, flats, sounds and music. Lumps in mapped files are returned
+ * from the read-only mapping without a copy in the zone. Release them
+ * with W_ReleaseLumpNumRO, not W_ReleaseLumpNum.
+ */
+const void *W_CacheLumpNumRO(lumpindex_t lumpnum, int tag);
+const void *W_CacheLumpNameRO(char *name, int tag);
+
+/**
+ * Hints that the lump will be read soon. Lumps in mapped files are read
+ * ahead by the OS, other lumps are loaded into the cache as PU_CACHE.
+ */
+void W_WillNeedLump(lumpindex_t lumpnum);
+
 void W_GenerateHashTable(void);
 
 extern unsigned int W_LumpNameHash(const char *s);
 
+/**
+ * Returns the name upper-cased and zero-padded to 8 bytes as one integer.
+ * Two names are equal, ignoring case, if their keys are equal.
+ * The name ends at the first NUL or after 8 characters.
+ */
+uint64_t W_LumpNameKey(const char *name);
+
+/**
+ * Hash function used for lump and texture names, same as W_LumpNameHash
+ * for a name of the given key.
+ */
+unsigned int W_LumpKeyHash(uint64_t key);
+
 void W_ReleaseLumpNum(lumpindex_t lumpnum);
 void W_ReleaseLumpName(char *name);
+void W_ReleaseLumpNumRO(lumpindex_t lumpnum);
+
+/**
+ * Lump which is looked up by name only once, for drawers which use the
+ * same lumps every frame. Declare it static, initialized with LUMPHANDLE.
+ * The name is passed through DEH_String when the handle is resolved.
+ */
+typedef struct
+{
+    char *name;
+    lumpindex_t lumpnum;
+    unsigned int generation;    // Set of lumps the handle was resolved in
+} lumphandle_t;
+
+#define LUMPHANDLE(name) { (name), -1, 0 }
+
+/**
+ * Returns lump number of the handle, resolving it first if the WAD
+ * directory or string replacements have changed. Bombs out if not found.
+ */
+lumpindex_t W_GetNumForHandle(lumphandle_t *handle);
+
+/**
+ * Same as W_CacheLumpName for the handle's lump.
+ */
+void *W_CacheLumpHandle(lumphandle_t *handle, int tag);
+
+/**
+ * Makes all lump handles resolve again on their next use. Called when
+ * the WAD directory or string replacements change.
+ */
+void W_InvalidateLumpHandles(void);
@@ -0,0 +1,363 @@
+//
+// Copyright(C) 2016-2025 Julian Nechaevsky
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	ZIP (PK3) archives as lump containers.
+//
+//  Only the central directory is read when an archive is added. Stored
+//  entries are read like WAD lumps, straight from the mapped archive if
+//  it could be mapped. Deflated entries are inflated when a lump is first
+//  cached; the result lives in the zone memory like any other cached lump,
+//  so released lumps are purged when the zone needs the space.
+//
+
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "miniz.h"
+
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_misc.h"
+#include "w_zip.h"
+#include "jn.h"
+
+// Local file header, which precedes entry data:
+#define LOCAL_HEADER_SIZE       30
+#define LOCAL_HEADER_SIGNATURE  0x04034b50
+#define LOCAL_HEADER_NAME_LEN   26
+#define LOCAL_HEADER_EXTRA_LEN  28
+
+// Entry compression methods:
+#define METHOD_STORED   0
+#define METHOD_DEFLATED 8
+
+typedef enum
+{
+    GROUP_NORMAL,
+    GROUP_FLATS,
+    GROUP_SPRITES,
+    NUMGROUPS
+} zip_group_t;
+
+// Marker lumps around each group, as in PWADs:
+static const char *group_markers[NUMGROUPS][2] =
+{
+    { NULL, NULL },
+    { "FF_START", "FF_END" },
+    { "SS_START", "SS_END" },
+};
+
+// Statistics, printed at exit.
+static boolean stats_registered;
+static unsigned int stat_archives;
+static unsigned int stat_entries;
+static unsigned int stat_inflated;
+static unsigned int stat_hits;
+static uint64_t stat_packed_bytes;
+static uint64_t stat_inflated_bytes;
+static uint64_t stat_inflate_us;
+
+
+static unsigned int ReadLE16(const byte *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned int ReadLE32(const byte *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+boolean W_ZIP_IsArchive(const char *filename)
+{
+    const size_t length = strlen(filename);
+
+    return length > 4
+        && (!strcasecmp(filename + length - 4, ".zip")
+        ||  !strcasecmp(filename + length - 4, ".pk3"));
+}
+
+// Directory an entry goes to, from the first component of its path.
+
+static zip_group_t GroupForPath(const char *path)
+{
+    if (!strncasecmp(path, "flats/", 6))
+    {
+        return GROUP_FLATS;
+    }
+    if (!strncasecmp(path, "sprites/", 8))
+    {
+        return GROUP_SPRITES;
+    }
+
+    return GROUP_NORMAL;
+}
+
+// Lump name of an entry: its base name without extension, upper-cased.
+
+static void LumpNameForPath(const char *path, char *name)
+{
+    const char *base = strrchr(path, '/');
+    int length = 0;
+
+    base = base ? base + 1 : path;
+    memset(name, 0, 8);
+
+    while (*base != '\0' && *base != '.' && length < 8)
+    {
+        name[length++] = toupper((int) *base++);
+    }
+}
+
+// Offset of entry data, which follows the local header. Its name and
+// extra field may differ in length from the central directory ones.
+
+static boolean DataPosition(wad_file_t *wad_file, mz_uint64 header_ofs,
+                            unsigned int *position)
+{
+    byte header[LOCAL_HEADER_SIZE];
+    mz_uint64 result;
+
+    if (header_ofs + LOCAL_HEADER_SIZE > wad_file->length)
+    {
+        return false;
+    }
+
+    if (wad_file->mapped != NULL)
+    {
+        memcpy(header, wad_file->mapped + header_ofs, LOCAL_HEADER_SIZE);
+    }
+    else if (W_Read(wad_file, (unsigned int) header_ofs,
+                    header, LOCAL_HEADER_SIZE) != LOCAL_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    if (ReadLE32(header) != LOCAL_HEADER_SIGNATURE)
+    {
+        return false;
+    }
+
+    result = header_ofs + LOCAL_HEADER_SIZE
+           + ReadLE16(header + LOCAL_HEADER_NAME_LEN)
+           + ReadLE16(header + LOCAL_HEADER_EXTRA_LEN);
+
+    if (result > wad_file->length)
+    {
+        return false;
+    }
+
+    *position = (unsigned int) result;
+    return true;
+}
+
+static void W_ZIP_PrintStats(void)
+{
+    printf(english_language ?
+           "W_ZIP_PrintStats: %u archives, %u entries.\n" :
+           "W_ZIP_PrintStats: %u архивов, %u файлов.\n",
+           stat_archives, stat_entries);
+    printf(english_language ?
+           "  inflated: %u lumps, %.1f KiB to %.1f KiB in %.1f ms\n" :
+           "  распаковано: %u блоков, %.1f КиБ в %.1f КиБ за %.1f мс\n",
+           stat_inflated, stat_packed_bytes / 1024.0,
+           stat_inflated_bytes / 1024.0, stat_inflate_us / 1000.0);
+    printf(english_language ?
+           "  cache: %u hits, %.1f%% of lookups\n" :
+           "  кэш: %u попаданий, %.1f%% обращений\n",
+           stat_hits, stat_hits + stat_inflated ?
+           100.0 * stat_hits / (stat_hits + stat_inflated) : 0.0);
+}
+
+// Adds a marker lump.
+
+static void AddMarker(zip_lump_t *lump, const char *name)
+{
+    memset(lump, 0, sizeof(*lump));
+    strncpy(lump->name, name, 8);
+}
+
+zip_lump_t *W_ZIP_ReadDirectory(wad_file_t *wad_file, int *numlumps)
+{
+    mz_zip_archive zip;
+    mz_zip_archive_file_stat stat;
+    zip_lump_t *entries;
+    zip_lump_t *lumps;
+    zip_group_t *groups;
+    int group_count[NUMGROUPS] = { 0 };
+    int numentries, count, g, i, n;
+
+    memset(&zip, 0, sizeof(zip));
+
+    if (wad_file->mapped != NULL)
+    {
+        if (!mz_zip_reader_init_mem(&zip, wad_file->mapped,
+                                    wad_file->length, 0))
+        {
+            return NULL;
+        }
+    }
+    else if (!mz_zip_reader_init_file(&zip, wad_file->path, 0))
+    {
+        return NULL;
+    }
+
+    numentries = mz_zip_reader_get_num_files(&zip);
+
+    // Entries are collected in archive order, then copied out group by
+    // group, with room for two markers around each group.
+
+    entries = malloc((numentries + 1) * sizeof(*entries));
+    groups = malloc((numentries + 1) * sizeof(*groups));
+    lumps = malloc((numentries + 2 * NUMGROUPS) * sizeof(*lumps));
+
+    if (entries == NULL || groups == NULL || lumps == NULL)
+    {
+        free(entries);
+        free(groups);
+        free(lumps);
+        mz_zip_reader_end(&zip);
+        return NULL;
+    }
+
+    count = 0;
+
+    for (i = 0; i < numentries; ++i)
+    {
+        zip_lump_t *entry = &entries[count];
+
+        if (!mz_zip_reader_file_stat(&zip, i, &stat) || stat.m_is_directory)
+        {
+            continue;
+        }
+
+        if (!stat.m_is_supported || stat.m_is_encrypted
+         || (stat.m_method != METHOD_STORED && stat.m_method != METHOD_DEFLATED)
+         || stat.m_uncomp_size > INT_MAX || stat.m_comp_size > INT_MAX
+         || !DataPosition(wad_file, stat.m_local_header_ofs, &entry->position)
+         || entry->position + stat.m_comp_size > wad_file->length)
+        {
+            printf(english_language ?
+                   " skipping unsupported entry %s in %s\n" :
+                   " пропуск неподдерживаемого файла %s в %s\n",
+                   stat.m_filename, wad_file->path);
+            continue;
+        }
+
+        LumpNameForPath(stat.m_filename, entry->name);
+        entry->size = (unsigned int) stat.m_uncomp_size;
+        entry->packed_size = stat.m_method == METHOD_DEFLATED ?
+                             (unsigned int) stat.m_comp_size : 0;
+
+        groups[count] = GroupForPath(stat.m_filename);
+        group_count[groups[count]]++;
+        count++;
+    }
+
+    mz_zip_reader_end(&zip);
+
+    n = 0;
+
+    for (g = GROUP_NORMAL; g < NUMGROUPS; ++g)
+    {
+        if (group_count[g] == 0)
+        {
+            continue;
+        }
+
+        if (group_markers[g][0] != NULL)
+        {
+            AddMarker(&lumps[n++], group_markers[g][0]);
+        }
+
+        for (i = 0; i < count; ++i)
+        {
+            if (groups[i] == (zip_group_t) g)
+            {
+                lumps[n++] = entries[i];
+            }
+        }
+
+        if (group_markers[g][1] != NULL)
+        {
+            AddMarker(&lumps[n++], group_markers[g][1]);
+        }
+    }
+
+    free(entries);
+    free(groups);
+
+    if (!stats_registered)
+    {
+        I_AtExit(W_ZIP_PrintStats, true);
+        stats_registered = true;
+    }
+
+    stat_archives++;
+    stat_entries += numentries;
+
+    *numlumps = n;
+    return lumps;
+}
+
+boolean W_ZIP_Inflate(wad_file_t *wad_file, unsigned int position,
+                      unsigned int packed_size, void *dest, unsigned int size)
+{
+    const uint64_t start = I_GetTimeUS();
+    const byte *packed;
+    size_t result;
+
+    if (wad_file->mapped != NULL)
+    {
+        packed = wad_file->mapped + position;
+    }
+    else
+    {
+        byte *buffer = malloc(packed_size);
+
+        if (buffer == NULL
+         || W_Read(wad_file, position, buffer, packed_size) != packed_size)
+        {
+            free(buffer);
+            return false;
+        }
+
+        packed = buffer;
+    }
+
+    // Entries hold raw deflate data, without a zlib header.
+
+    result = tinfl_decompress_mem_to_mem(dest, size, packed, packed_size, 0);
+
+    if (wad_file->mapped == NULL)
+    {
+        free((void *) packed);
+    }
+
+    stat_inflated++;
+    stat_packed_bytes += packed_size;
+    stat_inflated_bytes += size;
+    stat_inflate_us += I_GetTimeUS() - start;
+
+    return result == size;
+}
+
+void W_ZIP_CacheHit(void)
+{
+    stat_hits++;
+}
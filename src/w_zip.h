@@ -0,0 +1,58 @@
+//
+// Copyright(C) 2016-2025 Julian Nechaevsky
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	ZIP (PK3) archives as lump containers.
+//
+
+
+#pragma once
+
+#include "doomtype.h"
+#include "w_file.h"
+
+typedef struct
+{
+    char name[8];
+    unsigned int position;      // Offset of the entry data in the archive
+    unsigned int size;          // Size of the lump
+    unsigned int packed_size;   // Size of deflated data, 0 if stored
+} zip_lump_t;
+
+/**
+ * Returns true if the file name has a ZIP or PK3 extension.
+ */
+boolean W_ZIP_IsArchive(const char *filename);
+
+/**
+ * Reads the central directory of an archive. Every file in the archive
+ * becomes a lump named after its base name. Files in the "flats" and
+ * "sprites" directories are put between FF_START/FF_END and
+ * SS_START/SS_END marker lumps, the way PWADs hold them.
+ * @param numlumps receives the number of lumps
+ * @return array to be freed with free(), or NULL if the file is not a
+ *         readable archive
+ */
+zip_lump_t *W_ZIP_ReadDirectory(wad_file_t *wad_file, int *numlumps);
+
+/**
+ * Inflates a deflated lump into the buffer, which must be "size" bytes.
+ * @return false if the data is damaged
+ */
+boolean W_ZIP_Inflate(wad_file_t *wad_file, unsigned int position,
+                      unsigned int packed_size, void *dest, unsigned int size);
+
+/**
+ * Counts a deflated lump found already inflated in the zone cache.
+ */
+void W_ZIP_CacheHit(void);
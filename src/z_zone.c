@@ -46,6 +46,7 @@
 typedef struct memblock_s
 {
     int			size;	// including the header and possibly tiny fragments
+    unsigned int	serial;	// [JN] allocation number, see Z_GetSerial
     void**		user;
     int			tag;	// PU_FREE if this is free
     int			id;	// should be ZONEID
@@ -69,6 +70,13 @@ typedef struct
 
 
 static memzone_t *mainzone;
+
+// [JN] Every zone allocated so far, as Z_Init may be called again to
+// add a bigger zone, and the number of the last allocation made.
+#define MAXZONES 32
+static memzone_t *zones[MAXZONES];
+static int numzones;
+static unsigned int last_serial;
 static boolean zero_on_free;
 static boolean scan_on_free;
 
@@ -110,6 +118,11 @@ void Z_Init (void)
     mainzone = (memzone_t *)I_ZoneBase (&size);
     mainzone->size = size;
 
+    if (numzones < MAXZONES)
+    {
+        zones[numzones++] = mainzone;
+    }
+
     // set the entire zone to one free block
     mainzone->blocklist.next =
 	mainzone->blocklist.prev =
@@ -364,6 +377,13 @@ Z_Malloc
     mainzone->rover = base->next;	
 	
     base->id = ZONEID;
+
+    // [JN] Zero means "not a zone block" to Z_GetSerial.
+    if (++last_serial == 0)
+    {
+        last_serial = 1;
+    }
+    base->serial = last_serial;
    
     return result;
 }
@@ -599,3 +619,36 @@ unsigned int Z_ZoneSize(void)
     return mainzone->size;
 }
 
+//
+// [JN] Z_GetSerial
+// Returns the allocation number of a block returned by Z_Malloc, which
+// tells a reallocated block at the same address from the old one.
+// Returns 0 if ptr is not the start of an allocated zone block.
+//
+unsigned int Z_GetSerial(const void *ptr)
+{
+    const byte *p = ptr;
+    int i;
+
+    for (i = 0; i < numzones; ++i)
+    {
+        const byte *first = (const byte *) zones[i] + sizeof(memzone_t);
+
+        if (p >= first + sizeof(memblock_t)
+         && p < (const byte *) zones[i] + zones[i]->size)
+        {
+            const memblock_t *block =
+                (const memblock_t *) (p - sizeof(memblock_t));
+
+            if (block->id == ZONEID && block->tag != PU_FREE)
+            {
+                return block->serial;
+            }
+
+            return 0;
+        }
+    }
+
+    return 0;
+}
+